@@ -0,0 +1,86 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require "json"
+
+module ZSTDS
+  module Bench
+    # Deterministic corpora generated locally, same seed provides same data on any machine.
+    module Corpus
+      SEED = 2019
+
+      WORDS = %w[
+        archive block buffer chunk compress context data decompress dictionary entropy frame huffman
+        level literal match offset output ratio sequence source stream symbol table window zstd
+      ]
+      .freeze
+
+      PUNCTUATIONS = [" ", " ", " ", " ", ", ", ". ", "\n"].freeze
+
+      def self.text(size)
+        random = ::Random.new SEED
+        result = ::String.new :capacity => size
+
+        result << WORDS[random.rand(WORDS.length)] << PUNCTUATIONS[random.rand(PUNCTUATIONS.length)] while
+          result.bytesize < size
+
+        result.byteslice 0, size
+      end
+
+      def self.json(size)
+        random = ::Random.new SEED
+        result = ::String.new :capacity => size
+        index  = 0
+
+        while result.bytesize < size
+          record = {
+            "id"     => index,
+            "name"   => "#{WORDS[random.rand(WORDS.length)]}-#{random.rand(1000)}",
+            "level"  => random.rand(-5..22),
+            "ratio"  => random.rand.round(4),
+            "tags"   => Array.new(random.rand(4)) { WORDS[random.rand(WORDS.length)] },
+            "active" => random.rand(2).zero?
+          }
+
+          result << ::JSON.generate(record) << "\n"
+          index += 1
+        end
+
+        result.byteslice 0, size
+      end
+
+      # Binary data looks like table of integers with small deltas.
+      def self.binary(size)
+        random = ::Random.new SEED
+        values = []
+        value  = 0
+
+        while values.length * 4 < size
+          value += random.rand(-16..64)
+          values << (value & 0xFFFFFFFF)
+        end
+
+        values.pack("L<*").byteslice 0, size
+      end
+
+      def self.incompressible(size)
+        ::Random.new(SEED).bytes size
+      end
+
+      TYPES = %i[text json binary incompressible].freeze
+
+      def self.generate(size)
+        TYPES.to_h { |type| [type, send(type, size).force_encoding(::Encoding::BINARY).freeze] }
+      end
+
+      # Samples for dictionary training are small records cut from corpus.
+      def self.samples(source, sample_size, samples_length)
+        random = ::Random.new SEED
+
+        Array.new samples_length do
+          source.byteslice random.rand(source.bytesize - sample_size), sample_size
+        end
+      end
+    end
+  end
+end
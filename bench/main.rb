@@ -0,0 +1,82 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require "fileutils"
+require "json"
+require "time"
+
+require_relative "suites"
+
+# Benchmark settings can be changed using environment variables:
+#   BENCH_SIZE       - bytesize of each corpus (1 MB by default),
+#   BENCH_ITERATIONS - measured iterations for each variant (5 by default),
+#   BENCH_SUITES     - comma separated list of suites (string,file,stream,dictionary by default),
+#   BENCH_CORPORA    - comma separated list of corpora (text,json,binary,incompressible by default),
+#   BENCH_OUTPUT     - path of JSON results (tmp/bench.json by default).
+
+module ZSTDS
+  module Bench
+    BASE_PATH = ::File.expand_path(::File.join(::File.dirname(__FILE__), "..")).freeze
+
+    def self.get_list(name, values)
+      value = ENV.fetch name, nil
+      return values if value.nil? || value.empty?
+
+      list = value.split(",").map(&:to_sym)
+      invalid_list = list - values
+      raise ArgumentError, "invalid #{name}: #{invalid_list.join(', ')}" unless invalid_list.empty?
+
+      list
+    end
+
+    def self.run
+      size       = Integer ENV.fetch("BENCH_SIZE", 1 << 20)
+      iterations = Integer ENV.fetch("BENCH_ITERATIONS", 5)
+      suites     = get_list "BENCH_SUITES", Suites::NAMES
+      types      = get_list "BENCH_CORPORA", Corpus::TYPES
+      output     = ENV.fetch "BENCH_OUTPUT", ::File.join(BASE_PATH, "tmp", "bench.json")
+
+      corpora = Corpus.generate(size).slice(*types)
+      results = suites.flat_map do |suite|
+        suite_results = Suites.send suite, corpora, iterations
+        suite_results.each { |result| print_result result }
+
+        suite_results
+      end
+
+      report = {
+        :version         => VERSION,
+        :library_version => LIBRARY_VERSION,
+        :ruby_version    => RUBY_VERSION,
+        :platform        => RUBY_PLATFORM,
+        :time            => Time.now.utc.iso8601,
+        :corpus_size     => size,
+        :iterations      => iterations,
+        :results         => results
+      }
+
+      FileUtils.mkdir_p ::File.dirname(output)
+      ::File.write output, ::JSON.pretty_generate(report)
+
+      puts "Results written to #{output}"
+    end
+
+    def self.print_result(result)
+      latency = result[:latency_ms]
+
+      puts format(
+        "%-10<suite>s %-10<operation>s %-14<corpus>s %-40<options>s " \
+        "%10<throughput>s MB/s p50 %<p50>s ms p99 %<p99>s ms",
+        :suite      => result[:suite],
+        :operation  => result[:operation],
+        :corpus     => result[:corpus],
+        :options    => result[:options].inspect,
+        :throughput => result[:throughput_mbps],
+        :p50        => latency[:p50],
+        :p99        => latency[:p99]
+      )
+    end
+  end
+end
+
+ZSTDS::Bench.run
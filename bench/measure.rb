@@ -0,0 +1,56 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+module ZSTDS
+  module Bench
+    # Measures duration of each iteration, provides throughput and latency percentiles.
+    module Measure
+      PERCENTILES = [50, 90, 99].freeze
+
+      def self.current_time
+        ::Process.clock_gettime ::Process::CLOCK_MONOTONIC
+      end
+
+      # Warmup iteration is not measured, it allocates contexts and buffers.
+      def self.run(iterations)
+        yield
+
+        Array.new iterations do
+          start_time = current_time
+          yield
+
+          current_time - start_time
+        end
+      end
+
+      def self.percentile(sorted_durations, percent)
+        index = ((percent / 100.0) * (sorted_durations.length - 1)).round
+        sorted_durations[index]
+      end
+
+      def self.get_stats(durations, bytesize)
+        sorted_durations = durations.sort
+        total_duration   = durations.sum
+        throughput       = total_duration.zero? ? nil : bytesize * durations.length / total_duration / (1 << 20)
+
+        latency = PERCENTILES.to_h do |percent|
+          [:"p#{percent}", to_milliseconds(percentile(sorted_durations, percent))]
+        end
+
+        {
+          :iterations      => durations.length,
+          :bytesize        => bytesize,
+          :throughput_mbps => throughput&.round(2),
+          :latency_ms      => latency.merge(
+            :min => to_milliseconds(sorted_durations.first),
+            :max => to_milliseconds(sorted_durations.last)
+          )
+        }
+      end
+
+      def self.to_milliseconds(duration)
+        (duration * 1000).round 4
+      end
+    end
+  end
+end
@@ -0,0 +1,156 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require "stringio"
+require "tmpdir"
+require "zstds"
+
+require_relative "corpus"
+require_relative "measure"
+require_relative "sweep"
+
+module ZSTDS
+  module Bench
+    # Each suite returns list of results for all corpora and option variants.
+    module Suites
+      STREAM_CHUNK_SIZE = 1 << 16 # 64 KB
+
+      DICTIONARY_SAMPLE_SIZE = 256
+
+      def self.get_result(suite, operation, corpus, sweep, options, bytesize, durations, processed_bytesize = nil)
+        result = {
+          :suite     => suite,
+          :operation => operation,
+          :corpus    => corpus,
+          :sweep     => sweep,
+          :options   => options
+        }
+
+        unless processed_bytesize.nil? || processed_bytesize.zero?
+          result[:ratio] = (bytesize.to_f / processed_bytesize).round 4
+        end
+
+        result.merge Measure.get_stats(durations, bytesize)
+      end
+
+      # -- string --
+
+      def self.string(corpora, iterations)
+        corpora.flat_map do |corpus, source|
+          compress_results = Sweep.compressor_variants.map do |sweep, options|
+            compressed = String.compress source, options
+            durations  = Measure.run(iterations) { String.compress source, options }
+
+            get_result :string, :compress, corpus, sweep, options, source.bytesize, durations, compressed.bytesize
+          end
+
+          compressed = String.compress source
+
+          decompress_results = Sweep.decompressor_variants.map do |sweep, options|
+            durations = Measure.run(iterations) { String.decompress compressed, options }
+
+            get_result :string, :decompress, corpus, sweep, options, source.bytesize, durations, compressed.bytesize
+          end
+
+          compress_results + decompress_results
+        end
+      end
+
+      # -- file --
+
+      def self.file(corpora, iterations)
+        Dir.mktmpdir do |dir|
+          source_path     = ::File.join dir, "source"
+          compressed_path = ::File.join dir, "compressed"
+          result_path     = ::File.join dir, "result"
+
+          corpora.flat_map do |corpus, source|
+            ::File.binwrite source_path, source
+
+            compress_results = Sweep.compressor_variants.map do |sweep, options|
+              durations = Measure.run(iterations) { File.compress source_path, compressed_path, options }
+
+              get_result(
+                :file, :compress, corpus, sweep, options, source.bytesize, durations, ::File.size(compressed_path)
+              )
+            end
+
+            File.compress source_path, compressed_path
+
+            decompress_results = Sweep.decompressor_variants.map do |sweep, options|
+              durations = Measure.run(iterations) { File.decompress compressed_path, result_path, options }
+
+              get_result(
+                :file, :decompress, corpus, sweep, options, source.bytesize, durations, ::File.size(compressed_path)
+              )
+            end
+
+            compress_results + decompress_results
+          end
+        end
+      end
+
+      # -- stream --
+
+      def self.write_stream(source, options)
+        io     = ::StringIO.new
+        writer = Stream::Writer.new io, options
+
+        (0...source.bytesize).step(STREAM_CHUNK_SIZE) do |offset|
+          writer.write source.byteslice(offset, STREAM_CHUNK_SIZE)
+        end
+
+        writer.close
+
+        io.string
+      end
+
+      def self.read_stream(compressed, options)
+        reader = Stream::Reader.new ::StringIO.new(compressed), options
+        reader.read STREAM_CHUNK_SIZE until reader.eof?
+        reader.close
+      end
+
+      def self.stream(corpora, iterations)
+        corpora.flat_map do |corpus, source|
+          compress_results = Sweep.compressor_variants.map do |sweep, options|
+            compressed = write_stream source, options
+            durations  = Measure.run(iterations) { write_stream source, options }
+
+            get_result :stream, :write, corpus, sweep, options, source.bytesize, durations, compressed.bytesize
+          end
+
+          compressed = write_stream source, {}
+
+          decompress_results = Sweep.decompressor_variants.map do |sweep, options|
+            durations = Measure.run(iterations) { read_stream compressed, options }
+
+            get_result :stream, :read, corpus, sweep, options, source.bytesize, durations, compressed.bytesize
+          end
+
+          compress_results + decompress_results
+        end
+      end
+
+      # -- dictionary --
+
+      # Incompressible corpus can't be used for training.
+      def self.dictionary(corpora, iterations)
+        corpora.reject { |corpus, _source| corpus == :incompressible }.flat_map do |corpus, source|
+          samples_length = [source.bytesize / DICTIONARY_SAMPLE_SIZE / 4, 100].max
+          samples        = Corpus.samples source, DICTIONARY_SAMPLE_SIZE, samples_length
+          bytesize       = samples.sum(&:bytesize)
+
+          Sweep::GVLS.map do |gvl|
+            options   = { :gvl => gvl }
+            durations = Measure.run(iterations) { Dictionary.train samples, options }
+
+            get_result :dictionary, :train, corpus, :gvl, options, bytesize, durations
+          end
+        end
+      end
+
+      NAMES = %i[string file stream dictionary].freeze
+    end
+  end
+end
@@ -0,0 +1,74 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require "zstds/option"
+
+module ZSTDS
+  module Bench
+    # Each sweep changes single option, other options keep default values.
+    module Sweep
+      private_class_method def self.get_option_values(values, min, max)
+        values.map { |value| value.clamp min, max }.uniq
+      end
+
+      COMPRESSION_LEVELS = get_option_values(
+        [1, 3, 9, 19],
+        ZSTDS::Option::MIN_COMPRESSION_LEVEL,
+        ZSTDS::Option::MAX_COMPRESSION_LEVEL
+      )
+      .freeze
+
+      # Max workers equal to zero means that zstd was built without multithreading support.
+      NB_WORKERS = get_option_values(
+        [0, 2, 4],
+        ZSTDS::Option::MIN_NB_WORKERS,
+        ZSTDS::Option::MAX_NB_WORKERS
+      )
+      .freeze
+
+      BUFFER_LENGTHS = [
+        0,
+        1 << 12, # 4 KB
+        1 << 16  # 64 KB
+      ]
+      .freeze
+
+      GVLS = [
+        false,
+        true,
+        :auto
+      ]
+      .freeze
+
+      COMPRESSOR_SWEEPS = {
+        :compression_level         => COMPRESSION_LEVELS,
+        :strategy                  => ZSTDS::Option::STRATEGIES,
+        :destination_buffer_length => BUFFER_LENGTHS,
+        :gvl                       => GVLS,
+        :nb_workers                => NB_WORKERS
+      }
+      .freeze
+
+      DECOMPRESSOR_SWEEPS = {
+        :destination_buffer_length => BUFFER_LENGTHS,
+        :gvl                       => GVLS
+      }
+      .freeze
+
+      # Returns list of sweep name and options pairs.
+      def self.get_variants(sweeps)
+        sweeps.flat_map do |name, values|
+          values.map { |value| [name, { name => value }] }
+        end
+      end
+
+      def self.compressor_variants
+        get_variants COMPRESSOR_SWEEPS
+      end
+
+      def self.decompressor_variants
+        get_variants DECOMPRESSOR_SWEEPS
+      end
+    end
+  end
+end
@@ -4,6 +4,7 @@
 require "mkmf"
 
 have_func "rb_thread_call_without_gvl", "ruby/thread.h"
+have_func "rb_fiber_scheduler_current", "ruby/fiber/scheduler.h"
 
 # Old zstd versions has bug: underlinking against pthreads.
 # https://bugs.gentoo.org/713940
@@ -118,6 +119,31 @@ zdict_has_finalize = find_library "zstd", "ZDICT_finalizeDictionary"
 if zdict_has_params && zdict_has_finalize
   $defs.push "-DHAVE_ZDICT_FINALIZE"
 end
+
+# Cover training is a part of advanced API.
+if find_library("zstd", "ZDICT_optimizeTrainFromBuffer_cover") &&
+   find_library("zstd", "ZDICT_optimizeTrainFromBuffer_fastCover")
+  $defs.push "-DHAVE_ZDICT_COVER"
+end
+
+# Custom allocator is a part of advanced API.
+if find_library("zstd", "ZSTD_createCCtx_advanced") && find_library("zstd", "ZSTD_createDCtx_advanced")
+  $defs.push "-DHAVE_ZSTD_CUSTOM_MEM"
+end
+
+# Static workspace is a part of advanced API.
+zstd_has_static_workspace = %w[
+  ZSTD_createCCtxParams
+  ZSTD_CCtxParams_setParameter
+  ZSTD_estimateCStreamSize_usingCCtxParams
+  ZSTD_estimateDStreamSize
+  ZSTD_freeCCtxParams
+  ZSTD_initStaticCCtx
+  ZSTD_initStaticDCtx
+]
+.all? { |function| find_library "zstd", function }
+
+$defs.push "-DHAVE_ZSTD_STATIC_WORKSPACE" if zstd_has_static_workspace
 # rubocop:enable Style/GlobalVars
 
 require_library(
@@ -127,24 +153,34 @@ require_library(
     ZDICT_isError
     ZDICT_trainFromBuffer
     ZSTD_CCtx_loadDictionary
+    ZSTD_CCtx_reset
     ZSTD_CCtx_setParameter
     ZSTD_CCtx_setPledgedSrcSize
     ZSTD_CStreamInSize
     ZSTD_CStreamOutSize
+    ZSTD_compress2
+    ZSTD_compressBound
     ZSTD_compressStream2
     ZSTD_cParam_getBounds
     ZSTD_createCCtx
     ZSTD_createDCtx
     ZSTD_DCtx_setParameter
     ZSTD_DCtx_loadDictionary
+    ZSTD_DCtx_reset
     ZSTD_DStreamInSize
     ZSTD_DStreamOutSize
     ZSTD_decompressStream
+    ZSTD_findFrameCompressedSize
+    ZSTD_getFrameContentSize
     ZSTD_dParam_getBounds
     ZSTD_freeCCtx
     ZSTD_freeDCtx
     ZSTD_getErrorCode
     ZSTD_isError
+    ZSTD_sizeof_CCtx
+    ZSTD_sizeof_CDict
+    ZSTD_sizeof_DCtx
+    ZSTD_sizeof_DDict
   ]
 )
 
@@ -155,13 +191,22 @@ dir_config extension_name
 $srcs = %w[
   stream/compressor
   stream/decompressor
+  stream/stats
+  batch
   buffer
+  context_pool
   dictionary
   error
+  frame
+  gvl
   io
   main
+  memory
   option
+  pipeline
+  reservoir
   string
+  thread_pool
 ]
 .map { |name| "src/#{extension_name}/#{name}.c" }
 .freeze
@@ -0,0 +1,134 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#include "zstds_ext/batch.h"
+
+#include "zstds_ext/context_pool.h"
+#include "zstds_ext/error.h"
+#include "zstds_ext/frame.h"
+
+// -- process --
+
+static void compress_item(void* data, size_t worker_index, size_t index)
+{
+  zstds_ext_batch_args_t* args   = data;
+  zstds_ext_batch_item_t* item   = &args->items[index];
+  zstds_result_t          result = ZSTD_compress2(
+    args->ctxs[worker_index], item->destination, item->destination_length, item->source, item->source_length);
+
+  if (ZSTD_isError(result)) {
+    item->ext_result = zstds_ext_get_error(ZSTD_getErrorCode(result));
+  } else {
+    item->destination_length = result;
+  }
+}
+
+void* zstds_ext_compress_batch_wrapper(void* data)
+{
+  zstds_ext_batch_args_t* args = data;
+
+  zstds_ext_thread_pool_run(args->workers_length, args->items_length, compress_item, args);
+
+  return NULL;
+}
+
+static void decompress_item(void* data, size_t worker_index, size_t index)
+{
+  zstds_ext_batch_args_t* args = data;
+  zstds_ext_batch_item_t* item = &args->items[index];
+  if (item->destination == NULL) {
+    return;
+  }
+
+  ZSTD_DCtx* ctx = args->ctxs[worker_index];
+
+  // Previous source may be corrupted.
+  ZSTD_DCtx_reset(ctx, ZSTD_reset_session_only);
+
+  item->ext_result =
+    zstds_ext_decompress_frames(ctx, item->source, item->source_length, item->destination, item->destination_length);
+}
+
+void* zstds_ext_decompress_batch_wrapper(void* data)
+{
+  zstds_ext_batch_args_t* args = data;
+
+  zstds_ext_thread_pool_run(args->workers_length, args->items_length, decompress_item, args);
+
+  return NULL;
+}
+
+size_t zstds_ext_get_batch_workers_length(size_t workers, size_t items_length)
+{
+  size_t workers_length = workers;
+
+  if (workers_length > items_length) {
+    workers_length = items_length;
+  }
+
+  if (workers_length > ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH) {
+    workers_length = ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH;
+  }
+
+  return workers_length == 0 ? 1 : workers_length;
+}
+
+// -- contexts --
+
+void zstds_ext_release_compressor_contexts(ZSTD_CCtx** ctxs, size_t length)
+{
+  for (size_t index = 0; index < length; index++) {
+    zstds_ext_release_compressor_context(ctxs[index]);
+  }
+}
+
+zstds_ext_result_t zstds_ext_acquire_compressor_contexts(
+  ZSTD_CCtx** ctxs, size_t length, zstds_ext_compressor_options_t* compressor_options_ptr)
+{
+  for (size_t index = 0; index < length; index++) {
+    ZSTD_CCtx* ctx = zstds_ext_acquire_compressor_context();
+    if (ctx == NULL) {
+      zstds_ext_release_compressor_contexts(ctxs, index);
+      return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+    }
+
+    ctxs[index] = ctx;
+
+    zstds_ext_result_t ext_result = zstds_ext_set_compressor_options(ctx, compressor_options_ptr);
+    if (ext_result != 0) {
+      zstds_ext_release_compressor_contexts(ctxs, index + 1);
+      return ext_result;
+    }
+  }
+
+  return 0;
+}
+
+void zstds_ext_release_decompressor_contexts(ZSTD_DCtx** ctxs, size_t length)
+{
+  for (size_t index = 0; index < length; index++) {
+    zstds_ext_release_decompressor_context(ctxs[index]);
+  }
+}
+
+zstds_ext_result_t zstds_ext_acquire_decompressor_contexts(
+  ZSTD_DCtx** ctxs, size_t length, zstds_ext_decompressor_options_t* decompressor_options_ptr)
+{
+  for (size_t index = 0; index < length; index++) {
+    ZSTD_DCtx* ctx = zstds_ext_acquire_decompressor_context();
+    if (ctx == NULL) {
+      zstds_ext_release_decompressor_contexts(ctxs, index);
+      return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+    }
+
+    ctxs[index] = ctx;
+
+    zstds_ext_result_t ext_result = zstds_ext_set_decompressor_options(ctx, decompressor_options_ptr);
+    if (ext_result != 0) {
+      zstds_ext_release_decompressor_contexts(ctxs, index + 1);
+      return ext_result;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,58 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#if !defined(ZSTDS_EXT_BATCH_H)
+#define ZSTDS_EXT_BATCH_H
+
+#include <stddef.h>
+#include <zstd.h>
+
+#include "zstds_ext/common.h"
+#include "zstds_ext/option.h"
+#include "zstds_ext/thread_pool.h"
+
+// Current thread works together with pool threads.
+#define ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH (ZSTDS_EXT_THREAD_POOL_MAX_LENGTH + 1)
+
+// Each item has its own destination allocated before processing.
+// Compressor requires max compressed length, decompressor requires exact decompressed length.
+// Decompressor ignores item without destination.
+
+typedef struct
+{
+  const char*        source;
+  size_t             source_length;
+  char*              destination;
+  size_t             destination_length;
+  zstds_ext_result_t ext_result;
+} zstds_ext_batch_item_t;
+
+// Each worker uses its own context, items are distributed between workers by thread pool.
+
+typedef struct
+{
+  void**                  ctxs;
+  size_t                  workers_length;
+  zstds_ext_batch_item_t* items;
+  size_t                  items_length;
+} zstds_ext_batch_args_t;
+
+// These functions can be used without GVL.
+
+void* zstds_ext_compress_batch_wrapper(void* data);
+void* zstds_ext_decompress_batch_wrapper(void* data);
+
+// Returns workers length within 1 and max workers length.
+size_t zstds_ext_get_batch_workers_length(size_t workers, size_t items_length);
+
+// Contexts are acquired from context pool with provided options.
+
+zstds_ext_result_t zstds_ext_acquire_compressor_contexts(
+  ZSTD_CCtx** ctxs, size_t length, zstds_ext_compressor_options_t* compressor_options_ptr);
+void zstds_ext_release_compressor_contexts(ZSTD_CCtx** ctxs, size_t length);
+
+zstds_ext_result_t zstds_ext_acquire_decompressor_contexts(
+  ZSTD_DCtx** ctxs, size_t length, zstds_ext_decompressor_options_t* decompressor_options_ptr);
+void zstds_ext_release_decompressor_contexts(ZSTD_DCtx** ctxs, size_t length);
+
+#endif // ZSTDS_EXT_BATCH_H
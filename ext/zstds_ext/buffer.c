@@ -3,8 +3,12 @@
 
 #include "zstds_ext/buffer.h"
 
+#include <string.h>
 #include <zstd.h>
 
+#include "ruby/encoding.h"
+#include "zstds_ext/error.h"
+
 VALUE zstds_ext_create_string_buffer(VALUE length)
 {
   return rb_str_new(NULL, NUM2SIZET(length));
@@ -18,6 +22,39 @@ VALUE zstds_ext_resize_string_buffer(VALUE buffer_args)
   return rb_str_resize(buffer, NUM2SIZET(length));
 }
 
+bool zstds_ext_write_string_buffer(VALUE buffer, const char* data, size_t length)
+{
+  rb_str_modify(buffer);
+  rb_str_set_len(buffer, 0);
+
+  bool is_resized = rb_str_capacity(buffer) < length;
+  rb_str_modify_expand(buffer, length);
+
+  memcpy(RSTRING_PTR(buffer), data, length);
+
+  rb_str_set_len(buffer, length);
+  rb_enc_associate(buffer, rb_ascii8bit_encoding());
+
+  return is_resized;
+}
+
+const char* zstds_ext_get_string_part(VALUE source_value, VALUE offset_value, VALUE length_value, size_t* length_ptr)
+{
+  Check_Type(source_value, T_STRING);
+
+  size_t source_length = RSTRING_LEN(source_value);
+  size_t offset        = NUM2SIZET(offset_value);
+  size_t length        = NUM2SIZET(length_value);
+
+  if (offset > source_length || length > source_length - offset) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  *length_ptr = length;
+
+  return RSTRING_PTR(source_value) + offset;
+}
+
 void zstds_ext_buffer_exports(VALUE root_module)
 {
   VALUE module = rb_define_module_under(root_module, "Buffer");
@@ -4,6 +4,8 @@
 #if !defined(ZSTDS_EXT_BUFFER_H)
 #define ZSTDS_EXT_BUFFER_H
 
+#include <stdbool.h>
+
 #include "ruby.h"
 
 VALUE zstds_ext_create_string_buffer(VALUE length);
@@ -18,6 +20,14 @@ VALUE zstds_ext_resize_string_buffer(VALUE buffer_args);
   buffer            = rb_protect(zstds_ext_resize_string_buffer, buffer_args, &exception); \
   RB_GC_GUARD(buffer_args);
 
+// Replaces content of string buffer with binary data.
+// Buffer keeps its capacity, so it can be reused without reallocation.
+// Returns true when buffer capacity was not enough and it was resized.
+bool zstds_ext_write_string_buffer(VALUE buffer, const char* data, size_t length);
+
+// Returns part of string with offset and length, raises validate error when part is out of string.
+const char* zstds_ext_get_string_part(VALUE source, VALUE offset, VALUE length, size_t* length_ptr);
+
 void zstds_ext_buffer_exports(VALUE root_module);
 
 #endif // ZSTDS_EXT_BUFFER_H
@@ -0,0 +1,345 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#include "zstds_ext/context_pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "zstds_ext/macro.h"
+
+// -- context types --
+
+static void* create_compressor_context(void)
+{
+  return ZSTD_createCCtx();
+}
+
+static void free_compressor_context(void* ctx)
+{
+  ZSTD_freeCCtx(ctx);
+}
+
+static bool reset_compressor_context(void* ctx)
+{
+  return !ZSTD_isError(ZSTD_CCtx_reset(ctx, ZSTD_reset_session_and_parameters));
+}
+
+static void* create_decompressor_context(void)
+{
+  return ZSTD_createDCtx();
+}
+
+static void free_decompressor_context(void* ctx)
+{
+  ZSTD_freeDCtx(ctx);
+}
+
+static bool reset_decompressor_context(void* ctx)
+{
+  return !ZSTD_isError(ZSTD_DCtx_reset(ctx, ZSTD_reset_session_and_parameters));
+}
+
+// -- pool --
+
+typedef struct
+{
+  void*  ctx;
+  time_t released_at;
+} item_t;
+
+typedef struct
+{
+  void* (*create)(void);
+  void (*free)(void*);
+  bool (*reset)(void*);
+
+  pthread_key_t   local_key;
+  pthread_mutex_t mutex;
+  item_t          items[ZSTDS_EXT_CONTEXT_POOL_MAX_LENGTH];
+  size_t          items_length;
+
+  atomic_size_t hits;
+  atomic_size_t misses;
+} pool_t;
+
+static pool_t compressor_pool = {
+  .create = create_compressor_context,
+  .free   = free_compressor_context,
+  .reset  = reset_compressor_context,
+  .mutex  = PTHREAD_MUTEX_INITIALIZER};
+
+static pool_t decompressor_pool = {
+  .create = create_decompressor_context,
+  .free   = free_decompressor_context,
+  .reset  = reset_decompressor_context,
+  .mutex  = PTHREAD_MUTEX_INITIALIZER};
+
+static inline time_t get_time(void)
+{
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+
+  return time.tv_sec;
+}
+
+// Removes shared items unused for a long time.
+// Contexts should be freed after mutex unlock.
+
+static inline size_t take_idle_items(pool_t* pool_ptr, time_t time, void** contexts)
+{
+  size_t length = 0;
+
+  while (length < pool_ptr->items_length &&
+         time - pool_ptr->items[length].released_at >= ZSTDS_EXT_CONTEXT_POOL_IDLE_TIMEOUT) {
+    contexts[length] = pool_ptr->items[length].ctx;
+    length++;
+  }
+
+  if (length != 0) {
+    pool_ptr->items_length -= length;
+    memmove(pool_ptr->items, pool_ptr->items + length, pool_ptr->items_length * sizeof(item_t));
+  }
+
+  return length;
+}
+
+static inline void free_contexts(pool_t* pool_ptr, void** contexts, size_t length)
+{
+  for (size_t index = 0; index < length; index++) {
+    pool_ptr->free(contexts[index]);
+  }
+}
+
+static inline void* acquire_context(pool_t* pool_ptr)
+{
+  void* ctx = pthread_getspecific(pool_ptr->local_key);
+  if (ctx != NULL) {
+    pthread_setspecific(pool_ptr->local_key, NULL);
+    atomic_fetch_add_explicit(&pool_ptr->hits, 1, memory_order_relaxed);
+
+    return ctx;
+  }
+
+  void*  idle_contexts[ZSTDS_EXT_CONTEXT_POOL_MAX_LENGTH];
+  size_t idle_contexts_length;
+
+  pthread_mutex_lock(&pool_ptr->mutex);
+
+  idle_contexts_length = take_idle_items(pool_ptr, get_time(), idle_contexts);
+
+  if (pool_ptr->items_length != 0) {
+    pool_ptr->items_length--;
+    ctx = pool_ptr->items[pool_ptr->items_length].ctx;
+  }
+
+  pthread_mutex_unlock(&pool_ptr->mutex);
+
+  free_contexts(pool_ptr, idle_contexts, idle_contexts_length);
+
+  if (ctx != NULL) {
+    atomic_fetch_add_explicit(&pool_ptr->hits, 1, memory_order_relaxed);
+
+    return ctx;
+  }
+
+  atomic_fetch_add_explicit(&pool_ptr->misses, 1, memory_order_relaxed);
+
+  return pool_ptr->create();
+}
+
+static inline void store_shared_context(pool_t* pool_ptr, void* ctx)
+{
+  void*  idle_contexts[ZSTDS_EXT_CONTEXT_POOL_MAX_LENGTH];
+  size_t idle_contexts_length;
+  time_t time = get_time();
+
+  pthread_mutex_lock(&pool_ptr->mutex);
+
+  idle_contexts_length = take_idle_items(pool_ptr, time, idle_contexts);
+
+  if (pool_ptr->items_length != ZSTDS_EXT_CONTEXT_POOL_MAX_LENGTH) {
+    item_t* item = &pool_ptr->items[pool_ptr->items_length];
+    item->ctx         = ctx;
+    item->released_at = time;
+
+    pool_ptr->items_length++;
+    ctx = NULL;
+  }
+
+  pthread_mutex_unlock(&pool_ptr->mutex);
+
+  free_contexts(pool_ptr, idle_contexts, idle_contexts_length);
+
+  if (ctx != NULL) {
+    // Pool is full.
+    pool_ptr->free(ctx);
+  }
+}
+
+static inline void release_context(pool_t* pool_ptr, void* ctx)
+{
+  if (ctx == NULL) {
+    return;
+  }
+
+  if (!pool_ptr->reset(ctx)) {
+    pool_ptr->free(ctx);
+    return;
+  }
+
+  if (pthread_getspecific(pool_ptr->local_key) == NULL && pthread_setspecific(pool_ptr->local_key, ctx) == 0) {
+    return;
+  }
+
+  store_shared_context(pool_ptr, ctx);
+}
+
+static inline void clear_pool(pool_t* pool_ptr)
+{
+  void*  contexts[ZSTDS_EXT_CONTEXT_POOL_MAX_LENGTH + 1];
+  size_t contexts_length = 0;
+
+  void* local_ctx = pthread_getspecific(pool_ptr->local_key);
+  if (local_ctx != NULL) {
+    pthread_setspecific(pool_ptr->local_key, NULL);
+    contexts[contexts_length++] = local_ctx;
+  }
+
+  pthread_mutex_lock(&pool_ptr->mutex);
+
+  for (size_t index = 0; index < pool_ptr->items_length; index++) {
+    contexts[contexts_length++] = pool_ptr->items[index].ctx;
+  }
+
+  pool_ptr->items_length = 0;
+
+  pthread_mutex_unlock(&pool_ptr->mutex);
+
+  free_contexts(pool_ptr, contexts, contexts_length);
+}
+
+ZSTD_CCtx* zstds_ext_acquire_compressor_context(void)
+{
+  return acquire_context(&compressor_pool);
+}
+
+void zstds_ext_release_compressor_context(ZSTD_CCtx* ctx)
+{
+  release_context(&compressor_pool, ctx);
+}
+
+ZSTD_DCtx* zstds_ext_acquire_decompressor_context(void)
+{
+  return acquire_context(&decompressor_pool);
+}
+
+void zstds_ext_release_decompressor_context(ZSTD_DCtx* ctx)
+{
+  release_context(&decompressor_pool, ctx);
+}
+
+// -- thread exit --
+
+// Context of finished thread goes to shared list.
+
+static void release_compressor_thread_context(void* ctx)
+{
+  store_shared_context(&compressor_pool, ctx);
+}
+
+static void release_decompressor_thread_context(void* ctx)
+{
+  store_shared_context(&decompressor_pool, ctx);
+}
+
+// -- fork --
+
+// Child process has single thread only.
+// Compressor context may keep multithreading pool with threads that don't exist in child process.
+// So we can't free or reuse any parent context, we have to forget about them.
+
+static inline void lock_pool(pool_t* pool_ptr)
+{
+  pthread_mutex_lock(&pool_ptr->mutex);
+}
+
+static inline void unlock_pool(pool_t* pool_ptr)
+{
+  pthread_mutex_unlock(&pool_ptr->mutex);
+}
+
+static inline void forget_pool(pool_t* pool_ptr)
+{
+  pthread_mutex_init(&pool_ptr->mutex, NULL);
+  pthread_setspecific(pool_ptr->local_key, NULL);
+
+  pool_ptr->items_length = 0;
+}
+
+static void prepare_fork(void)
+{
+  lock_pool(&compressor_pool);
+  lock_pool(&decompressor_pool);
+}
+
+static void finish_fork_in_parent(void)
+{
+  unlock_pool(&decompressor_pool);
+  unlock_pool(&compressor_pool);
+}
+
+static void finish_fork_in_child(void)
+{
+  forget_pool(&compressor_pool);
+  forget_pool(&decompressor_pool);
+}
+
+// -- stats --
+
+#define SET_POOL_STAT(stats, pool, name, key) \
+  rb_hash_aset(                               \
+    stats, ID2SYM(rb_intern(key)), SIZET2NUM(atomic_load_explicit(&pool.name, memory_order_relaxed)));
+
+VALUE zstds_ext_get_context_pool_stats(VALUE ZSTDS_EXT_UNUSED(self))
+{
+  VALUE stats = rb_hash_new();
+
+  SET_POOL_STAT(stats, compressor_pool, hits, "compressor_hits");
+  SET_POOL_STAT(stats, compressor_pool, misses, "compressor_misses");
+  SET_POOL_STAT(stats, decompressor_pool, hits, "decompressor_hits");
+  SET_POOL_STAT(stats, decompressor_pool, misses, "decompressor_misses");
+
+  return stats;
+}
+
+VALUE zstds_ext_clear_context_pool(VALUE ZSTDS_EXT_UNUSED(self))
+{
+  clear_pool(&compressor_pool);
+  clear_pool(&decompressor_pool);
+
+  return Qnil;
+}
+
+// -- exports --
+
+void zstds_ext_context_pool_exports(VALUE root_module)
+{
+  if (
+    pthread_key_create(&compressor_pool.local_key, release_compressor_thread_context) != 0 ||
+    pthread_key_create(&decompressor_pool.local_key, release_decompressor_thread_context) != 0 ||
+    pthread_atfork(prepare_fork, finish_fork_in_parent, finish_fork_in_child) != 0) {
+    rb_raise(rb_eLoadError, "failed to initialize context pool");
+  }
+
+  VALUE module = rb_define_module_under(root_module, "ContextPool");
+
+  rb_define_const(module, "MAX_LENGTH", SIZET2NUM(ZSTDS_EXT_CONTEXT_POOL_MAX_LENGTH));
+  rb_define_const(module, "IDLE_TIMEOUT", SIZET2NUM(ZSTDS_EXT_CONTEXT_POOL_IDLE_TIMEOUT));
+
+  rb_define_module_function(module, "stats", RUBY_METHOD_FUNC(zstds_ext_get_context_pool_stats), 0);
+  rb_define_module_function(module, "clear", RUBY_METHOD_FUNC(zstds_ext_clear_context_pool), 0);
+}
@@ -0,0 +1,33 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#if !defined(ZSTDS_EXT_CONTEXT_POOL_H)
+#define ZSTDS_EXT_CONTEXT_POOL_H
+
+#include <zstd.h>
+
+#include "ruby.h"
+
+// Each thread keeps single context of each type, other released contexts are stored in shared list.
+#define ZSTDS_EXT_CONTEXT_POOL_MAX_LENGTH 16
+
+// Shared contexts unused for this amount of seconds will be freed.
+#define ZSTDS_EXT_CONTEXT_POOL_IDLE_TIMEOUT 30
+
+// Acquired context has default parameters and no dictionary.
+// Released context will be reset, it can be freed in case of failure.
+// Acquire returns NULL when allocation failed.
+// These functions can be used without GVL.
+
+ZSTD_CCtx* zstds_ext_acquire_compressor_context(void);
+void       zstds_ext_release_compressor_context(ZSTD_CCtx* ctx);
+
+ZSTD_DCtx* zstds_ext_acquire_decompressor_context(void);
+void       zstds_ext_release_decompressor_context(ZSTD_DCtx* ctx);
+
+VALUE zstds_ext_get_context_pool_stats(VALUE self);
+VALUE zstds_ext_clear_context_pool(VALUE self);
+
+void zstds_ext_context_pool_exports(VALUE root_module);
+
+#endif // ZSTDS_EXT_CONTEXT_POOL_H
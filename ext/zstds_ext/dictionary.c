@@ -3,13 +3,161 @@
 
 #include "zstds_ext/dictionary.h"
 
+#include <fcntl.h>
+#include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(HAVE_ZDICT_COVER)
+// Cover training is a part of advanced API, it should be enabled before first include.
+#define ZDICT_STATIC_LINKING_ONLY
+#endif // HAVE_ZDICT_COVER
+
 #include <zdict.h>
 
 #include "zstds_ext/buffer.h"
 #include "zstds_ext/error.h"
 #include "zstds_ext/gvl.h"
 #include "zstds_ext/option.h"
+#include "zstds_ext/reservoir.h"
+
+// -- initialization --
+
+static void free_dictionary(zstds_ext_dictionary_t* dictionary_ptr)
+{
+  zstds_ext_cdict_t* cdicts = dictionary_ptr->cdicts;
+  if (cdicts != NULL) {
+    for (size_t index = 0; index < dictionary_ptr->cdicts_length; index++) {
+      ZSTD_freeCDict(cdicts[index].cdict);
+    }
+
+    free(cdicts);
+  }
+
+  ZSTD_DDict* ddict = dictionary_ptr->ddict;
+  if (ddict != NULL) {
+    ZSTD_freeDDict(ddict);
+  }
+
+  if (dictionary_ptr->digested_size != 0) {
+    rb_gc_adjust_memory_usage(-(ssize_t) dictionary_ptr->digested_size);
+  }
+
+  free(dictionary_ptr);
+}
+
+static size_t get_dictionary_size(const zstds_ext_dictionary_t* dictionary_ptr)
+{
+  return sizeof(zstds_ext_dictionary_t) + dictionary_ptr->cdicts_length * sizeof(zstds_ext_cdict_t) +
+         dictionary_ptr->digested_size;
+}
+
+static const rb_data_type_t dictionary_type = {
+  .wrap_struct_name = "ZSTDS::Dictionary",
+  .function =
+    {.dmark = NULL, .dfree = (RUBY_DATA_FUNC) free_dictionary, .dsize = (size_t(*)(const void*)) get_dictionary_size},
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY};
+
+VALUE zstds_ext_allocate_dictionary(VALUE klass)
+{
+  zstds_ext_dictionary_t* dictionary_ptr;
+  VALUE                   self = TypedData_Make_Struct(klass, zstds_ext_dictionary_t, &dictionary_type, dictionary_ptr);
+
+  dictionary_ptr->cdicts        = NULL;
+  dictionary_ptr->cdicts_length = 0;
+  dictionary_ptr->ddict         = NULL;
+  dictionary_ptr->digested_size = 0;
+
+  return self;
+}
+
+#define GET_DICTIONARY(self)              \
+  zstds_ext_dictionary_t* dictionary_ptr; \
+  TypedData_Get_Struct(self, zstds_ext_dictionary_t, &dictionary_type, dictionary_ptr);
+
+// -- digested --
+
+// Digested dictionaries are allocated by zstd, ruby GC receives their size.
+
+static inline void add_digested_size(zstds_ext_dictionary_t* dictionary_ptr, size_t size)
+{
+  dictionary_ptr->digested_size += size;
+  rb_gc_adjust_memory_usage((ssize_t) size);
+}
+
+static inline VALUE get_buffer(VALUE self)
+{
+  return rb_attr_get(self, rb_intern("@buffer"));
+}
+
+ZSTD_CDict* zstds_ext_get_dictionary_cdict(VALUE self, int compression_level)
+{
+  GET_DICTIONARY(self);
+
+  if (compression_level == 0) {
+    compression_level = ZSTD_CLEVEL_DEFAULT;
+  }
+
+  zstds_ext_cdict_t* cdicts        = dictionary_ptr->cdicts;
+  size_t             cdicts_length = dictionary_ptr->cdicts_length;
+
+  for (size_t index = 0; index < cdicts_length; index++) {
+    if (cdicts[index].compression_level == compression_level) {
+      return cdicts[index].cdict;
+    }
+  }
+
+  cdicts = realloc(cdicts, (cdicts_length + 1) * sizeof(zstds_ext_cdict_t));
+  if (cdicts == NULL) {
+    return NULL;
+  }
+
+  dictionary_ptr->cdicts = cdicts;
+
+  VALUE       buffer = get_buffer(self);
+  ZSTD_CDict* cdict  = ZSTD_createCDict(RSTRING_PTR(buffer), RSTRING_LEN(buffer), compression_level);
+  if (cdict == NULL) {
+    return NULL;
+  }
+
+  zstds_ext_cdict_t* cdict_ptr = &cdicts[cdicts_length];
+  cdict_ptr->compression_level = compression_level;
+  cdict_ptr->cdict             = cdict;
+
+  dictionary_ptr->cdicts_length = cdicts_length + 1;
+
+  add_digested_size(dictionary_ptr, ZSTD_sizeof_CDict(cdict));
+
+  return cdict;
+}
+
+ZSTD_DDict* zstds_ext_get_dictionary_ddict(VALUE self)
+{
+  GET_DICTIONARY(self);
+
+  if (dictionary_ptr->ddict == NULL) {
+    VALUE       buffer = get_buffer(self);
+    ZSTD_DDict* ddict  = ZSTD_createDDict(RSTRING_PTR(buffer), RSTRING_LEN(buffer));
+    if (ddict == NULL) {
+      return NULL;
+    }
+
+    dictionary_ptr->ddict = ddict;
+
+    add_digested_size(dictionary_ptr, ZSTD_sizeof_DDict(ddict));
+  }
+
+  return dictionary_ptr->ddict;
+}
+
+VALUE zstds_ext_get_dictionary_digested_size(VALUE self)
+{
+  GET_DICTIONARY(self);
+
+  return SIZET2NUM(dictionary_ptr->digested_size);
+}
 
 // -- common --
 
@@ -51,11 +199,7 @@ static inline sample_t* prepare_samples(VALUE raw_samples, size_t* samples_lengt
   return samples;
 }
 
-static inline zstds_ext_result_t prepare_samples_group(
-  const sample_t*    samples,
-  size_t             samples_length,
-  zstds_ext_byte_t** group_ptr,
-  size_t**           sizes_ptr)
+static inline size_t get_samples_size(const sample_t* samples, size_t samples_length)
 {
   size_t size = 0;
 
@@ -63,6 +207,16 @@ static inline zstds_ext_result_t prepare_samples_group(
     size += samples[index].size;
   }
 
+  return size;
+}
+
+static inline zstds_ext_result_t prepare_samples_group(
+  const sample_t*    samples,
+  size_t             samples_length,
+  zstds_ext_byte_t** group_ptr,
+  size_t**           sizes_ptr)
+{
+  size_t            size  = get_samples_size(samples, samples_length);
   zstds_ext_byte_t* group = malloc(size);
   if (group == NULL) {
     return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
@@ -94,33 +248,121 @@ static inline zstds_ext_result_t prepare_samples_group(
 
 // -- training --
 
+// Training can't be split into slices, so it may run in separate thread and it should not reference ruby objects.
+// Samples group can be borrowed from ruby string, training can't be abandoned in this case.
+// Samples can be loaded inside training thread, loader should set group and sizes.
+
+// Cover params are optional, zero value means that zstd will choose it.
+// Cover training will write chosen params back.
+
 typedef struct
 {
-  const sample_t*    samples;
-  size_t             samples_length;
-  char*              buffer;
-  size_t             capacity;
-  zstds_result_t     result;
-  zstds_ext_result_t ext_result;
-} train_args_t;
+  unsigned int k;
+  unsigned int d;
+  unsigned int f;
+  unsigned int steps;
+  unsigned int accel;
+  unsigned int nb_threads;
+  double       split_point;
+} cover_params_t;
+
+typedef struct train_args train_args_t;
+
+typedef zstds_ext_result_t (*load_samples_function_t)(train_args_t* args);
+typedef void (*free_samples_source_function_t)(void* source);
+
+struct train_args
+{
+  zstds_ext_byte_t*                group;
+  size_t*                          sizes;
+  size_t                           samples_length;
+  bool                             is_group_borrowed;
+  void*                            source;
+  load_samples_function_t          load_samples;
+  free_samples_source_function_t   free_source;
+  char*                            buffer;
+  size_t                           capacity;
+  zstds_ext_dictionary_algorithm_t algorithm;
+  cover_params_t                   cover_params;
+  zstds_result_t                   result;
+  zstds_ext_result_t               ext_result;
+};
 
-static inline void* train_wrapper(void* data)
+#if defined(HAVE_ZDICT_COVER)
+static inline zstds_result_t train_cover(train_args_t* args)
+{
+  cover_params_t*      cover_params_ptr = &args->cover_params;
+  ZDICT_cover_params_t params           = {
+    .k          = cover_params_ptr->k,
+    .d          = cover_params_ptr->d,
+    .steps      = cover_params_ptr->steps,
+    .nbThreads  = cover_params_ptr->nb_threads,
+    .splitPoint = cover_params_ptr->split_point,
+  };
+
+  zstds_result_t result = ZDICT_optimizeTrainFromBuffer_cover(
+    args->buffer, args->capacity, args->group, args->sizes, (unsigned int) args->samples_length, &params);
+
+  cover_params_ptr->k           = params.k;
+  cover_params_ptr->d           = params.d;
+  cover_params_ptr->steps       = params.steps;
+  cover_params_ptr->split_point = params.splitPoint;
+
+  return result;
+}
+
+static inline zstds_result_t train_fast_cover(train_args_t* args)
+{
+  cover_params_t*          cover_params_ptr = &args->cover_params;
+  ZDICT_fastCover_params_t params           = {
+    .k          = cover_params_ptr->k,
+    .d          = cover_params_ptr->d,
+    .f          = cover_params_ptr->f,
+    .steps      = cover_params_ptr->steps,
+    .nbThreads  = cover_params_ptr->nb_threads,
+    .splitPoint = cover_params_ptr->split_point,
+    .accel      = cover_params_ptr->accel,
+  };
+
+  zstds_result_t result = ZDICT_optimizeTrainFromBuffer_fastCover(
+    args->buffer, args->capacity, args->group, args->sizes, (unsigned int) args->samples_length, &params);
+
+  cover_params_ptr->k           = params.k;
+  cover_params_ptr->d           = params.d;
+  cover_params_ptr->f           = params.f;
+  cover_params_ptr->steps       = params.steps;
+  cover_params_ptr->split_point = params.splitPoint;
+  cover_params_ptr->accel       = params.accel;
+
+  return result;
+}
+#endif // HAVE_ZDICT_COVER
+
+static void* train_wrapper(void* data)
 {
   train_args_t* args = data;
 
-  zstds_ext_byte_t*  group;
-  size_t*            sizes;
-  zstds_ext_result_t result = prepare_samples_group(args->samples, args->samples_length, &group, &sizes);
-  if (result != 0) {
-    args->ext_result = result;
-    return NULL;
+  if (args->load_samples != NULL) {
+    zstds_ext_result_t ext_result = args->load_samples(args);
+    if (ext_result != 0) {
+      args->ext_result = ext_result;
+      return NULL;
+    }
   }
 
-  args->result =
-    ZDICT_trainFromBuffer((void*) args->buffer, args->capacity, group, sizes, (unsigned int) args->samples_length);
-
-  free(group);
-  free(sizes);
+  switch (args->algorithm) {
+#if defined(HAVE_ZDICT_COVER)
+    case ZSTDS_EXT_DICTIONARY_ALGORITHM_COVER:
+      args->result = train_cover(args);
+      break;
+    case ZSTDS_EXT_DICTIONARY_ALGORITHM_FAST_COVER:
+      args->result = train_fast_cover(args);
+      break;
+#endif // HAVE_ZDICT_COVER
+    default:
+      args->result = ZDICT_trainFromBuffer(
+        args->buffer, args->capacity, args->group, args->sizes, (unsigned int) args->samples_length);
+  }
 
   if (ZDICT_isError(args->result)) {
     args->ext_result = zstds_ext_get_error(ZSTD_getErrorCode(args->result));
@@ -132,47 +374,550 @@ static inline void* train_wrapper(void* data)
   return NULL;
 }
 
-VALUE zstds_ext_train_dictionary_buffer(VALUE ZSTDS_EXT_UNUSED(self), VALUE raw_samples, VALUE options)
+static void free_train_args(void* data)
+{
+  train_args_t* args = data;
+
+  if (!args->is_group_borrowed) {
+    free(args->group);
+  }
+
+  free(args->sizes);
+
+  if (args->free_source != NULL) {
+    args->free_source(args->source);
+  }
+
+  free(args->buffer);
+  free(args);
+}
+
+typedef struct
+{
+  size_t                           capacity;
+  zstds_ext_gvl_t                  gvl_mode;
+  zstds_ext_dictionary_algorithm_t algorithm;
+  cover_params_t                   cover_params;
+} train_options_t;
+
+static inline void get_train_options(VALUE options, train_options_t* train_options_ptr)
 {
-  check_raw_samples(raw_samples);
   Check_Type(options, T_HASH);
   ZSTDS_EXT_GET_SIZE_OPTION(options, capacity);
-  ZSTDS_EXT_GET_BOOL_OPTION(options, gvl);
-
-  size_t    samples_length;
-  sample_t* samples = prepare_samples(raw_samples, &samples_length);
+  ZSTDS_EXT_GET_GVL_OPTION(options);
+  ZSTDS_EXT_GET_DICTIONARY_ALGORITHM_OPTION(options, algorithm);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, k);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, d);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, f);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, steps);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, accel);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, nb_threads);
+  ZSTDS_EXT_GET_DOUBLE_OPTION(options, split_point);
+
+#if !defined(HAVE_ZDICT_COVER)
+  if (algorithm != ZSTDS_EXT_DICTIONARY_ALGORITHM_DEFAULT) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_NOT_IMPLEMENTED);
+  }
+#endif // HAVE_ZDICT_COVER
 
   if (capacity == 0) {
     capacity = ZSTDS_EXT_DEFAULT_DICTIONARY_CAPACITY;
   }
 
+  train_options_ptr->capacity     = capacity;
+  train_options_ptr->gvl_mode     = gvl_mode;
+  train_options_ptr->algorithm    = algorithm;
+  train_options_ptr->cover_params = (cover_params_t){
+    .k           = (unsigned int) k,
+    .d           = (unsigned int) d,
+    .f           = (unsigned int) f,
+    .steps       = (unsigned int) steps,
+    .accel       = (unsigned int) accel,
+    .nb_threads  = (unsigned int) nb_threads,
+    .split_point = split_point,
+  };
+}
+
+static inline train_args_t* create_train_args(const train_options_t* train_options_ptr)
+{
+  train_args_t* args = malloc(sizeof(train_args_t));
+  if (args == NULL) {
+    return NULL;
+  }
+
+  size_t capacity = train_options_ptr->capacity;
+
+  args->buffer = malloc(capacity);
+  if (args->buffer == NULL) {
+    free(args);
+    return NULL;
+  }
+
+  args->group             = NULL;
+  args->sizes             = NULL;
+  args->samples_length    = 0;
+  args->is_group_borrowed = false;
+  args->source            = NULL;
+  args->load_samples      = NULL;
+  args->free_source       = NULL;
+  args->capacity          = capacity;
+  args->algorithm         = train_options_ptr->algorithm;
+  args->cover_params      = train_options_ptr->cover_params;
+
+  return args;
+}
+
+#define SET_COVER_PARAMS_VALUE(hash, name, value) rb_hash_aset(hash, ID2SYM(rb_intern(name)), value);
+
+// Returns nil for default algorithm, it doesn't provide chosen params.
+static inline VALUE get_cover_params_hash(const train_args_t* args)
+{
+  if (args->algorithm == ZSTDS_EXT_DICTIONARY_ALGORITHM_DEFAULT) {
+    return Qnil;
+  }
+
+  const cover_params_t* cover_params_ptr = &args->cover_params;
+
+  VALUE hash = rb_hash_new();
+
+  SET_COVER_PARAMS_VALUE(hash, "k", UINT2NUM(cover_params_ptr->k));
+  SET_COVER_PARAMS_VALUE(hash, "d", UINT2NUM(cover_params_ptr->d));
+  SET_COVER_PARAMS_VALUE(hash, "steps", UINT2NUM(cover_params_ptr->steps));
+  SET_COVER_PARAMS_VALUE(hash, "split_point", DBL2NUM(cover_params_ptr->split_point));
+
+  if (args->algorithm == ZSTDS_EXT_DICTIONARY_ALGORITHM_FAST_COVER) {
+    SET_COVER_PARAMS_VALUE(hash, "f", UINT2NUM(cover_params_ptr->f));
+    SET_COVER_PARAMS_VALUE(hash, "accel", UINT2NUM(cover_params_ptr->accel));
+  }
+
+  return hash;
+}
+
+// Borrowed training can't be abandoned, so it won't raise before finish.
+// Length is used only for auto GVL mode.
+
+static inline void run_training(train_args_t* args, zstds_ext_gvl_t gvl_mode, size_t length)
+{
+  bool gvl = zstds_ext_keep_gvl(gvl_mode, length);
+
+  if (gvl || args->is_group_borrowed) {
+    ZSTDS_EXT_GVL_WRAP(gvl, train_wrapper, args);
+  } else {
+    // Interrupt abandons training, args will be freed by job.
+    int state = zstds_ext_run_interruptible_job(train_wrapper, args, free_train_args);
+    if (state != 0) {
+      rb_jump_tag(state);
+    }
+  }
+}
+
+// Args are freed by this function, it returns buffer and chosen params.
+
+static inline VALUE finish_training(train_args_t* args)
+{
+  zstds_ext_result_t ext_result = args->ext_result;
+  if (ext_result != 0) {
+    free_train_args(args);
+    zstds_ext_raise_error(ext_result);
+  }
+
   int exception;
 
-  ZSTDS_EXT_CREATE_STRING_BUFFER(buffer, capacity, exception);
+  ZSTDS_EXT_CREATE_STRING_BUFFER(buffer, args->result, exception);
   if (exception != 0) {
+    free_train_args(args);
     zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
   }
 
-  train_args_t args = {
-    .samples        = samples,
-    .samples_length = samples_length,
-    .buffer         = RSTRING_PTR(buffer),
-    .capacity       = capacity,
-  };
+  memcpy(RSTRING_PTR(buffer), args->buffer, args->result);
+
+  VALUE cover_params = get_cover_params_hash(args);
+  free_train_args(args);
+
+  return rb_ary_new_from_args(2, buffer, cover_params);
+}
+
+VALUE zstds_ext_train_dictionary_buffer(VALUE ZSTDS_EXT_UNUSED(self), VALUE raw_samples, VALUE options)
+{
+  check_raw_samples(raw_samples);
+
+  train_options_t train_options;
+  get_train_options(options, &train_options);
+
+  size_t    samples_length;
+  sample_t* samples      = prepare_samples(raw_samples, &samples_length);
+  size_t    samples_size = get_samples_size(samples, samples_length);
+
+  train_args_t* args = create_train_args(&train_options);
+  if (args == NULL) {
+    free(samples);
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  }
 
-  ZSTDS_EXT_GVL_WRAP(gvl, train_wrapper, &args);
+  // Samples are copied, training can be abandoned.
+  zstds_ext_result_t ext_result = prepare_samples_group(samples, samples_length, &args->group, &args->sizes);
   free(samples);
 
-  if (args.ext_result != 0) {
-    zstds_ext_raise_error(args.ext_result);
+  if (ext_result != 0) {
+    free_train_args(args);
+    zstds_ext_raise_error(ext_result);
   }
 
-  ZSTDS_EXT_RESIZE_STRING_BUFFER(buffer, args.result, exception);
-  if (exception != 0) {
+  args->samples_length = samples_length;
+
+  run_training(args, train_options.gvl_mode, samples_size);
+
+  return finish_training(args);
+}
+
+// -- concatenated training --
+
+// Samples are used without copying, string is locked while training is running.
+
+VALUE zstds_ext_train_dictionary_concatenated_buffer(
+  VALUE ZSTDS_EXT_UNUSED(self),
+  VALUE samples_buffer,
+  VALUE sample_sizes,
+  VALUE options)
+{
+  Check_Type(samples_buffer, T_STRING);
+  Check_Type(sample_sizes, T_ARRAY);
+
+  train_options_t train_options;
+  get_train_options(options, &train_options);
+
+  size_t samples_length = RARRAY_LEN(sample_sizes);
+  size_t samples_size   = 0;
+
+  for (size_t index = 0; index < samples_length; index++) {
+    VALUE sample_size = rb_ary_entry(sample_sizes, index);
+    Check_Type(sample_size, T_FIXNUM);
+
+    samples_size += NUM2SIZET(sample_size);
+  }
+
+  if (samples_size != (size_t) RSTRING_LEN(samples_buffer)) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  train_args_t* args = create_train_args(&train_options);
+  if (args == NULL) {
     zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
   }
 
-  return buffer;
+  args->sizes = malloc(samples_length * sizeof(size_t));
+  if (args->sizes == NULL) {
+    free_train_args(args);
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  }
+
+  for (size_t index = 0; index < samples_length; index++) {
+    args->sizes[index] = NUM2SIZET(rb_ary_entry(sample_sizes, index));
+  }
+
+  args->group             = (zstds_ext_byte_t*) RSTRING_PTR(samples_buffer);
+  args->samples_length    = samples_length;
+  args->is_group_borrowed = true;
+
+  rb_str_locktmp(samples_buffer);
+  run_training(args, train_options.gvl_mode, samples_size);
+  rb_str_unlocktmp(samples_buffer);
+
+  return finish_training(args);
+}
+
+// -- files training --
+
+// Each file is a separate sample.
+// Files are mapped and copied into samples group inside training thread, ruby heap won't keep samples.
+
+typedef struct
+{
+  char** paths;
+  size_t paths_length;
+} files_source_t;
+
+static void free_files_source(void* data)
+{
+  files_source_t* source_ptr = data;
+
+  for (size_t index = 0; index < source_ptr->paths_length; index++) {
+    free(source_ptr->paths[index]);
+  }
+
+  free(source_ptr->paths);
+  free(source_ptr);
+}
+
+static inline zstds_ext_result_t copy_file(const char* path, size_t size, zstds_ext_byte_t* destination)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return ZSTDS_EXT_ERROR_ACCESS_IO;
+  }
+
+  // File may be changed after receiving its size.
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || (uintmax_t) file_stat.st_size != size) {
+    close(fd);
+    return ZSTDS_EXT_ERROR_READ_IO;
+  }
+
+  void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (map == MAP_FAILED) {
+    return ZSTDS_EXT_ERROR_READ_IO;
+  }
+
+  // Advice is optional, it just increases read ahead.
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  memcpy(destination, map, size);
+  munmap(map, size);
+
+  return 0;
+}
+
+static zstds_ext_result_t load_files(train_args_t* args)
+{
+  const files_source_t* source_ptr   = args->source;
+  char**                paths        = source_ptr->paths;
+  size_t                paths_length = source_ptr->paths_length;
+
+  size_t* sizes = malloc(paths_length * sizeof(size_t));
+  if (sizes == NULL) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  args->sizes = sizes;
+
+  size_t samples_size = 0;
+
+  for (size_t index = 0; index < paths_length; index++) {
+    struct stat file_stat;
+    if (stat(paths[index], &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+      return ZSTDS_EXT_ERROR_ACCESS_IO;
+    }
+
+    // Empty file is an empty sample, it is not valid.
+    uintmax_t size = file_stat.st_size;
+    if (size == 0 || size > SIZE_MAX - samples_size) {
+      return ZSTDS_EXT_ERROR_VALIDATE_FAILED;
+    }
+
+    sizes[index] = size;
+    samples_size += size;
+  }
+
+  zstds_ext_byte_t* group = malloc(samples_size);
+  if (group == NULL) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  args->group = group;
+
+  for (size_t index = 0; index < paths_length; index++) {
+    zstds_ext_result_t ext_result = copy_file(paths[index], sizes[index], group);
+    if (ext_result != 0) {
+      return ext_result;
+    }
+
+    group += sizes[index];
+  }
+
+  args->samples_length = paths_length;
+
+  return 0;
+}
+
+static inline files_source_t* create_files_source(VALUE paths)
+{
+  files_source_t* source_ptr = malloc(sizeof(files_source_t));
+  if (source_ptr == NULL) {
+    return NULL;
+  }
+
+  size_t paths_length = RARRAY_LEN(paths);
+
+  source_ptr->paths = malloc(paths_length * sizeof(char*));
+  if (source_ptr->paths == NULL) {
+    free(source_ptr);
+    return NULL;
+  }
+
+  source_ptr->paths_length = 0;
+
+  for (size_t index = 0; index < paths_length; index++) {
+    VALUE  raw_path    = rb_ary_entry(paths, index);
+    size_t path_length = RSTRING_LEN(raw_path);
+
+    char* path = malloc(path_length + 1);
+    if (path == NULL) {
+      free_files_source(source_ptr);
+      return NULL;
+    }
+
+    memcpy(path, RSTRING_PTR(raw_path), path_length);
+    path[path_length] = '\0';
+
+    source_ptr->paths[index] = path;
+    source_ptr->paths_length = index + 1;
+  }
+
+  return source_ptr;
+}
+
+VALUE zstds_ext_train_dictionary_files_buffer(VALUE ZSTDS_EXT_UNUSED(self), VALUE paths, VALUE options)
+{
+  Check_Type(paths, T_ARRAY);
+
+  size_t paths_length = RARRAY_LEN(paths);
+  if (paths_length == 0) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  for (size_t index = 0; index < paths_length; index++) {
+    VALUE raw_path = rb_ary_entry(paths, index);
+
+    // Path should not contain null bytes.
+    StringValueCStr(raw_path);
+  }
+
+  train_options_t train_options;
+  get_train_options(options, &train_options);
+
+  files_source_t* source_ptr = create_files_source(paths);
+  if (source_ptr == NULL) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  }
+
+  train_args_t* args = create_train_args(&train_options);
+  if (args == NULL) {
+    free_files_source(source_ptr);
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  }
+
+  args->source       = source_ptr;
+  args->load_samples = load_files;
+  args->free_source  = free_files_source;
+
+  // Files size is not known before loading, auto GVL mode will release it.
+  run_training(args, train_options.gvl_mode, SIZE_MAX);
+
+  return finish_training(args);
+}
+
+// -- reservoir training --
+
+// Reservoir samples are moved into training, they are copied into samples group and freed one by one.
+
+typedef struct
+{
+  zstds_ext_reservoir_sample_t* samples;
+  size_t                        samples_length;
+} reservoir_source_t;
+
+static inline void free_reservoir_samples(zstds_ext_reservoir_sample_t* samples, size_t samples_length)
+{
+  for (size_t index = 0; index < samples_length; index++) {
+    free(samples[index].data);
+  }
+
+  free(samples);
+}
+
+static void free_reservoir_source(void* data)
+{
+  reservoir_source_t* source_ptr = data;
+
+  free_reservoir_samples(source_ptr->samples, source_ptr->samples_length);
+  free(source_ptr);
+}
+
+static inline size_t get_reservoir_samples_size(const zstds_ext_reservoir_sample_t* samples, size_t samples_length)
+{
+  size_t size = 0;
+
+  for (size_t index = 0; index < samples_length; index++) {
+    size += samples[index].size;
+  }
+
+  return size;
+}
+
+static zstds_ext_result_t load_reservoir_samples(train_args_t* args)
+{
+  reservoir_source_t*           source_ptr     = args->source;
+  zstds_ext_reservoir_sample_t* samples        = source_ptr->samples;
+  size_t                        samples_length = source_ptr->samples_length;
+
+  size_t* sizes = malloc(samples_length * sizeof(size_t));
+  if (sizes == NULL) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  args->sizes = sizes;
+
+  zstds_ext_byte_t* group = malloc(get_reservoir_samples_size(samples, samples_length));
+  if (group == NULL) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  args->group = group;
+
+  for (size_t index = 0; index < samples_length; index++) {
+    zstds_ext_reservoir_sample_t* sample_ptr = &samples[index];
+    size_t                        size       = sample_ptr->size;
+
+    memcpy(group, sample_ptr->data, size);
+    group += size;
+
+    sizes[index] = size;
+
+    free(sample_ptr->data);
+    sample_ptr->data = NULL;
+  }
+
+  args->samples_length = samples_length;
+
+  return 0;
+}
+
+VALUE zstds_ext_train_dictionary_reservoir_buffer(VALUE ZSTDS_EXT_UNUSED(self), VALUE reservoir, VALUE options)
+{
+  train_options_t train_options;
+  get_train_options(options, &train_options);
+
+  size_t                        samples_length;
+  zstds_ext_reservoir_sample_t* samples = zstds_ext_take_reservoir_samples(reservoir, &samples_length);
+  if (samples_length == 0) {
+    free(samples);
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  reservoir_source_t* source_ptr = malloc(sizeof(reservoir_source_t));
+  if (source_ptr == NULL) {
+    free_reservoir_samples(samples, samples_length);
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  }
+
+  source_ptr->samples        = samples;
+  source_ptr->samples_length = samples_length;
+
+  train_args_t* args = create_train_args(&train_options);
+  if (args == NULL) {
+    free_reservoir_source(source_ptr);
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  }
+
+  args->source       = source_ptr;
+  args->load_samples = load_reservoir_samples;
+  args->free_source  = free_reservoir_source;
+
+  run_training(args, train_options.gvl_mode, get_reservoir_samples_size(samples, samples_length));
+
+  return finish_training(args);
 }
 
 // -- finalizing --
@@ -266,7 +1011,7 @@ VALUE zstds_ext_finalize_dictionary_buffer(
   check_raw_samples(raw_samples);
   Check_Type(options, T_HASH);
   ZSTDS_EXT_GET_SIZE_OPTION(options, max_size);
-  ZSTDS_EXT_GET_BOOL_OPTION(options, gvl);
+  ZSTDS_EXT_GET_GVL_OPTION(options);
   ZSTDS_EXT_GET_DICTIONARY_OPTIONS(options);
 
   size_t    samples_length;
@@ -293,6 +1038,8 @@ VALUE zstds_ext_finalize_dictionary_buffer(
     .dictionary_options = dictionary_options,
   };
 
+  bool gvl = zstds_ext_keep_gvl(gvl_mode, args.content_length + get_samples_size(samples, samples_length));
+
   ZSTDS_EXT_GVL_WRAP(gvl, finalize_wrapper, &args);
   free(samples);
 
@@ -350,14 +1097,34 @@ ZSTDS_EXT_NORETURN VALUE
 };
 #endif // HAVE_ZDICT_HEADER_SIZE
 
+// Frame header may not contain dictionary id, zero will be returned.
+
+VALUE zstds_ext_get_dictionary_frame_id(VALUE ZSTDS_EXT_UNUSED(self), VALUE source)
+{
+  Check_Type(source, T_STRING);
+
+  return UINT2NUM(ZSTD_getDictID_fromFrame(RSTRING_PTR(source), RSTRING_LEN(source)));
+}
+
 // -- exports --
 
 void zstds_ext_dictionary_exports(VALUE root_module)
 {
   VALUE dictionary = rb_define_class_under(root_module, "Dictionary", rb_cObject);
 
+  rb_define_alloc_func(dictionary, zstds_ext_allocate_dictionary);
+
   rb_define_singleton_method(dictionary, "finalize_buffer", zstds_ext_finalize_dictionary_buffer, 3);
   rb_define_singleton_method(dictionary, "get_buffer_id", zstds_ext_get_dictionary_buffer_id, 1);
+  rb_define_singleton_method(dictionary, "get_frame_id", zstds_ext_get_dictionary_frame_id, 1);
   rb_define_singleton_method(dictionary, "get_header_size", zstds_ext_get_dictionary_header_size, 1);
   rb_define_singleton_method(dictionary, "train_buffer", zstds_ext_train_dictionary_buffer, 2);
+  rb_define_singleton_method(
+    dictionary, "train_concatenated_buffer", zstds_ext_train_dictionary_concatenated_buffer, 3);
+  rb_define_singleton_method(dictionary, "train_files_buffer", zstds_ext_train_dictionary_files_buffer, 2);
+  rb_define_singleton_method(dictionary, "train_reservoir_buffer", zstds_ext_train_dictionary_reservoir_buffer, 2);
+
+  rb_define_method(dictionary, "digested_size", zstds_ext_get_dictionary_digested_size, 0);
+
+  zstds_ext_reservoir_exports(dictionary);
 }
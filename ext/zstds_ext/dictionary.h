@@ -4,16 +4,53 @@
 #if !defined(ZSTDS_EXT_DICTIONARY_H)
 #define ZSTDS_EXT_DICTIONARY_H
 
-#include "ruby.h"
+#include <zstd.h>
 
+#include "ruby.h"
 #include "zstds_ext/macro.h"
 
 #define ZSTDS_EXT_DEFAULT_DICTIONARY_CAPACITY (1 << 17); // 128 KB
 #define ZSTDS_EXT_DEFAULT_DICTIONARY_MAX_SIZE ZSTDS_EXT_DEFAULT_DICTIONARY_CAPACITY
 
+typedef struct
+{
+  int         compression_level;
+  ZSTD_CDict* cdict;
+} zstds_ext_cdict_t;
+
+// Dictionary keeps digested dictionaries, they are created on demand.
+// Compressor dictionary is created for each compression level.
+
+typedef struct
+{
+  zstds_ext_cdict_t* cdicts;
+  size_t             cdicts_length;
+  ZSTD_DDict*        ddict;
+  size_t             digested_size;
+} zstds_ext_dictionary_t;
+
+VALUE zstds_ext_allocate_dictionary(VALUE klass);
+
+// These functions require GVL, they return NULL when dictionary can't be created.
+// Returned dictionary can be used while dictionary object is alive.
+
+ZSTD_CDict* zstds_ext_get_dictionary_cdict(VALUE self, int compression_level);
+ZSTD_DDict* zstds_ext_get_dictionary_ddict(VALUE self);
+
+// Returns total size of digested dictionaries created for current dictionary.
+VALUE zstds_ext_get_dictionary_digested_size(VALUE self);
+
 // -- training --
 
+// Returns buffer and params chosen by cover training (nil for default training).
 VALUE zstds_ext_train_dictionary_buffer(VALUE self, VALUE samples, VALUE options);
+VALUE zstds_ext_train_dictionary_concatenated_buffer(
+  VALUE self,
+  VALUE samples_buffer,
+  VALUE sample_sizes,
+  VALUE options);
+VALUE zstds_ext_train_dictionary_files_buffer(VALUE self, VALUE paths, VALUE options);
+VALUE zstds_ext_train_dictionary_reservoir_buffer(VALUE self, VALUE reservoir, VALUE options);
 
 // -- finalizing --
 
@@ -33,6 +70,8 @@ VALUE zstds_ext_get_dictionary_header_size(VALUE self, VALUE buffer);
 ZSTDS_EXT_NORETURN VALUE zstds_ext_get_dictionary_header_size(VALUE self, VALUE buffer);
 #endif // HAVE_ZDICT_HEADER_SIZE
 
+VALUE zstds_ext_get_dictionary_frame_id(VALUE self, VALUE source);
+
 void zstds_ext_dictionary_exports(VALUE root_module);
 
 #endif // ZSTDS_EXT_DICTIONARY_H
@@ -36,44 +36,71 @@ zstds_ext_result_t zstds_ext_get_error(ZSTD_ErrorCode error_code)
   }
 }
 
-static inline NORETURN(void raise_error(const char* name, const char* description))
+static inline void get_error_info(zstds_ext_result_t ext_result, const char** name_ptr, const char** description_ptr)
 {
-  VALUE module = rb_define_module(ZSTDS_EXT_MODULE_NAME);
-  VALUE error  = rb_const_get(module, rb_intern(name));
-  rb_raise(error, "%s", description);
-}
+#define SET_ERROR_INFO(name, description) \
+  *name_ptr        = name;                \
+  *description_ptr = description;         \
+  return;
 
-void zstds_ext_raise_error(zstds_ext_result_t ext_result)
-{
   switch (ext_result) {
     case ZSTDS_EXT_ERROR_ALLOCATE_FAILED:
-      raise_error("AllocateError", "allocate error");
+      SET_ERROR_INFO("AllocateError", "allocate error");
     case ZSTDS_EXT_ERROR_VALIDATE_FAILED:
-      raise_error("ValidateError", "validate error");
+      SET_ERROR_INFO("ValidateError", "validate error");
 
     case ZSTDS_EXT_ERROR_USED_AFTER_CLOSE:
-      raise_error("UsedAfterCloseError", "used after closed");
+      SET_ERROR_INFO("UsedAfterCloseError", "used after closed");
     case ZSTDS_EXT_ERROR_NOT_ENOUGH_SOURCE_BUFFER:
-      raise_error("NotEnoughSourceBufferError", "not enough source buffer");
+      SET_ERROR_INFO("NotEnoughSourceBufferError", "not enough source buffer");
     case ZSTDS_EXT_ERROR_NOT_ENOUGH_DESTINATION_BUFFER:
-      raise_error("NotEnoughDestinationBufferError", "not enough destination buffer");
+      SET_ERROR_INFO("NotEnoughDestinationBufferError", "not enough destination buffer");
     case ZSTDS_EXT_ERROR_DECOMPRESSOR_CORRUPTED_SOURCE:
-      raise_error("DecompressorCorruptedSourceError", "decompressor received corrupted source");
+      SET_ERROR_INFO("DecompressorCorruptedSourceError", "decompressor received corrupted source");
     case ZSTDS_EXT_ERROR_CORRUPTED_DICTIONARY:
-      raise_error("CorruptedDictionaryError", "corrupted dictionary");
+      SET_ERROR_INFO("CorruptedDictionaryError", "corrupted dictionary");
 
     case ZSTDS_EXT_ERROR_ACCESS_IO:
-      raise_error("AccessIOError", "failed to access IO");
+      SET_ERROR_INFO("AccessIOError", "failed to access IO");
     case ZSTDS_EXT_ERROR_READ_IO:
-      raise_error("ReadIOError", "failed to read IO");
+      SET_ERROR_INFO("ReadIOError", "failed to read IO");
     case ZSTDS_EXT_ERROR_WRITE_IO:
-      raise_error("WriteIOError", "failed to write IO");
+      SET_ERROR_INFO("WriteIOError", "failed to write IO");
 
     case ZSTDS_EXT_ERROR_NOT_IMPLEMENTED:
-      raise_error("NotImplementedError", "not implemented error");
+      SET_ERROR_INFO("NotImplementedError", "not implemented error");
 
     default:
       // ZSTDS_EXT_ERROR_UNEXPECTED
-      raise_error("UnexpectedError", "unexpected error");
+      SET_ERROR_INFO("UnexpectedError", "unexpected error");
   }
+
+#undef SET_ERROR_INFO
+}
+
+static inline VALUE get_error_class(const char* name)
+{
+  VALUE module = rb_define_module(ZSTDS_EXT_MODULE_NAME);
+
+  return rb_const_get(module, rb_intern(name));
+}
+
+VALUE zstds_ext_create_error(zstds_ext_result_t ext_result)
+{
+  const char* name;
+  const char* description;
+
+  get_error_info(ext_result, &name, &description);
+
+  return rb_exc_new_cstr(get_error_class(name), description);
+}
+
+void zstds_ext_raise_error(zstds_ext_result_t ext_result)
+{
+  const char* name;
+  const char* description;
+
+  get_error_info(ext_result, &name, &description);
+
+  rb_raise(get_error_class(name), "%s", description);
 }
@@ -32,6 +32,9 @@ enum
 
 zstds_ext_result_t zstds_ext_get_error(ZSTD_ErrorCode error_code);
 
+// Error object can be returned to user without raising.
+VALUE zstds_ext_create_error(zstds_ext_result_t ext_result);
+
 NORETURN(void zstds_ext_raise_error(zstds_ext_result_t ext_result));
 
 #endif // ZSTDS_EXT_ERROR_H
@@ -0,0 +1,76 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#include "zstds_ext/frame.h"
+
+#include <stdint.h>
+
+#include "zstds_ext/error.h"
+
+bool zstds_ext_get_decompressed_length(const char* source, size_t source_length, size_t* length_ptr)
+{
+  size_t length = 0;
+
+  while (source_length != 0) {
+    unsigned long long frame_length = ZSTD_getFrameContentSize(source, source_length);
+    if (
+      frame_length == ZSTD_CONTENTSIZE_UNKNOWN || frame_length == ZSTD_CONTENTSIZE_ERROR ||
+      frame_length > SIZE_MAX - length) {
+      return false;
+    }
+
+    size_t frame_source_length = ZSTD_findFrameCompressedSize(source, source_length);
+    if (ZSTD_isError(frame_source_length)) {
+      return false;
+    }
+
+    length += (size_t) frame_length;
+    source += frame_source_length;
+    source_length -= frame_source_length;
+  }
+
+  *length_ptr = length;
+
+  return true;
+}
+
+// Destination buffer can fit whole frame, so zstd will decompress it directly without intermediate buffer.
+// We can't use "ZSTD_decompressDCtx", old zstd versions ignore dictionary and window log max for it.
+
+zstds_ext_result_t zstds_ext_decompress_frames(
+  ZSTD_DCtx* ctx, const char* source, size_t source_length, char* destination, size_t destination_length)
+{
+  ZSTD_inBuffer  in_buffer  = {.src = source, .size = source_length, .pos = 0};
+  ZSTD_outBuffer out_buffer = {.dst = destination, .size = destination_length, .pos = 0};
+  zstds_result_t result     = 0;
+
+  while (in_buffer.pos != in_buffer.size) {
+    size_t in_buffer_pos  = in_buffer.pos;
+    size_t out_buffer_pos = out_buffer.pos;
+
+    result = ZSTD_decompressStream(ctx, &out_buffer, &in_buffer);
+    if (ZSTD_isError(result)) {
+      return zstds_ext_get_error(ZSTD_getErrorCode(result));
+    }
+
+    if (in_buffer.pos == in_buffer_pos && out_buffer.pos == out_buffer_pos) {
+      break;
+    }
+  }
+
+  if (result != 0 || in_buffer.pos != in_buffer.size || out_buffer.pos != out_buffer.size) {
+    return ZSTDS_EXT_ERROR_DECOMPRESSOR_CORRUPTED_SOURCE;
+  }
+
+  return 0;
+}
+
+void* zstds_ext_decompress_frames_wrapper(void* data)
+{
+  zstds_ext_decompress_frames_args_t* args = data;
+
+  args->ext_result = zstds_ext_decompress_frames(
+    args->ctx, args->source, args->source_length, args->destination, args->destination_length);
+
+  return NULL;
+}
@@ -0,0 +1,36 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#if !defined(ZSTDS_EXT_FRAME_H)
+#define ZSTDS_EXT_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <zstd.h>
+
+#include "zstds_ext/common.h"
+
+// Frame headers may provide decompressed length, skippable frame has zero length.
+// Returns false when any frame has unknown content size.
+
+bool zstds_ext_get_decompressed_length(const char* source, size_t source_length, size_t* length_ptr);
+
+// Decompresses all frames into destination with exact decompressed length.
+// These functions can be used without GVL.
+
+zstds_ext_result_t zstds_ext_decompress_frames(
+  ZSTD_DCtx* ctx, const char* source, size_t source_length, char* destination, size_t destination_length);
+
+typedef struct
+{
+  ZSTD_DCtx*         ctx;
+  const char*        source;
+  size_t             source_length;
+  char*              destination;
+  size_t             destination_length;
+  zstds_ext_result_t ext_result;
+} zstds_ext_decompress_frames_args_t;
+
+void* zstds_ext_decompress_frames_wrapper(void* data);
+
+#endif // ZSTDS_EXT_FRAME_H
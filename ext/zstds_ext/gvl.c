@@ -0,0 +1,462 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#include "zstds_ext/gvl.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+#include <zstd.h>
+
+#include "zstds_ext/error.h"
+#include "zstds_ext/macro.h"
+
+// Threshold is used only when ruby is able to release GVL.
+// It is read and written with GVL.
+
+#define DEFAULT_THRESHOLD (1 << 16) // 64 KB
+
+// Releasing of GVL should cost less than 1/32 of processing.
+#define RELEASE_COST_RATIO 32
+
+#define CALIBRATE_RELEASE_ITERATIONS 256
+#define CALIBRATE_SAMPLE_LENGTH      (1 << 16) // 64 KB
+
+static size_t threshold = DEFAULT_THRESHOLD;
+
+bool zstds_ext_keep_gvl(zstds_ext_gvl_t gvl, size_t length)
+{
+  return zstds_ext_keep_gvl_with_threshold(gvl, length, threshold);
+}
+
+size_t zstds_ext_get_gvl_threshold(void)
+{
+  return threshold;
+}
+
+bool zstds_ext_keep_gvl_with_threshold(zstds_ext_gvl_t gvl, size_t length, size_t custom_threshold)
+{
+  switch (gvl) {
+    case ZSTDS_EXT_GVL_KEEP:
+      return true;
+    case ZSTDS_EXT_GVL_AUTO:
+      return length < custom_threshold;
+    default:
+      return false;
+  }
+}
+
+// -- interrupts --
+
+static VALUE check_interrupts(VALUE yield)
+{
+  if (RTEST(yield)) {
+    // Scheduling checks interrupts too.
+    rb_thread_schedule();
+  } else {
+    rb_thread_check_ints();
+  }
+
+  return Qnil;
+}
+
+int zstds_ext_check_interrupts(bool yield)
+{
+  int state = 0;
+  rb_protect(check_interrupts, yield ? Qtrue : Qfalse, &state);
+
+  return state;
+}
+
+// -- job --
+
+#if defined(HAVE_RB_THREAD_CALL_WITHOUT_GVL)
+
+// Zstd can't stop training, so abandoned job keeps running until its function finishes.
+// New job waits while max abandoned jobs are running, repeated interrupts won't spawn unlimited jobs.
+
+#define MAX_ABANDONED_JOBS_LENGTH 2
+
+static pthread_mutex_t abandoned_jobs_mutex     = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  abandoned_jobs_condition = PTHREAD_COND_INITIALIZER;
+static size_t          abandoned_jobs_length    = 0;
+
+typedef struct
+{
+  pthread_mutex_t               mutex;
+  pthread_cond_t                condition;
+  zstds_ext_job_function_t      function;
+  void*                         data;
+  zstds_ext_job_free_function_t free_function;
+  bool                          is_finished;
+  bool                          is_interrupted;
+  bool                          is_abandoned;
+} job_t;
+
+static inline void free_job(job_t* job_ptr)
+{
+  pthread_cond_destroy(&job_ptr->condition);
+  pthread_mutex_destroy(&job_ptr->mutex);
+  free(job_ptr);
+}
+
+static void* run_job(void* data)
+{
+  job_t* job_ptr = data;
+  job_ptr->function(job_ptr->data);
+
+  pthread_mutex_lock(&job_ptr->mutex);
+  job_ptr->is_finished = true;
+  bool is_abandoned    = job_ptr->is_abandoned;
+  pthread_cond_signal(&job_ptr->condition);
+  pthread_mutex_unlock(&job_ptr->mutex);
+
+  if (is_abandoned) {
+    job_ptr->free_function(job_ptr->data);
+    free_job(job_ptr);
+
+    pthread_mutex_lock(&abandoned_jobs_mutex);
+    abandoned_jobs_length--;
+    pthread_cond_broadcast(&abandoned_jobs_condition);
+    pthread_mutex_unlock(&abandoned_jobs_mutex);
+  }
+
+  return NULL;
+}
+
+// Waiting for abandoned jobs is interruptible too.
+
+static void* wait_abandoned_jobs(void* data)
+{
+  bool* is_interrupted_ptr = data;
+
+  pthread_mutex_lock(&abandoned_jobs_mutex);
+  while (abandoned_jobs_length >= MAX_ABANDONED_JOBS_LENGTH && !*is_interrupted_ptr) {
+    pthread_cond_wait(&abandoned_jobs_condition, &abandoned_jobs_mutex);
+  }
+  pthread_mutex_unlock(&abandoned_jobs_mutex);
+
+  return NULL;
+}
+
+static void interrupt_abandoned_jobs_waiting(void* data)
+{
+  bool* is_interrupted_ptr = data;
+
+  pthread_mutex_lock(&abandoned_jobs_mutex);
+  *is_interrupted_ptr = true;
+  pthread_cond_broadcast(&abandoned_jobs_condition);
+  pthread_mutex_unlock(&abandoned_jobs_mutex);
+}
+
+static inline bool has_abandoned_jobs_slot(void)
+{
+  pthread_mutex_lock(&abandoned_jobs_mutex);
+  bool has_slot = abandoned_jobs_length < MAX_ABANDONED_JOBS_LENGTH;
+  pthread_mutex_unlock(&abandoned_jobs_mutex);
+
+  return has_slot;
+}
+
+// Returns protect state of raised exception.
+
+static inline int wait_abandoned_jobs_slot(void)
+{
+  while (!has_abandoned_jobs_slot()) {
+    bool is_interrupted = false;
+    rb_thread_call_without_gvl2(
+      wait_abandoned_jobs, &is_interrupted, interrupt_abandoned_jobs_waiting, &is_interrupted);
+
+    int state = zstds_ext_check_interrupts(false);
+    if (state != 0) {
+      return state;
+    }
+  }
+
+  return 0;
+}
+
+static void* wait_job(void* data)
+{
+  job_t* job_ptr = data;
+
+  pthread_mutex_lock(&job_ptr->mutex);
+  while (!job_ptr->is_finished && !job_ptr->is_interrupted) {
+    pthread_cond_wait(&job_ptr->condition, &job_ptr->mutex);
+  }
+  pthread_mutex_unlock(&job_ptr->mutex);
+
+  return NULL;
+}
+
+// Unblocking function is called by ruby when current thread receives interrupt.
+
+static void interrupt_job(void* data)
+{
+  job_t* job_ptr = data;
+
+  pthread_mutex_lock(&job_ptr->mutex);
+  job_ptr->is_interrupted = true;
+  pthread_cond_signal(&job_ptr->condition);
+  pthread_mutex_unlock(&job_ptr->mutex);
+}
+
+static inline job_t* create_job(
+  zstds_ext_job_function_t function, void* data, zstds_ext_job_free_function_t free_function)
+{
+  job_t* job_ptr = malloc(sizeof(job_t));
+  if (job_ptr == NULL) {
+    return NULL;
+  }
+
+  pthread_mutex_init(&job_ptr->mutex, NULL);
+  pthread_cond_init(&job_ptr->condition, NULL);
+
+  job_ptr->function       = function;
+  job_ptr->data           = data;
+  job_ptr->free_function  = free_function;
+  job_ptr->is_finished    = false;
+  job_ptr->is_interrupted = false;
+  job_ptr->is_abandoned   = false;
+
+  pthread_attr_t attributes;
+  pthread_attr_init(&attributes);
+  pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+  // Signals should be received by ruby threads only.
+  sigset_t signals, old_signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_SETMASK, &signals, &old_signals);
+
+  pthread_t thread;
+  int       result = pthread_create(&thread, &attributes, run_job, job_ptr);
+
+  pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+  pthread_attr_destroy(&attributes);
+
+  if (result != 0) {
+    free_job(job_ptr);
+    return NULL;
+  }
+
+  return job_ptr;
+}
+
+int zstds_ext_run_interruptible_job(
+  zstds_ext_job_function_t function, void* data, zstds_ext_job_free_function_t free_function)
+{
+  int state = wait_abandoned_jobs_slot();
+  if (state != 0) {
+    // Job was not started, data is freed here.
+    free_function(data);
+    return state;
+  }
+
+  job_t* job_ptr = create_job(function, data, free_function);
+  if (job_ptr == NULL) {
+    // Function can be used in current thread when separate thread is not available.
+    rb_thread_call_without_gvl(function, data, RUBY_UBF_IO, NULL);
+    return 0;
+  }
+
+  while (true) {
+    // Pending interrupt is not raised here, job should be abandoned before raise.
+    rb_thread_call_without_gvl2(wait_job, job_ptr, interrupt_job, job_ptr);
+
+    pthread_mutex_lock(&job_ptr->mutex);
+    bool is_finished        = job_ptr->is_finished;
+    job_ptr->is_interrupted = false;
+    pthread_mutex_unlock(&job_ptr->mutex);
+
+    if (is_finished) {
+      free_job(job_ptr);
+      return 0;
+    }
+
+    // Interrupt may not raise exception (for example signal trap), waiting will be continued in this case.
+    state = zstds_ext_check_interrupts(false);
+    if (state == 0) {
+      continue;
+    }
+
+    pthread_mutex_lock(&job_ptr->mutex);
+    is_finished           = job_ptr->is_finished;
+    job_ptr->is_abandoned = !is_finished;
+
+    // Job can't finish before abandoned job is counted.
+    if (!is_finished) {
+      pthread_mutex_lock(&abandoned_jobs_mutex);
+      abandoned_jobs_length++;
+      pthread_mutex_unlock(&abandoned_jobs_mutex);
+    }
+
+    pthread_mutex_unlock(&job_ptr->mutex);
+
+    if (is_finished) {
+      free_function(data);
+      free_job(job_ptr);
+    }
+
+    return state;
+  }
+}
+
+static inline size_t get_abandoned_jobs_length(void)
+{
+  pthread_mutex_lock(&abandoned_jobs_mutex);
+  size_t length = abandoned_jobs_length;
+  pthread_mutex_unlock(&abandoned_jobs_mutex);
+
+  return length;
+}
+
+#else
+
+int zstds_ext_run_interruptible_job(
+  zstds_ext_job_function_t function, void* data, zstds_ext_job_free_function_t ZSTDS_EXT_UNUSED(free_function))
+{
+  function(data);
+
+  return 0;
+}
+
+static inline size_t get_abandoned_jobs_length(void)
+{
+  return 0;
+}
+
+#endif // HAVE_RB_THREAD_CALL_WITHOUT_GVL
+
+// -- calibrate --
+
+#if defined(HAVE_RB_THREAD_CALL_WITHOUT_GVL)
+
+static inline double get_time(void)
+{
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+
+  return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
+
+static void* release_wrapper(void* data)
+{
+  return data;
+}
+
+static inline double get_release_time(void)
+{
+  double start_time = get_time();
+
+  for (size_t index = 0; index < CALIBRATE_RELEASE_ITERATIONS; index++) {
+    rb_thread_call_without_gvl(release_wrapper, NULL, RUBY_UBF_IO, NULL);
+  }
+
+  return (get_time() - start_time) / CALIBRATE_RELEASE_ITERATIONS;
+}
+
+// Sample looks like text: small alphabet with pseudo random order.
+// Returns negative time when sample can't be compressed.
+
+static inline double get_compress_time(void)
+{
+  size_t destination_length = ZSTD_compressBound(CALIBRATE_SAMPLE_LENGTH);
+  char*  buffer             = malloc(CALIBRATE_SAMPLE_LENGTH + destination_length);
+  if (buffer == NULL) {
+    return -1;
+  }
+
+  char*    source = buffer;
+  uint32_t seed   = 1;
+
+  for (size_t index = 0; index < CALIBRATE_SAMPLE_LENGTH; index++) {
+    seed          = seed * 1103515245 + 12345;
+    source[index] = "etaoin shrdlu\n"[(seed >> 16) % 14];
+  }
+
+  double         start_time = get_time();
+  zstds_result_t result     = ZSTD_compress(
+    buffer + CALIBRATE_SAMPLE_LENGTH, destination_length, source, CALIBRATE_SAMPLE_LENGTH, ZSTD_CLEVEL_DEFAULT);
+  double compress_time = get_time() - start_time;
+
+  free(buffer);
+
+  return ZSTD_isError(result) ? -1 : compress_time;
+}
+
+static inline size_t calibrate(void)
+{
+  double release_time  = get_release_time();
+  double compress_time = get_compress_time();
+  if (release_time <= 0 || compress_time <= 0) {
+    return DEFAULT_THRESHOLD;
+  }
+
+  double length = release_time * RELEASE_COST_RATIO * CALIBRATE_SAMPLE_LENGTH / compress_time;
+  if (length < ZSTDS_EXT_GVL_MIN_THRESHOLD) {
+    return ZSTDS_EXT_GVL_MIN_THRESHOLD;
+  } else if (length > ZSTDS_EXT_GVL_MAX_THRESHOLD) {
+    return ZSTDS_EXT_GVL_MAX_THRESHOLD;
+  }
+
+  return (size_t) length;
+}
+
+#else
+
+static inline size_t calibrate(void)
+{
+  return DEFAULT_THRESHOLD;
+}
+
+#endif // HAVE_RB_THREAD_CALL_WITHOUT_GVL
+
+// -- exports --
+
+static VALUE get_threshold(VALUE ZSTDS_EXT_UNUSED(self))
+{
+  return SIZET2NUM(threshold);
+}
+
+static VALUE set_threshold(VALUE ZSTDS_EXT_UNUSED(self), VALUE value)
+{
+  Check_Type(value, T_FIXNUM);
+
+  // Threshold should be between calibration bounds, negative value can't be converted.
+  long long_value = FIX2LONG(value);
+  if (long_value < ZSTDS_EXT_GVL_MIN_THRESHOLD || long_value > ZSTDS_EXT_GVL_MAX_THRESHOLD) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  threshold = (size_t) long_value;
+
+  return value;
+}
+
+static VALUE calibrate_threshold(VALUE ZSTDS_EXT_UNUSED(self))
+{
+  threshold = calibrate();
+
+  return SIZET2NUM(threshold);
+}
+
+static VALUE get_abandoned_jobs(VALUE ZSTDS_EXT_UNUSED(self))
+{
+  return SIZET2NUM(get_abandoned_jobs_length());
+}
+
+void zstds_ext_gvl_exports(VALUE root_module)
+{
+  threshold = calibrate();
+
+  VALUE module = rb_define_module_under(root_module, "GVL");
+
+  rb_define_const(module, "MIN_THRESHOLD", SIZET2NUM(ZSTDS_EXT_GVL_MIN_THRESHOLD));
+  rb_define_const(module, "MAX_THRESHOLD", SIZET2NUM(ZSTDS_EXT_GVL_MAX_THRESHOLD));
+
+  rb_define_module_function(module, "threshold", RUBY_METHOD_FUNC(get_threshold), 0);
+  rb_define_module_function(module, "threshold=", RUBY_METHOD_FUNC(set_threshold), 1);
+  rb_define_module_function(module, "calibrate", RUBY_METHOD_FUNC(calibrate_threshold), 0);
+  rb_define_module_function(module, "abandoned_jobs", RUBY_METHOD_FUNC(get_abandoned_jobs), 0);
+}
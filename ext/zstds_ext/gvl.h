@@ -4,15 +4,31 @@
 #if !defined(ZSTDS_EXT_GVL_H)
 #define ZSTDS_EXT_GVL_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ruby.h"
+#include "zstds_ext/common.h"
+
 #if defined(HAVE_RB_THREAD_CALL_WITHOUT_GVL)
 
 #include "ruby/thread.h"
 
-#define ZSTDS_EXT_GVL_WRAP(gvl, function, data)                            \
-  if (gvl) {                                                               \
-    function((void*) data);                                                \
-  } else {                                                                 \
-    rb_thread_call_without_gvl(function, (void*) data, RUBY_UBF_IO, NULL); \
+#if defined(RB_NOGVL_OFFLOAD_SAFE)
+// Fiber scheduler can run function in separate thread, so other fibers won't be blocked.
+#define ZSTDS_EXT_CALL_WITHOUT_GVL(function, data) \
+  rb_nogvl(function, (void*) data, RUBY_UBF_IO, NULL, RB_NOGVL_OFFLOAD_SAFE);
+#else
+#define ZSTDS_EXT_CALL_WITHOUT_GVL(function, data) \
+  rb_thread_call_without_gvl(function, (void*) data, RUBY_UBF_IO, NULL);
+#endif // RB_NOGVL_OFFLOAD_SAFE
+
+#define ZSTDS_EXT_GVL_WRAP(gvl, function, data) \
+  if (gvl) {                                    \
+    function((void*) data);                     \
+  } else {                                      \
+    ZSTDS_EXT_CALL_WITHOUT_GVL(function, data); \
   }
 
 #else
@@ -21,4 +37,46 @@
 
 #endif // HAVE_RB_THREAD_CALL_WITHOUT_GVL
 
+// Auto mode keeps GVL when processed length is less than threshold.
+// Threshold is calibrated on load: releasing of GVL should cost less than small part of processing.
+
+enum
+{
+  ZSTDS_EXT_GVL_RELEASE = 1,
+  ZSTDS_EXT_GVL_KEEP,
+  ZSTDS_EXT_GVL_AUTO
+};
+
+typedef zstds_ext_byte_fast_t zstds_ext_gvl_t;
+
+// Operation that may block (file descriptor read or write) has unknown length.
+#define ZSTDS_EXT_GVL_UNKNOWN_LENGTH SIZE_MAX
+
+#define ZSTDS_EXT_GVL_MIN_THRESHOLD (1 << 10) // 1 KB
+#define ZSTDS_EXT_GVL_MAX_THRESHOLD (1 << 20) // 1 MB
+
+bool   zstds_ext_keep_gvl(zstds_ext_gvl_t gvl, size_t length);
+size_t zstds_ext_get_gvl_threshold(void);
+
+// Auto mode can use custom threshold instead of calibrated one.
+bool zstds_ext_keep_gvl_with_threshold(zstds_ext_gvl_t gvl, size_t length, size_t threshold);
+
+// Long running processing is split into slices, interrupts are checked between slices.
+// Returns protect state of raised exception, caller should free its resources and use "rb_jump_tag".
+// Yield allows other threads to acquire GVL.
+int zstds_ext_check_interrupts(bool yield);
+
+typedef void* (*zstds_ext_job_function_t)(void* data);
+typedef void (*zstds_ext_job_free_function_t)(void* data);
+
+// Function that can't be split into slices runs in separate thread, current thread waits for it without GVL.
+// Interrupt stops waiting: job is abandoned and data is freed after function finishes.
+// Abandoned job keeps running, new job waits while max abandoned jobs are running.
+// Function data should not reference ruby objects.
+// Returns protect state of raised exception, data is owned by job in this case.
+int zstds_ext_run_interruptible_job(
+  zstds_ext_job_function_t function, void* data, zstds_ext_job_free_function_t free_function);
+
+void zstds_ext_gvl_exports(VALUE root_module);
+
 #endif // ZSTDS_EXT_GVL_H
@@ -3,52 +3,229 @@
 
 #include "zstds_ext/io.h"
 
-#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <zstd.h>
 
-#include "ruby/io.h"
+#include "zstds_ext/batch.h"
+#include "zstds_ext/context_pool.h"
 #include "zstds_ext/error.h"
+#include "zstds_ext/frame.h"
 #include "zstds_ext/gvl.h"
 #include "zstds_ext/macro.h"
 #include "zstds_ext/option.h"
+#include "zstds_ext/pipeline.h"
+#include "ruby/io.h"
+
+#if defined(HAVE_RB_FIBER_SCHEDULER_CURRENT)
+#include "ruby/fiber/scheduler.h"
+#endif
 
 // Additional possible results:
 enum
 {
-  ZSTDS_EXT_FILE_READ_FINISHED = 128
+  ZSTDS_EXT_FILE_READ_FINISHED = 128,
+  ZSTDS_EXT_FILE_NOT_MAPPED,
+  ZSTDS_EXT_FILE_NOT_READY,
+  ZSTDS_EXT_FILE_INTERRUPTED,
+  ZSTDS_EXT_FILE_WAIT_INTERRUPTED
 };
 
 // -- file --
 
-static inline zstds_ext_result_t
-  read_file(FILE* source_file, zstds_ext_byte_t* source_buffer, size_t* source_length_ptr, size_t source_buffer_length)
+// Source and destination are accessed using file descriptors without stdio buffering.
+// Descriptor may be non blocking (pipe, socket), so we have to wait until it will be ready.
+// Reading and writing without GVL won't wait or retry after signal, so interrupts are processed with GVL.
+
+static inline bool has_fiber_scheduler(void)
 {
-  size_t read_length = fread(source_buffer, 1, source_buffer_length, source_file);
-  if (read_length == 0 && feof(source_file)) {
-    return ZSTDS_EXT_FILE_READ_FINISHED;
-  }
+#if defined(HAVE_RB_FIBER_SCHEDULER_CURRENT)
+  return rb_fiber_scheduler_current() != Qnil;
+#else
+  return false;
+#endif
+}
 
-  if (read_length != source_buffer_length && ferror(source_file)) {
-    return ZSTDS_EXT_ERROR_READ_IO;
+typedef struct
+{
+  int                fd;
+  zstds_ext_byte_t*  buffer;
+  size_t             length;
+  int                state;
+  zstds_ext_result_t ext_result;
+} file_args_t;
+
+typedef struct
+{
+  int fd;
+  int events;
+} wait_args_t;
+
+static VALUE wait_fd(VALUE data)
+{
+  wait_args_t* args = (wait_args_t*) data;
+
+  // Error or hang up will be received by next read or write.
+  rb_wait_for_single_fd(args->fd, args->events, NULL);
+
+  return Qnil;
+}
+
+// Ruby waits for descriptor without GVL and can interrupt waiting, fiber scheduler lets other fibers run.
+// Protect state of exception raised while waiting will be stored, it will be raised again after release of resources.
+
+static inline zstds_ext_result_t wait_file(file_args_t* file_args_ptr, int events)
+{
+  wait_args_t args = {.fd = file_args_ptr->fd, .events = events};
+
+  rb_protect(wait_fd, (VALUE) &args, &file_args_ptr->state);
+  if (file_args_ptr->state != 0) {
+    return ZSTDS_EXT_FILE_WAIT_INTERRUPTED;
   }
 
-  *source_length_ptr = read_length;
+  return 0;
+}
+
+// Signal has interrupted reading or writing, ruby may raise exception (Thread#raise, Timeout, signal trap).
+
+static inline zstds_ext_result_t check_file_interrupts(file_args_t* file_args_ptr)
+{
+  file_args_ptr->state = zstds_ext_check_interrupts(false);
+  if (file_args_ptr->state != 0) {
+    return ZSTDS_EXT_FILE_WAIT_INTERRUPTED;
+  }
 
   return 0;
 }
 
-static inline zstds_ext_result_t
-  write_file(FILE* destination_file, zstds_ext_byte_t* destination_buffer, size_t destination_length)
+static inline zstds_ext_result_t process_file_result(file_args_t* file_args_ptr, int events, int* state_ptr)
+{
+  zstds_ext_result_t ext_result;
+
+  if (file_args_ptr->ext_result == ZSTDS_EXT_FILE_NOT_READY) {
+    ext_result = wait_file(file_args_ptr, events);
+  } else {
+    ext_result = check_file_interrupts(file_args_ptr);
+  }
+
+  if (ext_result != 0) {
+    *state_ptr = file_args_ptr->state;
+  }
+
+  return ext_result;
+}
+
+static inline void* read_file_wrapper(void* data)
+{
+  file_args_t* args = data;
+
+  ssize_t read_length = read(args->fd, args->buffer, args->length);
+  if (read_length > 0) {
+    args->length     = read_length;
+    args->ext_result = 0;
+  } else if (read_length == 0) {
+    args->ext_result = ZSTDS_EXT_FILE_READ_FINISHED;
+  } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+    args->ext_result = ZSTDS_EXT_FILE_NOT_READY;
+  } else if (errno == EINTR) {
+    args->ext_result = ZSTDS_EXT_FILE_INTERRUPTED;
+  } else {
+    args->ext_result = ZSTDS_EXT_ERROR_READ_IO;
+  }
+
+  return NULL;
+}
+
+static inline zstds_ext_result_t read_file(
+  int               source_fd,
+  zstds_ext_byte_t* source_buffer,
+  size_t*           source_length_ptr,
+  size_t            source_buffer_length,
+  bool              gvl,
+  int*              state_ptr)
 {
-  size_t written_length = fwrite(destination_buffer, 1, destination_length, destination_file);
-  if (written_length != destination_length) {
-    return ZSTDS_EXT_ERROR_WRITE_IO;
+  file_args_t args = {.fd = source_fd, .buffer = source_buffer, .length = source_buffer_length, .state = 0};
+
+  while (true) {
+    ZSTDS_EXT_GVL_WRAP(gvl, read_file_wrapper, &args);
+    if (args.ext_result != ZSTDS_EXT_FILE_NOT_READY && args.ext_result != ZSTDS_EXT_FILE_INTERRUPTED) {
+      break;
+    }
+
+    zstds_ext_result_t ext_result = process_file_result(&args, RB_WAITFD_IN, state_ptr);
+    if (ext_result != 0) {
+      return ext_result;
+    }
   }
 
+  if (args.ext_result != 0) {
+    return args.ext_result;
+  }
+
+  *source_length_ptr = args.length;
+
   return 0;
 }
 
+// Descriptor may accept only a part of data, we need to write remaining data again.
+
+static inline void* write_file_wrapper(void* data)
+{
+  file_args_t* args = data;
+
+  while (args->length != 0) {
+    ssize_t written_length = write(args->fd, args->buffer, args->length);
+    if (written_length >= 0) {
+      args->buffer += written_length;
+      args->length -= written_length;
+      continue;
+    }
+
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      args->ext_result = ZSTDS_EXT_FILE_NOT_READY;
+    } else if (errno == EINTR) {
+      args->ext_result = ZSTDS_EXT_FILE_INTERRUPTED;
+    } else {
+      args->ext_result = ZSTDS_EXT_ERROR_WRITE_IO;
+    }
+
+    return NULL;
+  }
+
+  args->ext_result = 0;
+
+  return NULL;
+}
+
+static inline zstds_ext_result_t write_file(
+  int               destination_fd,
+  zstds_ext_byte_t* destination_buffer,
+  size_t            destination_length,
+  bool              gvl,
+  int*              state_ptr)
+{
+  file_args_t args = {.fd = destination_fd, .buffer = destination_buffer, .length = destination_length, .state = 0};
+
+  while (true) {
+    ZSTDS_EXT_GVL_WRAP(gvl, write_file_wrapper, &args);
+    if (args.ext_result != ZSTDS_EXT_FILE_NOT_READY && args.ext_result != ZSTDS_EXT_FILE_INTERRUPTED) {
+      break;
+    }
+
+    zstds_ext_result_t ext_result = process_file_result(&args, RB_WAITFD_OUT, state_ptr);
+    if (ext_result != 0) {
+      return ext_result;
+    }
+  }
+
+  return args.ext_result;
+}
+
 // -- buffer --
 
 static inline zstds_ext_result_t create_buffers(
@@ -81,11 +258,13 @@ static inline zstds_ext_result_t create_buffers(
 // Algorithm can use same buffer again.
 
 static inline zstds_ext_result_t read_more_source(
-  FILE*                    source_file,
+  int                      source_fd,
   const zstds_ext_byte_t** source_ptr,
   size_t*                  source_length_ptr,
   zstds_ext_byte_t*        source_buffer,
-  size_t                   source_buffer_length)
+  size_t                   source_buffer_length,
+  bool                     gvl,
+  int*                     state_ptr)
 {
   const zstds_ext_byte_t* source        = *source_ptr;
   size_t                  source_length = *source_length_ptr;
@@ -109,7 +288,7 @@ static inline zstds_ext_result_t read_more_source(
   size_t            new_source_length;
 
   zstds_ext_result_t ext_result =
-    read_file(source_file, remaining_source_buffer, &new_source_length, remaining_source_buffer_length);
+    read_file(source_fd, remaining_source_buffer, &new_source_length, remaining_source_buffer_length, gvl, state_ptr);
 
   if (ext_result != 0) {
     return ext_result;
@@ -120,37 +299,38 @@ static inline zstds_ext_result_t read_more_source(
   return 0;
 }
 
-#define BUFFERED_READ_SOURCE(function, ...)                                                                     \
-  do {                                                                                                          \
-    bool is_function_called = false;                                                                            \
-                                                                                                                \
-    while (true) {                                                                                              \
-      ext_result = read_more_source(source_file, &source, &source_length, source_buffer, source_buffer_length); \
-      if (ext_result == ZSTDS_EXT_FILE_READ_FINISHED) {                                                         \
-        if (source_length != 0) {                                                                               \
-          /* ZSTD won't provide any remainder by design. */                                                     \
-          return ZSTDS_EXT_ERROR_READ_IO;                                                                       \
-        }                                                                                                       \
-        break;                                                                                                  \
-      } else if (ext_result != 0) {                                                                             \
-        return ext_result;                                                                                      \
-      }                                                                                                         \
-                                                                                                                \
-      ext_result = function(__VA_ARGS__);                                                                       \
-      if (ext_result != 0) {                                                                                    \
-        return ext_result;                                                                                      \
-      }                                                                                                         \
-                                                                                                                \
-      is_function_called = true;                                                                                \
-    }                                                                                                           \
-                                                                                                                \
-    if (!is_function_called) {                                                                                  \
-      /* Function should be called at least once. */                                                            \
-      ext_result = function(__VA_ARGS__);                                                                       \
-      if (ext_result != 0) {                                                                                    \
-        return ext_result;                                                                                      \
-      }                                                                                                         \
-    }                                                                                                           \
+#define BUFFERED_READ_SOURCE(function, ...)                                                                        \
+  do {                                                                                                             \
+    bool is_function_called = false;                                                                               \
+                                                                                                                   \
+    while (true) {                                                                                                 \
+      ext_result =                                                                                                 \
+        read_more_source(source_fd, &source, &source_length, source_buffer, source_buffer_length, gvl, state_ptr); \
+      if (ext_result == ZSTDS_EXT_FILE_READ_FINISHED) {                                                            \
+        if (source_length != 0) {                                                                                  \
+          /* ZSTD won't provide any remainder by design. */                                                        \
+          return ZSTDS_EXT_ERROR_READ_IO;                                                                          \
+        }                                                                                                          \
+        break;                                                                                                     \
+      } else if (ext_result != 0) {                                                                                \
+        return ext_result;                                                                                         \
+      }                                                                                                            \
+                                                                                                                   \
+      ext_result = function(__VA_ARGS__);                                                                          \
+      if (ext_result != 0) {                                                                                       \
+        return ext_result;                                                                                         \
+      }                                                                                                            \
+                                                                                                                   \
+      is_function_called = true;                                                                                   \
+    }                                                                                                              \
+                                                                                                                   \
+    if (!is_function_called) {                                                                                     \
+      /* Function should be called at least once. */                                                               \
+      ext_result = function(__VA_ARGS__);                                                                          \
+      if (ext_result != 0) {                                                                                       \
+        return ext_result;                                                                                         \
+      }                                                                                                            \
+    }                                                                                                              \
   } while (false);
 
 // Algorithm has written data into destination buffer.
@@ -158,17 +338,20 @@ static inline zstds_ext_result_t read_more_source(
 // Than algorithm can use same buffer again.
 
 static inline zstds_ext_result_t flush_destination_buffer(
-  FILE*             destination_file,
+  int               destination_fd,
   zstds_ext_byte_t* destination_buffer,
   size_t*           destination_length_ptr,
-  size_t            destination_buffer_length)
+  size_t            destination_buffer_length,
+  bool              gvl,
+  int*              state_ptr)
 {
   if (*destination_length_ptr == 0) {
     // We want to write more data at once, than buffer has.
     return ZSTDS_EXT_ERROR_NOT_ENOUGH_DESTINATION_BUFFER;
   }
 
-  zstds_ext_result_t ext_result = write_file(destination_file, destination_buffer, *destination_length_ptr);
+  zstds_ext_result_t ext_result =
+    write_file(destination_fd, destination_buffer, *destination_length_ptr, gvl, state_ptr);
   if (ext_result != 0) {
     return ext_result;
   }
@@ -178,29 +361,277 @@ static inline zstds_ext_result_t flush_destination_buffer(
   return 0;
 }
 
-static inline zstds_ext_result_t
-  write_remaining_destination(FILE* destination_file, zstds_ext_byte_t* destination_buffer, size_t destination_length)
+static inline zstds_ext_result_t write_remaining_destination(
+  int               destination_fd,
+  zstds_ext_byte_t* destination_buffer,
+  size_t            destination_length,
+  bool              gvl,
+  int*              state_ptr)
 {
   if (destination_length == 0) {
     return 0;
   }
 
-  return write_file(destination_file, destination_buffer, destination_length);
+  return write_file(destination_fd, destination_buffer, destination_length, gvl, state_ptr);
+}
+
+// -- mmap --
+
+// Regular file can be mapped into memory, so algorithm can process it without intermediate buffer.
+// Mapping is optional, buffered processing will be used when file can't be mapped.
+
+typedef struct
+{
+  zstds_ext_byte_t* data;
+  size_t            length;
+  void*             map;
+  size_t            map_length;
+} mapped_file_t;
+
+static inline bool get_regular_file_offset(int fd, size_t* offset_ptr, size_t* size_ptr)
+{
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || (uintmax_t) file_stat.st_size > SIZE_MAX) {
+    return false;
+  }
+
+  off_t offset = lseek(fd, 0, SEEK_CUR);
+  if (offset < 0) {
+    return false;
+  }
+
+  *offset_ptr = offset;
+  *size_ptr   = file_stat.st_size;
+
+  return true;
+}
+
+// Source is mapped from file start, because map offset should be aligned by page size.
+
+static inline bool map_source_file(int fd, mapped_file_t* mapped_file_ptr)
+{
+  size_t offset, size;
+  if (!get_regular_file_offset(fd, &offset, &size) || offset >= size) {
+    return false;
+  }
+
+  void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+
+  // Advice is optional, it just increases read ahead.
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  mapped_file_ptr->data       = (zstds_ext_byte_t*) map + offset;
+  mapped_file_ptr->length     = size - offset;
+  mapped_file_ptr->map        = map;
+  mapped_file_ptr->map_length = size;
+
+  return true;
+}
+
+static inline void unmap_source_file(int fd, const mapped_file_t* mapped_file_ptr)
+{
+  munmap(mapped_file_ptr->map, mapped_file_ptr->map_length);
+
+  // Source has been consumed, same as after reading.
+  lseek(fd, 0, SEEK_END);
+}
+
+// Destination file will be extended to exact length, descriptor should be opened for both reading and writing.
+
+static inline bool map_destination_file(int fd, size_t length, mapped_file_t* mapped_file_ptr)
+{
+  size_t offset, size;
+  if (length == 0 || !get_regular_file_offset(fd, &offset, &size) || length > SIZE_MAX - offset) {
+    return false;
+  }
+
+  size_t map_length = offset + length;
+  if ((off_t) map_length < 0 || ftruncate(fd, (off_t) map_length) != 0) {
+    return false;
+  }
+
+  void* map = mmap(NULL, map_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    ftruncate(fd, (off_t) size);
+    return false;
+  }
+
+  madvise(map, map_length, MADV_SEQUENTIAL);
+
+  mapped_file_ptr->data       = (zstds_ext_byte_t*) map + offset;
+  mapped_file_ptr->length     = length;
+  mapped_file_ptr->map        = map;
+  mapped_file_ptr->map_length = map_length;
+
+  return true;
+}
+
+static inline void unmap_destination_file(int fd, const mapped_file_t* mapped_file_ptr, bool is_written)
+{
+  munmap(mapped_file_ptr->map, mapped_file_ptr->map_length);
+
+  size_t offset = mapped_file_ptr->map_length - mapped_file_ptr->length;
+
+  if (is_written) {
+    lseek(fd, (off_t) mapped_file_ptr->map_length, SEEK_SET);
+  } else {
+    // Destination shouldn't contain invalid data.
+    ftruncate(fd, (off_t) offset);
+  }
+}
+
+// Reference file is mapped for whole processing of single frame, empty reference is not mapped.
+
+static inline zstds_ext_result_t map_reference_file(const char* path, mapped_file_t* mapped_file_ptr)
+{
+  mapped_file_ptr->data       = NULL;
+  mapped_file_ptr->length     = 0;
+  mapped_file_ptr->map        = NULL;
+  mapped_file_ptr->map_length = 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return ZSTDS_EXT_ERROR_ACCESS_IO;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || (uintmax_t) file_stat.st_size > SIZE_MAX) {
+    close(fd);
+    return ZSTDS_EXT_ERROR_ACCESS_IO;
+  }
+
+  size_t size = file_stat.st_size;
+  if (size == 0) {
+    close(fd);
+    return 0;
+  }
+
+  void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // Mapping keeps file data available after closing of descriptor.
+  close(fd);
+
+  if (map == MAP_FAILED) {
+    return ZSTDS_EXT_ERROR_READ_IO;
+  }
+
+  mapped_file_ptr->data       = map;
+  mapped_file_ptr->length     = size;
+  mapped_file_ptr->map        = map;
+  mapped_file_ptr->map_length = size;
+
+  return 0;
+}
+
+static inline void unmap_reference_file(const mapped_file_t* mapped_file_ptr)
+{
+  if (mapped_file_ptr->map != NULL) {
+    munmap(mapped_file_ptr->map, mapped_file_ptr->map_length);
+  }
 }
 
 // -- utils --
 
-#define GET_FILE(target)                               \
-  Check_Type(target, T_FILE);                          \
-                                                       \
-  rb_io_t* target##_io;                                \
-  GetOpenFile(target, target##_io);                    \
-                                                       \
-  FILE* target##_file = rb_io_stdio_file(target##_io); \
-  if (target##_file == NULL) {                         \
-    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ACCESS_IO);  \
+// Any IO with file descriptor can be used as source or destination.
+
+static inline int get_fd(VALUE target)
+{
+  if (!rb_respond_to(target, rb_intern("fileno"))) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ACCESS_IO);
+  }
+
+  VALUE fd_value = rb_funcall(target, rb_intern("fileno"), 0);
+  if (!RB_INTEGER_TYPE_P(fd_value)) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ACCESS_IO);
+  }
+
+  int fd = NUM2INT(fd_value);
+  if (fd < 0) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ACCESS_IO);
+  }
+
+  return fd;
+}
+
+#define GET_FD(target) int target##_fd = get_fd(target);
+
+// Data buffered by ruby IO can't be read from descriptor, it would be lost.
+
+static inline void check_pending_source(VALUE source)
+{
+  if (!RB_TYPE_P(source, T_FILE)) {
+    return;
+  }
+
+  rb_io_t* source_io;
+  GetOpenFile(source, source_io);
+
+  if (rb_io_read_pending(source_io)) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+}
+
+// Data buffered by ruby IO should be written before data written into descriptor.
+
+#define FLUSH_IO(target)                            \
+  if (rb_respond_to(target, rb_intern("flush"))) { \
+    rb_funcall(target, rb_intern("flush"), 0);     \
+  }
+
+zstds_ext_result_t
+  zstds_ext_write_io(VALUE io, const zstds_ext_byte_t* data, size_t length, bool gvl, int* state_ptr)
+{
+  GET_FD(io);
+  FLUSH_IO(io);
+
+  if (length == 0) {
+    return 0;
+  }
+
+  return write_file(io_fd, (zstds_ext_byte_t*) data, length, gvl, state_ptr);
+}
+
+// -- pipeline --
+
+// Pipeline runs without GVL, interrupt of current thread cancels it.
+// Pending exception will be raised after release of pipeline and other resources.
+
+static void interrupt_pipeline(void* data)
+{
+  zstds_ext_interrupt_pipeline(data);
+}
+
+static inline void run_pipeline(void* (*function)(void*), void* data, zstds_ext_pipeline_t* pipeline_ptr, bool gvl)
+{
+#if defined(HAVE_RB_THREAD_CALL_WITHOUT_GVL)
+  if (!gvl) {
+    // Function won't be called when interrupt is pending, so its result should be interrupted by default.
+    rb_thread_call_without_gvl2(function, data, interrupt_pipeline, pipeline_ptr);
+    return;
+  }
+#endif
+
+  function(data);
+}
+
+static inline zstds_ext_result_t get_pipeline_result(zstds_ext_result_t ext_result, int* state_ptr)
+{
+  if (ext_result != ZSTDS_EXT_PIPELINE_INTERRUPTED) {
+    return ext_result;
+  }
+
+  *state_ptr = zstds_ext_check_interrupts(false);
+  if (*state_ptr != 0) {
+    return ZSTDS_EXT_FILE_WAIT_INTERRUPTED;
   }
 
+  // Interrupt without exception (signal trap) can't resume cancelled pipeline.
+  return ZSTDS_EXT_ERROR_UNEXPECTED;
+}
+
 // -- buffered compress --
 
 typedef struct
@@ -224,11 +655,12 @@ static inline zstds_ext_result_t buffered_compress(
   ZSTD_CCtx*               ctx,
   const zstds_ext_byte_t** source_ptr,
   size_t*                  source_length_ptr,
-  FILE*                    destination_file,
+  int                      destination_fd,
   zstds_ext_byte_t*        destination_buffer,
   size_t*                  destination_length_ptr,
   size_t                   destination_buffer_length,
-  bool                     gvl)
+  bool                     gvl,
+  int*                     state_ptr)
 {
   zstds_ext_result_t ext_result;
   ZSTD_inBuffer      in_buffer = {.src = *source_ptr, .size = *source_length_ptr, .pos = 0};
@@ -251,7 +683,7 @@ static inline zstds_ext_result_t buffered_compress(
 
     if (*destination_length_ptr == destination_buffer_length) {
       ext_result = flush_destination_buffer(
-        destination_file, destination_buffer, destination_length_ptr, destination_buffer_length);
+        destination_fd, destination_buffer, destination_length_ptr, destination_buffer_length, gvl, state_ptr);
 
       if (ext_result != 0) {
         return ext_result;
@@ -288,16 +720,21 @@ static inline void* compressor_finish_wrapper(void* data)
   return NULL;
 }
 
+// Compressor can receive remaining source, it will be compressed with frame finish.
+
 static inline zstds_ext_result_t buffered_compressor_finish(
-  ZSTD_CCtx*        ctx,
-  FILE*             destination_file,
-  zstds_ext_byte_t* destination_buffer,
-  size_t*           destination_length_ptr,
-  size_t            destination_buffer_length,
-  bool              gvl)
+  ZSTD_CCtx*              ctx,
+  const zstds_ext_byte_t* source,
+  size_t                  source_length,
+  int                     destination_fd,
+  zstds_ext_byte_t*       destination_buffer,
+  size_t*                 destination_length_ptr,
+  size_t                  destination_buffer_length,
+  bool                    gvl,
+  int*                    state_ptr)
 {
   zstds_ext_result_t       ext_result;
-  ZSTD_inBuffer            in_buffer = {in_buffer.src = NULL, in_buffer.size = 0, in_buffer.pos = 0};
+  ZSTD_inBuffer            in_buffer = {in_buffer.src = source, in_buffer.size = source_length, in_buffer.pos = 0};
   compressor_finish_args_t args      = {.ctx = ctx, .in_buffer_ptr = &in_buffer};
 
   while (true) {
@@ -317,7 +754,7 @@ static inline zstds_ext_result_t buffered_compressor_finish(
 
     if (args.result != 0) {
       ext_result = flush_destination_buffer(
-        destination_file, destination_buffer, destination_length_ptr, destination_buffer_length);
+        destination_fd, destination_buffer, destination_length_ptr, destination_buffer_length, gvl, state_ptr);
 
       if (ext_result != 0) {
         return ext_result;
@@ -336,13 +773,14 @@ static inline zstds_ext_result_t buffered_compressor_finish(
 
 static inline zstds_ext_result_t compress(
   ZSTD_CCtx*        ctx,
-  FILE*             source_file,
+  int               source_fd,
   zstds_ext_byte_t* source_buffer,
   size_t            source_buffer_length,
-  FILE*             destination_file,
+  int               destination_fd,
   zstds_ext_byte_t* destination_buffer,
   size_t            destination_buffer_length,
-  bool              gvl)
+  bool              gvl,
+  int*              state_ptr)
 {
   zstds_ext_result_t      ext_result;
   const zstds_ext_byte_t* source             = source_buffer;
@@ -354,118 +792,510 @@ static inline zstds_ext_result_t compress(
     ctx,
     &source,
     &source_length,
-    destination_file,
+    destination_fd,
     destination_buffer,
     &destination_length,
     destination_buffer_length,
-    gvl);
+    gvl,
+    state_ptr);
 
   ext_result = buffered_compressor_finish(
-    ctx, destination_file, destination_buffer, &destination_length, destination_buffer_length, gvl);
+    ctx, NULL, 0, destination_fd, destination_buffer, &destination_length, destination_buffer_length, gvl, state_ptr);
 
   if (ext_result != 0) {
     return ext_result;
   }
 
-  return write_remaining_destination(destination_file, destination_buffer, destination_length);
+  return write_remaining_destination(destination_fd, destination_buffer, destination_length, gvl, state_ptr);
 }
 
-VALUE zstds_ext_compress_io(VALUE ZSTDS_EXT_UNUSED(self), VALUE source, VALUE destination, VALUE options)
-{
-  GET_FILE(source);
-  GET_FILE(destination);
-  Check_Type(options, T_HASH);
-  ZSTDS_EXT_GET_SIZE_OPTION(options, source_buffer_length);
-  ZSTDS_EXT_GET_SIZE_OPTION(options, destination_buffer_length);
-  ZSTDS_EXT_GET_BOOL_OPTION(options, gvl);
-  ZSTDS_EXT_GET_COMPRESSOR_OPTIONS(options);
+// -- mapped compress --
 
-  ZSTD_CCtx* ctx = ZSTD_createCCtx();
-  if (ctx == NULL) {
-    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
-  }
+// Whole mapped source is provided with frame finish, so zstd knows source length and can use it directly.
 
-  zstds_ext_result_t ext_result = zstds_ext_set_compressor_options(ctx, &compressor_options);
-  if (ext_result != 0) {
-    ZSTD_freeCCtx(ctx);
-    zstds_ext_raise_error(ext_result);
+static inline zstds_ext_result_t compress_mapped_file(
+  ZSTD_CCtx* ctx, int source_fd, int destination_fd, size_t destination_buffer_length, bool gvl, int* state_ptr)
+{
+  mapped_file_t source_map;
+  if (!map_source_file(source_fd, &source_map)) {
+    return ZSTDS_EXT_FILE_NOT_MAPPED;
   }
 
-  if (source_buffer_length == 0) {
-    source_buffer_length = ZSTD_CStreamInSize();
-  }
-  if (destination_buffer_length == 0) {
-    destination_buffer_length = ZSTD_CStreamOutSize();
+  zstds_ext_byte_t* destination_buffer = malloc(destination_buffer_length);
+  if (destination_buffer == NULL) {
+    unmap_source_file(source_fd, &source_map);
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
   }
 
-  zstds_ext_byte_t* source_buffer;
-  zstds_ext_byte_t* destination_buffer;
-
-  ext_result = create_buffers(&source_buffer, source_buffer_length, &destination_buffer, destination_buffer_length);
-  if (ext_result != 0) {
-    ZSTD_freeCCtx(ctx);
-    zstds_ext_raise_error(ext_result);
-  }
+  size_t destination_length = 0;
 
-  ext_result = compress(
+  zstds_ext_result_t ext_result = buffered_compressor_finish(
     ctx,
-    source_file,
-    source_buffer,
-    source_buffer_length,
-    destination_file,
+    source_map.data,
+    source_map.length,
+    destination_fd,
     destination_buffer,
+    &destination_length,
     destination_buffer_length,
-    gvl);
-
-  free(source_buffer);
-  free(destination_buffer);
-  ZSTD_freeCCtx(ctx);
+    gvl,
+    state_ptr);
 
-  if (ext_result != 0) {
-    zstds_ext_raise_error(ext_result);
+  if (ext_result == 0) {
+    ext_result = write_remaining_destination(destination_fd, destination_buffer, destination_length, gvl, state_ptr);
   }
 
-  // Ruby itself won't flush stdio file before closing fd, flush is required.
-  fflush(destination_file);
+  free(destination_buffer);
+  unmap_source_file(source_fd, &source_map);
 
-  return Qnil;
+  return ext_result;
 }
 
-// -- buffered decompress --
+// -- pipelined compress --
 
-typedef struct
-{
-  ZSTD_DCtx*      ctx;
-  ZSTD_inBuffer*  in_buffer_ptr;
-  ZSTD_outBuffer* out_buffer_ptr;
-  zstds_result_t  result;
-} decompress_args_t;
+// Reader and writer threads process files while current thread compresses previous source.
+// Current thread processes whole pipeline without GVL, so it calls compressor directly.
 
-static inline void* decompress_wrapper(void* data)
+static inline zstds_ext_result_t pipelined_compress(
+  ZSTD_CCtx* ctx, zstds_ext_pipeline_t* pipeline_ptr, size_t destination_buffer_length)
 {
-  decompress_args_t* args = data;
+  zstds_ext_byte_t* destination_buffer;
+  size_t            destination_length = 0;
 
-  args->result = ZSTD_decompressStream(args->ctx, args->out_buffer_ptr, args->in_buffer_ptr);
+  zstds_ext_result_t ext_result = zstds_ext_pipeline_acquire_destination(pipeline_ptr, &destination_buffer);
+  if (ext_result != 0) {
+    return ext_result;
+  }
 
-  return NULL;
-}
+  while (true) {
+    const zstds_ext_byte_t* source;
+    size_t                  source_length;
 
-static inline zstds_ext_result_t buffered_decompress(
-  ZSTD_DCtx*               ctx,
-  const zstds_ext_byte_t** source_ptr,
+    ext_result = zstds_ext_pipeline_read_source(pipeline_ptr, &source, &source_length);
+    if (ext_result != 0) {
+      return ext_result;
+    }
+
+    // Empty source finishes frame.
+    ZSTD_EndDirective directive = source_length == 0 ? ZSTD_e_end : ZSTD_e_continue;
+    ZSTD_inBuffer     in_buffer = {.src = source, .size = source_length, .pos = 0};
+
+    while (true) {
+      ZSTD_outBuffer out_buffer = {
+        .dst  = destination_buffer + destination_length,
+        .size = destination_buffer_length - destination_length,
+        .pos  = 0};
+
+      zstds_result_t result = ZSTD_compressStream2(ctx, &out_buffer, &in_buffer, directive);
+      if (ZSTD_isError(result)) {
+        return zstds_ext_get_error(ZSTD_getErrorCode(result));
+      }
+
+      destination_length += out_buffer.pos;
+
+      if (destination_length == destination_buffer_length) {
+        zstds_ext_pipeline_write_destination(pipeline_ptr, destination_length);
+        destination_length = 0;
+
+        ext_result = zstds_ext_pipeline_acquire_destination(pipeline_ptr, &destination_buffer);
+        if (ext_result != 0) {
+          return ext_result;
+        }
+
+        continue;
+      }
+
+      if (directive == ZSTD_e_end ? result == 0 : in_buffer.pos == in_buffer.size) {
+        break;
+      }
+    }
+
+    zstds_ext_pipeline_release_source(pipeline_ptr);
+
+    if (directive == ZSTD_e_end) {
+      break;
+    }
+  }
+
+  if (destination_length != 0) {
+    zstds_ext_pipeline_write_destination(pipeline_ptr, destination_length);
+  }
+
+  return zstds_ext_pipeline_finish(pipeline_ptr);
+}
+
+typedef struct
+{
+  ZSTD_CCtx*            ctx;
+  zstds_ext_pipeline_t* pipeline_ptr;
+  size_t                destination_buffer_length;
+  zstds_ext_result_t    ext_result;
+} pipelined_compress_args_t;
+
+static inline void* pipelined_compress_wrapper(void* data)
+{
+  pipelined_compress_args_t* args = data;
+
+  args->ext_result = pipelined_compress(args->ctx, args->pipeline_ptr, args->destination_buffer_length);
+
+  return NULL;
+}
+
+// -- parallel compress --
+
+// Parallel compressor reads source for all workers and splits it into independent frames with content size.
+// Each frame is compressed by separate worker into its own part of destination buffer with max compressed length.
+// Frames are written in order.
+
+static inline zstds_ext_result_t read_full_source(
+  int               source_fd,
+  zstds_ext_byte_t* source_buffer,
+  size_t*           source_length_ptr,
+  size_t            source_buffer_length,
+  bool              gvl,
+  int*              state_ptr)
+{
+  size_t source_length = 0;
+
+  while (source_length != source_buffer_length) {
+    size_t             new_source_length;
+    zstds_ext_result_t ext_result = read_file(
+      source_fd,
+      source_buffer + source_length,
+      &new_source_length,
+      source_buffer_length - source_length,
+      gvl,
+      state_ptr);
+
+    if (ext_result == ZSTDS_EXT_FILE_READ_FINISHED) {
+      break;
+    } else if (ext_result != 0) {
+      return ext_result;
+    }
+
+    source_length += new_source_length;
+  }
+
+  *source_length_ptr = source_length;
+
+  return 0;
+}
+
+static inline zstds_ext_result_t compress_parallel_frames(
+  ZSTD_CCtx**             ctxs,
+  size_t                  workers_length,
+  zstds_ext_batch_item_t* items,
+  zstds_ext_byte_t*       source_buffer,
+  size_t                  source_length,
+  size_t                  frame_length,
+  int                     destination_fd,
+  zstds_ext_byte_t*       destination_buffer,
+  size_t                  frame_destination_length,
+  bool                    gvl,
+  int*                    state_ptr)
+{
+  // Empty source will be compressed into single empty frame.
+  size_t items_length = source_length == 0 ? 1 : (source_length - 1) / frame_length + 1;
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item                    = &items[index];
+    size_t                  source_offset           = index * frame_length;
+    size_t                  remaining_source_length = source_length - source_offset;
+
+    item->source             = (const char*) source_buffer + source_offset;
+    item->source_length      = remaining_source_length < frame_length ? remaining_source_length : frame_length;
+    item->destination        = (char*) destination_buffer + index * frame_destination_length;
+    item->destination_length = frame_destination_length;
+    item->ext_result         = 0;
+  }
+
+  zstds_ext_batch_args_t args = {
+    .ctxs = (void**) ctxs, .workers_length = workers_length, .items = items, .items_length = items_length};
+
+  ZSTDS_EXT_GVL_WRAP(gvl, zstds_ext_compress_batch_wrapper, &args);
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item = &items[index];
+    if (item->ext_result != 0) {
+      return item->ext_result;
+    }
+
+    zstds_ext_result_t ext_result =
+      write_file(destination_fd, (zstds_ext_byte_t*) item->destination, item->destination_length, gvl, state_ptr);
+
+    if (ext_result != 0) {
+      return ext_result;
+    }
+  }
+
+  return 0;
+}
+
+static inline zstds_ext_result_t parallel_compress(
+  ZSTD_CCtx** ctxs,
+  size_t      workers_length,
+  int         source_fd,
+  int         destination_fd,
+  size_t      frame_length,
+  bool        gvl,
+  int*        state_ptr)
+{
+  size_t frame_destination_length = ZSTD_compressBound(frame_length);
+  if (frame_destination_length > SIZE_MAX / workers_length) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  size_t            source_buffer_length = workers_length * frame_length;
+  zstds_ext_byte_t* source_buffer;
+  zstds_ext_byte_t* destination_buffer;
+
+  zstds_ext_result_t ext_result = create_buffers(
+    &source_buffer, source_buffer_length, &destination_buffer, workers_length * frame_destination_length);
+
+  if (ext_result != 0) {
+    return ext_result;
+  }
+
+  zstds_ext_batch_item_t items[ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH];
+  bool                   is_first = true;
+
+  while (true) {
+    size_t source_length;
+
+    ext_result = read_full_source(source_fd, source_buffer, &source_length, source_buffer_length, gvl, state_ptr);
+    if (ext_result != 0 || (source_length == 0 && !is_first)) {
+      break;
+    }
+
+    ext_result = compress_parallel_frames(
+      ctxs,
+      workers_length,
+      items,
+      source_buffer,
+      source_length,
+      frame_length,
+      destination_fd,
+      destination_buffer,
+      frame_destination_length,
+      gvl,
+      state_ptr);
+
+    if (ext_result != 0 || source_length != source_buffer_length) {
+      break;
+    }
+
+    is_first = false;
+  }
+
+  free(source_buffer);
+  free(destination_buffer);
+
+  return ext_result;
+}
+
+VALUE zstds_ext_compress_io(VALUE ZSTDS_EXT_UNUSED(self), VALUE source, VALUE destination, VALUE options)
+{
+  GET_FD(source);
+  GET_FD(destination);
+  check_pending_source(source);
+  FLUSH_IO(destination);
+  Check_Type(options, T_HASH);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, source_buffer_length);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, destination_buffer_length);
+  ZSTDS_EXT_GET_GVL_OPTION(options);
+  ZSTDS_EXT_GET_BOOL_OPTION(options, mmap);
+  ZSTDS_EXT_GET_BOOL_OPTION(options, pipeline);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, parallel);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, parallel_frame_size);
+  ZSTDS_EXT_GET_STRING_OPTION(options, reference_path);
+  ZSTDS_EXT_GET_COMPRESSOR_OPTIONS(options);
+
+  // Reading and writing of file descriptors may block.
+  bool gvl = zstds_ext_keep_gvl(gvl_mode, ZSTDS_EXT_GVL_UNKNOWN_LENGTH);
+
+  // Protect state of exception raised while waiting for file descriptor using fiber scheduler.
+  int state = 0;
+
+  zstds_ext_result_t ext_result;
+
+  // Reference is a prefix for single frame, parallel frames can't use it.
+  if (reference_path != Qnil && parallel != 0) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  // Source is split into frames with parallel frame size.
+  if (parallel != 0 && parallel_frame_size == 0) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  if (parallel != 0) {
+    size_t     workers_length = zstds_ext_get_batch_workers_length(parallel, parallel);
+    ZSTD_CCtx* ctxs[ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH];
+
+    ext_result = zstds_ext_acquire_compressor_contexts(ctxs, workers_length, &compressor_options);
+    if (ext_result != 0) {
+      zstds_ext_raise_io_error(ext_result, state);
+    }
+
+    ext_result = parallel_compress(ctxs, workers_length, source_fd, destination_fd, parallel_frame_size, gvl, &state);
+
+    zstds_ext_release_compressor_contexts(ctxs, workers_length);
+
+    if (ext_result != 0) {
+      zstds_ext_raise_io_error(ext_result, state);
+    }
+
+    return Qnil;
+  }
+
+  mapped_file_t reference_file;
+
+  if (reference_path != Qnil) {
+    ext_result = map_reference_file(StringValueCStr(reference_path), &reference_file);
+    if (ext_result != 0) {
+      zstds_ext_raise_io_error(ext_result, state);
+    }
+  } else {
+    reference_file.map = NULL;
+  }
+
+  ZSTD_CCtx* ctx = zstds_ext_acquire_compressor_context();
+  if (ctx == NULL) {
+    unmap_reference_file(&reference_file);
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  }
+
+  ext_result = zstds_ext_set_compressor_options(ctx, &compressor_options);
+  if (ext_result == 0 && reference_path != Qnil) {
+    ext_result =
+      zstds_ext_set_compressor_reference(ctx, &compressor_options, reference_file.data, reference_file.length);
+  }
+
+  if (ext_result != 0) {
+    zstds_ext_release_compressor_context(ctx);
+    unmap_reference_file(&reference_file);
+    zstds_ext_raise_io_error(ext_result, state);
+  }
+
+  if (source_buffer_length == 0) {
+    source_buffer_length = ZSTD_CStreamInSize();
+  }
+  if (destination_buffer_length == 0) {
+    destination_buffer_length = ZSTD_CStreamOutSize();
+  }
+
+  if (mmap) {
+    ext_result = compress_mapped_file(ctx, source_fd, destination_fd, destination_buffer_length, gvl, &state);
+    if (ext_result != ZSTDS_EXT_FILE_NOT_MAPPED) {
+      zstds_ext_release_compressor_context(ctx);
+      unmap_reference_file(&reference_file);
+
+      if (ext_result != 0) {
+        zstds_ext_raise_io_error(ext_result, state);
+      }
+
+      return Qnil;
+    }
+  }
+
+  // Pipeline threads can't use fiber scheduler.
+  if (pipeline && !has_fiber_scheduler()) {
+    zstds_ext_pipeline_t* pipeline_ptr;
+
+    ext_result = zstds_ext_create_pipeline(
+      &pipeline_ptr, source_fd, source_buffer_length, destination_fd, destination_buffer_length);
+    if (ext_result == 0) {
+      pipelined_compress_args_t args = {
+        .ctx                       = ctx,
+        .pipeline_ptr              = pipeline_ptr,
+        .destination_buffer_length = destination_buffer_length,
+        .ext_result                = ZSTDS_EXT_PIPELINE_INTERRUPTED};
+
+      run_pipeline(pipelined_compress_wrapper, &args, pipeline_ptr, gvl);
+      zstds_ext_free_pipeline(pipeline_ptr);
+
+      ext_result = get_pipeline_result(args.ext_result, &state);
+    }
+
+    zstds_ext_release_compressor_context(ctx);
+    unmap_reference_file(&reference_file);
+
+    if (ext_result != 0) {
+      zstds_ext_raise_io_error(ext_result, state);
+    }
+
+    return Qnil;
+  }
+
+  zstds_ext_byte_t* source_buffer;
+  zstds_ext_byte_t* destination_buffer;
+
+  ext_result = create_buffers(&source_buffer, source_buffer_length, &destination_buffer, destination_buffer_length);
+  if (ext_result != 0) {
+    zstds_ext_release_compressor_context(ctx);
+    unmap_reference_file(&reference_file);
+    zstds_ext_raise_io_error(ext_result, state);
+  }
+
+  ext_result = compress(
+    ctx,
+    source_fd,
+    source_buffer,
+    source_buffer_length,
+    destination_fd,
+    destination_buffer,
+    destination_buffer_length,
+    gvl,
+    &state);
+
+  free(source_buffer);
+  free(destination_buffer);
+  zstds_ext_release_compressor_context(ctx);
+  unmap_reference_file(&reference_file);
+
+  if (ext_result != 0) {
+    zstds_ext_raise_io_error(ext_result, state);
+  }
+
+  return Qnil;
+}
+
+// -- buffered decompress --
+
+typedef struct
+{
+  ZSTD_DCtx*      ctx;
+  ZSTD_inBuffer*  in_buffer_ptr;
+  ZSTD_outBuffer* out_buffer_ptr;
+  zstds_result_t  result;
+} decompress_args_t;
+
+static inline void* decompress_wrapper(void* data)
+{
+  decompress_args_t* args = data;
+
+  args->result = ZSTD_decompressStream(args->ctx, args->out_buffer_ptr, args->in_buffer_ptr);
+
+  return NULL;
+}
+
+static inline zstds_ext_result_t buffered_decompress(
+  ZSTD_DCtx*               ctx,
+  const zstds_ext_byte_t** source_ptr,
   size_t*                  source_length_ptr,
-  FILE*                    destination_file,
+  int                      destination_fd,
   zstds_ext_byte_t*        destination_buffer,
   size_t*                  destination_length_ptr,
   size_t                   destination_buffer_length,
-  bool                     gvl)
+  bool                     gvl,
+  int*                     state_ptr)
 {
   zstds_ext_result_t ext_result;
   ZSTD_inBuffer      in_buffer = {.src = *source_ptr, .size = *source_length_ptr, .pos = 0};
   decompress_args_t  args      = {.ctx = ctx, .in_buffer_ptr = &in_buffer};
 
   while (true) {
-    ZSTD_outBuffer out_buffer = {
+    size_t         in_buffer_pos = in_buffer.pos;
+    ZSTD_outBuffer out_buffer    = {
       .dst  = destination_buffer + *destination_length_ptr,
       .size = destination_buffer_length - *destination_length_ptr,
       .pos  = 0};
@@ -481,7 +1311,7 @@ static inline zstds_ext_result_t buffered_decompress(
 
     if (*destination_length_ptr == destination_buffer_length) {
       ext_result = flush_destination_buffer(
-        destination_file, destination_buffer, destination_length_ptr, destination_buffer_length);
+        destination_fd, destination_buffer, destination_length_ptr, destination_buffer_length, gvl, state_ptr);
 
       if (ext_result != 0) {
         return ext_result;
@@ -490,6 +1320,11 @@ static inline zstds_ext_result_t buffered_decompress(
       continue;
     }
 
+    // Decompressor stops after each frame, source may contain more frames.
+    if (in_buffer.pos != in_buffer.size && in_buffer.pos != in_buffer_pos) {
+      continue;
+    }
+
     break;
   }
 
@@ -503,13 +1338,14 @@ static inline zstds_ext_result_t buffered_decompress(
 
 static inline zstds_ext_result_t decompress(
   ZSTD_DCtx*        ctx,
-  FILE*             source_file,
+  int               source_fd,
   zstds_ext_byte_t* source_buffer,
   size_t            source_buffer_length,
-  FILE*             destination_file,
+  int               destination_fd,
   zstds_ext_byte_t* destination_buffer,
   size_t            destination_buffer_length,
-  bool              gvl)
+  bool              gvl,
+  int*              state_ptr)
 {
   zstds_ext_result_t      ext_result;
   const zstds_ext_byte_t* source             = source_buffer;
@@ -521,41 +1357,697 @@ static inline zstds_ext_result_t decompress(
     ctx,
     &source,
     &source_length,
-    destination_file,
+    destination_fd,
     destination_buffer,
     &destination_length,
     destination_buffer_length,
-    gvl);
+    gvl,
+    state_ptr);
+
+  return write_remaining_destination(destination_fd, destination_buffer, destination_length, gvl, state_ptr);
+}
+
+// -- mapped decompress --
 
-  return write_remaining_destination(destination_file, destination_buffer, destination_length);
+// Frame headers may provide decompressed length, so destination file can be mapped too.
+
+static inline zstds_ext_result_t decompress_exact_mapped_file(
+  ZSTD_DCtx* ctx, const mapped_file_t* source_map_ptr, int destination_fd, size_t destination_length, bool gvl)
+{
+  mapped_file_t destination_map;
+  if (!map_destination_file(destination_fd, destination_length, &destination_map)) {
+    return ZSTDS_EXT_FILE_NOT_MAPPED;
+  }
+
+  zstds_ext_decompress_frames_args_t args = {
+    .ctx                = ctx,
+    .source             = (const char*) source_map_ptr->data,
+    .source_length      = source_map_ptr->length,
+    .destination        = (char*) destination_map.data,
+    .destination_length = destination_map.length};
+
+  ZSTDS_EXT_GVL_WRAP(gvl, zstds_ext_decompress_frames_wrapper, &args);
+
+  unmap_destination_file(destination_fd, &destination_map, args.ext_result == 0);
+
+  return args.ext_result;
+}
+
+static inline zstds_ext_result_t decompress_buffered_mapped_file(
+  ZSTD_DCtx*           ctx,
+  const mapped_file_t* source_map_ptr,
+  int                  destination_fd,
+  size_t               destination_buffer_length,
+  bool                 gvl,
+  int*                 state_ptr)
+{
+  zstds_ext_byte_t* destination_buffer = malloc(destination_buffer_length);
+  if (destination_buffer == NULL) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  zstds_ext_result_t      ext_result         = 0;
+  const zstds_ext_byte_t* source             = source_map_ptr->data;
+  size_t                  source_length      = source_map_ptr->length;
+  size_t                  destination_length = 0;
+
+  // Decompressor stops after each frame.
+  while (source_length != 0) {
+    size_t previous_source_length = source_length;
+
+    ext_result = buffered_decompress(
+      ctx,
+      &source,
+      &source_length,
+      destination_fd,
+      destination_buffer,
+      &destination_length,
+      destination_buffer_length,
+      gvl,
+      state_ptr);
+
+    if (ext_result != 0) {
+      break;
+    }
+
+    if (source_length == previous_source_length) {
+      ext_result = ZSTDS_EXT_ERROR_DECOMPRESSOR_CORRUPTED_SOURCE;
+      break;
+    }
+  }
+
+  if (ext_result == 0) {
+    ext_result = write_remaining_destination(destination_fd, destination_buffer, destination_length, gvl, state_ptr);
+  }
+
+  free(destination_buffer);
+
+  return ext_result;
+}
+
+static inline zstds_ext_result_t decompress_mapped_file(
+  ZSTD_DCtx* ctx,
+  int        source_fd,
+  int        destination_fd,
+  size_t     destination_buffer_length,
+  bool       is_exact,
+  bool       gvl,
+  int*       state_ptr)
+{
+  mapped_file_t source_map;
+  if (!map_source_file(source_fd, &source_map)) {
+    return ZSTDS_EXT_FILE_NOT_MAPPED;
+  }
+
+  zstds_ext_result_t ext_result = ZSTDS_EXT_FILE_NOT_MAPPED;
+  size_t             destination_length;
+
+  if (
+    is_exact &&
+    zstds_ext_get_decompressed_length((const char*) source_map.data, source_map.length, &destination_length)) {
+    ext_result = decompress_exact_mapped_file(ctx, &source_map, destination_fd, destination_length, gvl);
+  }
+
+  if (ext_result == ZSTDS_EXT_FILE_NOT_MAPPED) {
+    ext_result = decompress_buffered_mapped_file(
+      ctx, &source_map, destination_fd, destination_buffer_length, gvl, state_ptr);
+  }
+
+  unmap_source_file(source_fd, &source_map);
+
+  return ext_result;
+}
+
+// -- pipelined decompress --
+
+static inline zstds_ext_result_t pipelined_decompress(
+  ZSTD_DCtx* ctx, zstds_ext_pipeline_t* pipeline_ptr, size_t destination_buffer_length)
+{
+  zstds_ext_byte_t* destination_buffer;
+  size_t            destination_length = 0;
+
+  zstds_ext_result_t ext_result = zstds_ext_pipeline_acquire_destination(pipeline_ptr, &destination_buffer);
+  if (ext_result != 0) {
+    return ext_result;
+  }
+
+  while (true) {
+    const zstds_ext_byte_t* source;
+    size_t                  source_length;
+
+    ext_result = zstds_ext_pipeline_read_source(pipeline_ptr, &source, &source_length);
+    if (ext_result != 0) {
+      return ext_result;
+    }
+
+    if (source_length == 0) {
+      break;
+    }
+
+    ZSTD_inBuffer in_buffer = {.src = source, .size = source_length, .pos = 0};
+
+    while (true) {
+      ZSTD_outBuffer out_buffer = {
+        .dst  = destination_buffer + destination_length,
+        .size = destination_buffer_length - destination_length,
+        .pos  = 0};
+
+      zstds_result_t result = ZSTD_decompressStream(ctx, &out_buffer, &in_buffer);
+      if (ZSTD_isError(result)) {
+        return zstds_ext_get_error(ZSTD_getErrorCode(result));
+      }
+
+      destination_length += out_buffer.pos;
+
+      if (destination_length == destination_buffer_length) {
+        zstds_ext_pipeline_write_destination(pipeline_ptr, destination_length);
+        destination_length = 0;
+
+        ext_result = zstds_ext_pipeline_acquire_destination(pipeline_ptr, &destination_buffer);
+        if (ext_result != 0) {
+          return ext_result;
+        }
+
+        continue;
+      }
+
+      // Decompressor stops after each frame.
+      if (in_buffer.pos == in_buffer.size) {
+        break;
+      }
+    }
+
+    zstds_ext_pipeline_release_source(pipeline_ptr);
+  }
+
+  if (destination_length != 0) {
+    zstds_ext_pipeline_write_destination(pipeline_ptr, destination_length);
+  }
+
+  return zstds_ext_pipeline_finish(pipeline_ptr);
+}
+
+typedef struct
+{
+  ZSTD_DCtx*            ctx;
+  zstds_ext_pipeline_t* pipeline_ptr;
+  size_t                destination_buffer_length;
+  zstds_ext_result_t    ext_result;
+} pipelined_decompress_args_t;
+
+static inline void* pipelined_decompress_wrapper(void* data)
+{
+  pipelined_decompress_args_t* args = data;
+
+  args->ext_result = pipelined_decompress(args->ctx, args->pipeline_ptr, args->destination_buffer_length);
+
+  return NULL;
+}
+
+// -- parallel decompress --
+
+// Parallel decompressor reads complete frames with content size for all workers.
+// Each frame is decompressed by separate worker into its own part of destination buffer.
+// Other frames (unknown or large content size, skippable frames) are decompressed by current thread using streaming.
+// Streaming is used for all frames when window log max is provided.
+
+// Destination buffer keeps decompressed frames of all workers, frame headers can declare any content size.
+// Larger frames are streamed, frames are collected until total content size reaches batch limit.
+#define PARALLEL_MAX_FRAME_LENGTH ((size_t) 1 << 24) // 16 MB
+#define PARALLEL_MAX_BATCH_LENGTH ((size_t) 1 << 26) // 64 MB
+
+// Max frame header length is not available in stable api.
+#define PARALLEL_MAX_FRAME_HEADER_LENGTH 18
+
+enum
+{
+  PARALLEL_FRAME_READY = 0,
+  PARALLEL_FRAME_INCOMPLETE,
+  PARALLEL_FRAME_STREAMED
+};
+
+static inline int find_parallel_frame(
+  const zstds_ext_byte_t* source,
+  size_t                  source_length,
+  bool                    is_finished,
+  size_t*                 frame_source_length_ptr,
+  size_t*                 frame_length_ptr)
+{
+  unsigned long long frame_length = ZSTD_getFrameContentSize(source, source_length);
+  if (frame_length == ZSTD_CONTENTSIZE_ERROR) {
+    // Frame header may be incomplete, streaming will detect corrupted header.
+    return source_length < PARALLEL_MAX_FRAME_HEADER_LENGTH && !is_finished ? PARALLEL_FRAME_INCOMPLETE
+                                                                            : PARALLEL_FRAME_STREAMED;
+  }
+
+  if (frame_length == ZSTD_CONTENTSIZE_UNKNOWN || frame_length > PARALLEL_MAX_FRAME_LENGTH) {
+    return PARALLEL_FRAME_STREAMED;
+  }
+
+  size_t frame_source_length = ZSTD_findFrameCompressedSize(source, source_length);
+  if (ZSTD_isError(frame_source_length)) {
+    // Source buffer can grow up to max compressed length, large skippable frame will be streamed.
+    return source_length < ZSTD_compressBound((size_t) frame_length) && !is_finished ? PARALLEL_FRAME_INCOMPLETE
+                                                                                     : PARALLEL_FRAME_STREAMED;
+  }
+
+  *frame_source_length_ptr = frame_source_length;
+  *frame_length_ptr        = (size_t) frame_length;
+
+  return PARALLEL_FRAME_READY;
+}
+
+// Source buffer grows when it is full.
+
+static inline zstds_ext_result_t read_more_parallel_source(
+  int                      source_fd,
+  const zstds_ext_byte_t** source_ptr,
+  size_t*                  source_length_ptr,
+  zstds_ext_byte_t**       source_buffer_ptr,
+  size_t*                  source_buffer_length_ptr,
+  bool                     gvl,
+  int*                     state_ptr)
+{
+  if (*source_ptr == *source_buffer_ptr && *source_length_ptr == *source_buffer_length_ptr) {
+    size_t source_buffer_length = *source_buffer_length_ptr * 2;
+
+    zstds_ext_byte_t* source_buffer = realloc(*source_buffer_ptr, source_buffer_length);
+    if (source_buffer == NULL) {
+      return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+    }
+
+    *source_ptr               = source_buffer;
+    *source_buffer_ptr        = source_buffer;
+    *source_buffer_length_ptr = source_buffer_length;
+  }
+
+  return read_more_source(
+    source_fd, source_ptr, source_length_ptr, *source_buffer_ptr, *source_buffer_length_ptr, gvl, state_ptr);
+}
+
+static inline zstds_ext_result_t stream_parallel_frame(
+  ZSTD_DCtx*               ctx,
+  int                      source_fd,
+  const zstds_ext_byte_t** source_ptr,
+  size_t*                  source_length_ptr,
+  zstds_ext_byte_t*        source_buffer,
+  size_t                   source_buffer_length,
+  int                      destination_fd,
+  zstds_ext_byte_t*        destination_buffer,
+  size_t                   destination_buffer_length,
+  bool                     gvl,
+  int*                     state_ptr)
+{
+  zstds_ext_result_t ext_result;
+  decompress_args_t  args = {.ctx = ctx};
+
+  ZSTD_DCtx_reset(ctx, ZSTD_reset_session_only);
+
+  while (true) {
+    ZSTD_inBuffer  in_buffer  = {.src = *source_ptr, .size = *source_length_ptr, .pos = 0};
+    ZSTD_outBuffer out_buffer = {.dst = destination_buffer, .size = destination_buffer_length, .pos = 0};
+
+    args.in_buffer_ptr  = &in_buffer;
+    args.out_buffer_ptr = &out_buffer;
+
+    ZSTDS_EXT_GVL_WRAP(gvl, decompress_wrapper, &args);
+    if (ZSTD_isError(args.result)) {
+      return zstds_ext_get_error(ZSTD_getErrorCode(args.result));
+    }
+
+    *source_ptr += in_buffer.pos;
+    *source_length_ptr -= in_buffer.pos;
+
+    ext_result = write_remaining_destination(destination_fd, destination_buffer, out_buffer.pos, gvl, state_ptr);
+    if (ext_result != 0) {
+      return ext_result;
+    }
+
+    if (args.result == 0) {
+      // Frame is finished.
+      return 0;
+    }
+
+    if (in_buffer.pos != in_buffer.size && (in_buffer.pos != 0 || out_buffer.pos != 0)) {
+      continue;
+    }
+
+    ext_result = read_more_source(
+      source_fd, source_ptr, source_length_ptr, source_buffer, source_buffer_length, gvl, state_ptr);
+    if (ext_result == ZSTDS_EXT_FILE_READ_FINISHED) {
+      return ZSTDS_EXT_ERROR_DECOMPRESSOR_CORRUPTED_SOURCE;
+    } else if (ext_result != 0) {
+      return ext_result;
+    }
+  }
+}
+
+static inline zstds_ext_result_t decompress_parallel_frames(
+  ZSTD_DCtx**             ctxs,
+  size_t                  workers_length,
+  zstds_ext_batch_item_t* items,
+  size_t                  items_length,
+  int                     destination_fd,
+  zstds_ext_byte_t**      destination_buffer_ptr,
+  size_t*                 destination_buffer_length_ptr,
+  size_t                  destination_length,
+  bool                    gvl,
+  int*                    state_ptr)
+{
+  if (destination_length > *destination_buffer_length_ptr) {
+    zstds_ext_byte_t* destination_buffer = realloc(*destination_buffer_ptr, destination_length);
+    if (destination_buffer == NULL) {
+      return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+    }
+
+    *destination_buffer_ptr        = destination_buffer;
+    *destination_buffer_length_ptr = destination_length;
+  }
+
+  char* destination = (char*) *destination_buffer_ptr;
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item = &items[index];
+
+    item->destination = destination;
+    destination += item->destination_length;
+  }
+
+  zstds_ext_batch_args_t args = {
+    .ctxs = (void**) ctxs, .workers_length = workers_length, .items = items, .items_length = items_length};
+
+  ZSTDS_EXT_GVL_WRAP(gvl, zstds_ext_decompress_batch_wrapper, &args);
+
+  for (size_t index = 0; index < items_length; index++) {
+    if (items[index].ext_result != 0) {
+      return items[index].ext_result;
+    }
+  }
+
+  // Destinations are located one after another.
+  return write_remaining_destination(destination_fd, *destination_buffer_ptr, destination_length, gvl, state_ptr);
+}
+
+static inline zstds_ext_result_t parallel_decompress_buffers(
+  ZSTD_DCtx**        ctxs,
+  size_t             workers_length,
+  int                source_fd,
+  zstds_ext_byte_t** source_buffer_ptr,
+  size_t*            source_buffer_length_ptr,
+  int                destination_fd,
+  zstds_ext_byte_t** destination_buffer_ptr,
+  size_t*            destination_buffer_length_ptr,
+  bool               is_exact,
+  bool               gvl,
+  int*               state_ptr)
+{
+  zstds_ext_result_t      ext_result;
+  const zstds_ext_byte_t* source        = *source_buffer_ptr;
+  size_t                  source_length = 0;
+  bool                    is_finished   = false;
+
+  zstds_ext_batch_item_t items[ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH];
+
+  while (true) {
+    size_t items_length        = 0;
+    size_t items_source_length = 0;
+    size_t destination_length  = 0;
+
+    // Frames are collected until each worker receives frame or source has no more complete frames.
+    while (items_length != workers_length) {
+      const zstds_ext_byte_t* frame_source        = source + items_source_length;
+      size_t                  frame_source_length = source_length - items_source_length;
+      size_t                  frame_length;
+      int                     frame_status;
+
+      if (frame_source_length == 0) {
+        frame_status = PARALLEL_FRAME_INCOMPLETE;
+      } else if (is_exact) {
+        frame_status =
+          find_parallel_frame(frame_source, frame_source_length, is_finished, &frame_source_length, &frame_length);
+      } else {
+        frame_status = PARALLEL_FRAME_STREAMED;
+      }
+
+      if (frame_status == PARALLEL_FRAME_READY && destination_length + frame_length > PARALLEL_MAX_BATCH_LENGTH) {
+        // Frame will be collected in next batch, first frame always fits into batch.
+        break;
+      }
+
+      if (frame_status == PARALLEL_FRAME_READY) {
+        zstds_ext_batch_item_t* item = &items[items_length++];
+
+        item->source             = (const char*) frame_source;
+        item->source_length      = frame_source_length;
+        item->destination_length = frame_length;
+        item->ext_result         = 0;
+
+        items_source_length += frame_source_length;
+        destination_length += frame_length;
+        continue;
+      }
+
+      // Collected frames should be processed before source buffer will be changed.
+      if (items_length != 0) {
+        break;
+      }
+
+      if (frame_status == PARALLEL_FRAME_STREAMED) {
+        ext_result = stream_parallel_frame(
+          ctxs[0],
+          source_fd,
+          &source,
+          &source_length,
+          *source_buffer_ptr,
+          *source_buffer_length_ptr,
+          destination_fd,
+          *destination_buffer_ptr,
+          *destination_buffer_length_ptr,
+          gvl,
+          state_ptr);
+
+        if (ext_result != 0) {
+          return ext_result;
+        }
+
+        continue;
+      }
+
+      if (is_finished) {
+        // Incomplete frame is streamed when source is finished, so source has no remainder.
+        return 0;
+      }
+
+      ext_result = read_more_parallel_source(
+        source_fd, &source, &source_length, source_buffer_ptr, source_buffer_length_ptr, gvl, state_ptr);
+
+      if (ext_result == ZSTDS_EXT_FILE_READ_FINISHED) {
+        is_finished = true;
+      } else if (ext_result != 0) {
+        return ext_result;
+      }
+    }
+
+    ext_result = decompress_parallel_frames(
+      ctxs,
+      workers_length,
+      items,
+      items_length,
+      destination_fd,
+      destination_buffer_ptr,
+      destination_buffer_length_ptr,
+      destination_length,
+      gvl,
+      state_ptr);
+
+    if (ext_result != 0) {
+      return ext_result;
+    }
+
+    source += items_source_length;
+    source_length -= items_source_length;
+  }
+}
+
+static inline zstds_ext_result_t parallel_decompress(
+  ZSTD_DCtx** ctxs,
+  size_t      workers_length,
+  int         source_fd,
+  size_t      source_buffer_length,
+  int         destination_fd,
+  size_t      destination_buffer_length,
+  bool        is_exact,
+  bool        gvl,
+  int*        state_ptr)
+{
+  zstds_ext_byte_t* source_buffer;
+  zstds_ext_byte_t* destination_buffer;
+
+  zstds_ext_result_t ext_result =
+    create_buffers(&source_buffer, source_buffer_length, &destination_buffer, destination_buffer_length);
+
+  if (ext_result != 0) {
+    return ext_result;
+  }
+
+  // Buffers may be reallocated.
+  ext_result = parallel_decompress_buffers(
+    ctxs,
+    workers_length,
+    source_fd,
+    &source_buffer,
+    &source_buffer_length,
+    destination_fd,
+    &destination_buffer,
+    &destination_buffer_length,
+    is_exact,
+    gvl,
+    state_ptr);
+
+  free(source_buffer);
+  free(destination_buffer);
+
+  return ext_result;
 }
 
 VALUE zstds_ext_decompress_io(VALUE ZSTDS_EXT_UNUSED(self), VALUE source, VALUE destination, VALUE options)
 {
-  GET_FILE(source);
-  GET_FILE(destination);
+  GET_FD(source);
+  GET_FD(destination);
+  check_pending_source(source);
+  FLUSH_IO(destination);
   Check_Type(options, T_HASH);
   ZSTDS_EXT_GET_SIZE_OPTION(options, source_buffer_length);
   ZSTDS_EXT_GET_SIZE_OPTION(options, destination_buffer_length);
-  ZSTDS_EXT_GET_BOOL_OPTION(options, gvl);
+  ZSTDS_EXT_GET_GVL_OPTION(options);
+  ZSTDS_EXT_GET_BOOL_OPTION(options, mmap);
+  ZSTDS_EXT_GET_BOOL_OPTION(options, pipeline);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, parallel);
+  ZSTDS_EXT_GET_STRING_OPTION(options, reference_path);
   ZSTDS_EXT_GET_DECOMPRESSOR_OPTIONS(options);
 
-  ZSTD_DCtx* ctx = ZSTD_createDCtx();
+  // Reading and writing of file descriptors may block.
+  bool gvl = zstds_ext_keep_gvl(gvl_mode, ZSTDS_EXT_GVL_UNKNOWN_LENGTH);
+
+  // Protect state of exception raised while waiting for file descriptor using fiber scheduler.
+  int state = 0;
+
+  if (source_buffer_length == 0) {
+    source_buffer_length = ZSTD_DStreamInSize();
+  }
+  if (destination_buffer_length == 0) {
+    destination_buffer_length = ZSTD_DStreamOutSize();
+  }
+
+  // Single pass decompression doesn't respect window log max, it uses destination as window.
+  bool               is_exact = !decompressor_options.window_log_max.has_value;
+  zstds_ext_result_t ext_result;
+
+  // Reference is a prefix for single frame, parallel frames can't use it.
+  if (reference_path != Qnil && parallel != 0) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  if (parallel != 0) {
+    size_t     workers_length = zstds_ext_get_batch_workers_length(parallel, parallel);
+    ZSTD_DCtx* ctxs[ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH];
+
+    ext_result = zstds_ext_acquire_decompressor_contexts(ctxs, workers_length, &decompressor_options);
+    if (ext_result != 0) {
+      zstds_ext_raise_io_error(ext_result, state);
+    }
+
+    ext_result = parallel_decompress(
+      ctxs,
+      workers_length,
+      source_fd,
+      source_buffer_length,
+      destination_fd,
+      destination_buffer_length,
+      is_exact,
+      gvl,
+      &state);
+
+    zstds_ext_release_decompressor_contexts(ctxs, workers_length);
+
+    if (ext_result != 0) {
+      zstds_ext_raise_io_error(ext_result, state);
+    }
+
+    return Qnil;
+  }
+
+  mapped_file_t reference_file;
+
+  if (reference_path != Qnil) {
+    ext_result = map_reference_file(StringValueCStr(reference_path), &reference_file);
+    if (ext_result != 0) {
+      zstds_ext_raise_io_error(ext_result, state);
+    }
+  } else {
+    reference_file.map = NULL;
+  }
+
+  ZSTD_DCtx* ctx = zstds_ext_acquire_decompressor_context();
   if (ctx == NULL) {
+    unmap_reference_file(&reference_file);
     zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
   }
 
-  zstds_ext_result_t ext_result = zstds_ext_set_decompressor_options(ctx, &decompressor_options);
+  ext_result = zstds_ext_set_decompressor_options(ctx, &decompressor_options);
+  if (ext_result == 0 && reference_path != Qnil) {
+    ext_result =
+      zstds_ext_set_decompressor_reference(ctx, &decompressor_options, reference_file.data, reference_file.length);
+  }
+
   if (ext_result != 0) {
-    ZSTD_freeDCtx(ctx);
-    zstds_ext_raise_error(ext_result);
+    zstds_ext_release_decompressor_context(ctx);
+    unmap_reference_file(&reference_file);
+    zstds_ext_raise_io_error(ext_result, state);
   }
 
-  if (source_buffer_length == 0) {
-    source_buffer_length = ZSTD_DStreamInSize();
+  if (mmap) {
+    ext_result =
+      decompress_mapped_file(ctx, source_fd, destination_fd, destination_buffer_length, is_exact, gvl, &state);
+    if (ext_result != ZSTDS_EXT_FILE_NOT_MAPPED) {
+      zstds_ext_release_decompressor_context(ctx);
+      unmap_reference_file(&reference_file);
+
+      if (ext_result != 0) {
+        zstds_ext_raise_io_error(ext_result, state);
+      }
+
+      return Qnil;
+    }
   }
-  if (destination_buffer_length == 0) {
-    destination_buffer_length = ZSTD_DStreamOutSize();
+
+  // Pipeline threads can't use fiber scheduler.
+  if (pipeline && !has_fiber_scheduler()) {
+    zstds_ext_pipeline_t* pipeline_ptr;
+
+    ext_result = zstds_ext_create_pipeline(
+      &pipeline_ptr, source_fd, source_buffer_length, destination_fd, destination_buffer_length);
+    if (ext_result == 0) {
+      pipelined_decompress_args_t args = {
+        .ctx                       = ctx,
+        .pipeline_ptr              = pipeline_ptr,
+        .destination_buffer_length = destination_buffer_length,
+        .ext_result                = ZSTDS_EXT_PIPELINE_INTERRUPTED};
+
+      run_pipeline(pipelined_decompress_wrapper, &args, pipeline_ptr, gvl);
+      zstds_ext_free_pipeline(pipeline_ptr);
+
+      ext_result = get_pipeline_result(args.ext_result, &state);
+    }
+
+    zstds_ext_release_decompressor_context(ctx);
+    unmap_reference_file(&reference_file);
+
+    if (ext_result != 0) {
+      zstds_ext_raise_io_error(ext_result, state);
+    }
+
+    return Qnil;
   }
 
   zstds_ext_byte_t* source_buffer;
@@ -563,34 +2055,45 @@ VALUE zstds_ext_decompress_io(VALUE ZSTDS_EXT_UNUSED(self), VALUE source, VALUE
 
   ext_result = create_buffers(&source_buffer, source_buffer_length, &destination_buffer, destination_buffer_length);
   if (ext_result != 0) {
-    ZSTD_freeDCtx(ctx);
-    zstds_ext_raise_error(ext_result);
+    zstds_ext_release_decompressor_context(ctx);
+    unmap_reference_file(&reference_file);
+    zstds_ext_raise_io_error(ext_result, state);
   }
 
   ext_result = decompress(
     ctx,
-    source_file,
+    source_fd,
     source_buffer,
     source_buffer_length,
-    destination_file,
+    destination_fd,
     destination_buffer,
     destination_buffer_length,
-    gvl);
+    gvl,
+    &state);
 
   free(source_buffer);
   free(destination_buffer);
-  ZSTD_freeDCtx(ctx);
+  zstds_ext_release_decompressor_context(ctx);
+  unmap_reference_file(&reference_file);
 
   if (ext_result != 0) {
-    zstds_ext_raise_error(ext_result);
+    zstds_ext_raise_io_error(ext_result, state);
   }
 
-  // Ruby itself won't flush stdio file before closing fd, flush is required.
-  fflush(destination_file);
-
   return Qnil;
 }
 
+// -- errors --
+
+void zstds_ext_raise_io_error(zstds_ext_result_t ext_result, int state)
+{
+  if (ext_result == ZSTDS_EXT_FILE_WAIT_INTERRUPTED) {
+    rb_jump_tag(state);
+  }
+
+  zstds_ext_raise_error(ext_result);
+}
+
 // -- exports --
 
 void zstds_ext_io_exports(VALUE root_module)
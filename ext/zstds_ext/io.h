@@ -4,11 +4,24 @@
 #if !defined(ZSTDS_EXT_IO_H)
 #define ZSTDS_EXT_IO_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "ruby.h"
+#include "zstds_ext/common.h"
 
 VALUE zstds_ext_compress_io(VALUE self, VALUE source, VALUE destination, VALUE options);
 VALUE zstds_ext_decompress_io(VALUE self, VALUE source, VALUE destination, VALUE options);
 
+// Writes data into IO file descriptor, data buffered inside IO will be flushed before.
+// Raises error when IO has no file descriptor.
+// Protect state of exception received while waiting for IO using fiber scheduler will be stored.
+zstds_ext_result_t
+  zstds_ext_write_io(VALUE io, const zstds_ext_byte_t* data, size_t length, bool gvl, int* state_ptr);
+
+// Raises exception received while waiting for IO using fiber scheduler (using its state) or regular error.
+NORETURN(void zstds_ext_raise_io_error(zstds_ext_result_t ext_result, int state));
+
 void zstds_ext_io_exports(VALUE root_module);
 
 #endif // ZSTDS_EXT_IO_H
@@ -0,0 +1,210 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#include "zstds_ext/memory.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+#if defined(HAVE_ZSTD_CUSTOM_MEM) || defined(HAVE_ZSTD_STATIC_WORKSPACE)
+// Custom allocator and static workspace are parts of advanced API, zstd header allows to include it later.
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd.h>
+#endif // HAVE_ZSTD_CUSTOM_MEM || HAVE_ZSTD_STATIC_WORKSPACE
+
+#include "zstds_ext/common.h"
+#include "zstds_ext/macro.h"
+
+// Each allocation keeps its size inside header, header keeps max alignment for data.
+
+typedef union
+{
+  size_t      size;
+  max_align_t alignment;
+} header_t;
+
+void zstds_ext_init_memory(zstds_ext_memory_t* memory_ptr)
+{
+  atomic_init(&memory_ptr->size, 0);
+  memory_ptr->reported_size = 0;
+}
+
+void* zstds_ext_allocate_memory(zstds_ext_memory_t* memory_ptr, size_t size)
+{
+  if (size > SIZE_MAX - sizeof(header_t)) {
+    return NULL;
+  }
+
+  header_t* header_ptr = malloc(sizeof(header_t) + size);
+  if (header_ptr == NULL) {
+    return NULL;
+  }
+
+  header_ptr->size = size;
+  atomic_fetch_add_explicit(&memory_ptr->size, size, memory_order_relaxed);
+
+  return header_ptr + 1;
+}
+
+void zstds_ext_free_memory(zstds_ext_memory_t* memory_ptr, void* data)
+{
+  if (data == NULL) {
+    return;
+  }
+
+  header_t* header_ptr = (header_t*) data - 1;
+  atomic_fetch_sub_explicit(&memory_ptr->size, header_ptr->size, memory_order_relaxed);
+
+  free(header_ptr);
+}
+
+#if defined(HAVE_ZSTD_CUSTOM_MEM)
+
+static void* allocate_memory(void* opaque, size_t size)
+{
+  return zstds_ext_allocate_memory(opaque, size);
+}
+
+static void free_memory(void* opaque, void* data)
+{
+  zstds_ext_free_memory(opaque, data);
+}
+
+ZSTD_CCtx* zstds_ext_create_memory_cctx(zstds_ext_memory_t* memory_ptr)
+{
+  ZSTD_customMem custom_memory = {.customAlloc = allocate_memory, .customFree = free_memory, .opaque = memory_ptr};
+
+  return ZSTD_createCCtx_advanced(custom_memory);
+}
+
+ZSTD_DCtx* zstds_ext_create_memory_dctx(zstds_ext_memory_t* memory_ptr)
+{
+  ZSTD_customMem custom_memory = {.customAlloc = allocate_memory, .customFree = free_memory, .opaque = memory_ptr};
+
+  return ZSTD_createDCtx_advanced(custom_memory);
+}
+
+#else
+
+ZSTD_CCtx* zstds_ext_create_memory_cctx(zstds_ext_memory_t* ZSTDS_EXT_UNUSED(memory_ptr))
+{
+  return ZSTD_createCCtx();
+}
+
+ZSTD_DCtx* zstds_ext_create_memory_dctx(zstds_ext_memory_t* ZSTDS_EXT_UNUSED(memory_ptr))
+{
+  return ZSTD_createDCtx();
+}
+
+#endif // HAVE_ZSTD_CUSTOM_MEM
+
+// -- static --
+
+#if defined(HAVE_ZSTD_STATIC_WORKSPACE)
+
+// Workspace has max alignment, it is enough for static context.
+
+static inline zstds_ext_byte_t* allocate_workspace(
+  zstds_ext_memory_t* memory_ptr,
+  size_t              ctx_size,
+  size_t              buffer_length)
+{
+  if (ctx_size > SIZE_MAX - buffer_length) {
+    return NULL;
+  }
+
+  return zstds_ext_allocate_memory(memory_ptr, ctx_size + buffer_length);
+}
+
+ZSTD_CCtx* zstds_ext_create_static_cctx(
+  zstds_ext_memory_t* memory_ptr,
+  size_t              ctx_size,
+  size_t              buffer_length,
+  void**              workspace_ptr,
+  void**              buffer_ptr)
+{
+  zstds_ext_byte_t* workspace = allocate_workspace(memory_ptr, ctx_size, buffer_length);
+  if (workspace == NULL) {
+    return NULL;
+  }
+
+  ZSTD_CCtx* ctx = ZSTD_initStaticCCtx(workspace, ctx_size);
+  if (ctx == NULL) {
+    zstds_ext_free_memory(memory_ptr, workspace);
+    return NULL;
+  }
+
+  *workspace_ptr = workspace;
+  *buffer_ptr    = workspace + ctx_size;
+
+  return ctx;
+}
+
+ZSTD_DCtx* zstds_ext_create_static_dctx(
+  zstds_ext_memory_t* memory_ptr,
+  size_t              ctx_size,
+  size_t              buffer_length,
+  void**              workspace_ptr,
+  void**              buffer_ptr)
+{
+  zstds_ext_byte_t* workspace = allocate_workspace(memory_ptr, ctx_size, buffer_length);
+  if (workspace == NULL) {
+    return NULL;
+  }
+
+  ZSTD_DCtx* ctx = ZSTD_initStaticDCtx(workspace, ctx_size);
+  if (ctx == NULL) {
+    zstds_ext_free_memory(memory_ptr, workspace);
+    return NULL;
+  }
+
+  *workspace_ptr = workspace;
+  *buffer_ptr    = workspace + ctx_size;
+
+  return ctx;
+}
+
+#else
+
+ZSTD_CCtx* zstds_ext_create_static_cctx(
+  zstds_ext_memory_t* ZSTDS_EXT_UNUSED(memory_ptr),
+  size_t              ZSTDS_EXT_UNUSED(ctx_size),
+  size_t              ZSTDS_EXT_UNUSED(buffer_length),
+  void**              ZSTDS_EXT_UNUSED(workspace_ptr),
+  void**              ZSTDS_EXT_UNUSED(buffer_ptr))
+{
+  return NULL;
+}
+
+ZSTD_DCtx* zstds_ext_create_static_dctx(
+  zstds_ext_memory_t* ZSTDS_EXT_UNUSED(memory_ptr),
+  size_t              ZSTDS_EXT_UNUSED(ctx_size),
+  size_t              ZSTDS_EXT_UNUSED(buffer_length),
+  void**              ZSTDS_EXT_UNUSED(workspace_ptr),
+  void**              ZSTDS_EXT_UNUSED(buffer_ptr))
+{
+  return NULL;
+}
+
+#endif // HAVE_ZSTD_STATIC_WORKSPACE
+
+// -- report --
+
+size_t zstds_ext_get_memory_size(zstds_ext_memory_t* memory_ptr)
+{
+  return atomic_load_explicit(&memory_ptr->size, memory_order_relaxed);
+}
+
+void zstds_ext_report_memory(zstds_ext_memory_t* memory_ptr)
+{
+  size_t size          = zstds_ext_get_memory_size(memory_ptr);
+  size_t reported_size = memory_ptr->reported_size;
+  if (size == reported_size) {
+    return;
+  }
+
+  rb_gc_adjust_memory_usage((ssize_t) size - (ssize_t) reported_size);
+
+  memory_ptr->reported_size = size;
+}
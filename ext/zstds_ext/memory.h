@@ -0,0 +1,59 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#if !defined(ZSTDS_EXT_MEMORY_H)
+#define ZSTDS_EXT_MEMORY_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <zstd.h>
+
+#include "ruby.h"
+
+// Memory allocated by zstd is invisible for ruby GC, large context can keep hundreds of MB.
+// Memory counts allocations of its contexts and buffers, ruby GC is notified about its size changes.
+// Contexts use default zstd allocator when zstd doesn't provide custom allocator support.
+
+typedef struct
+{
+  atomic_size_t size;
+  size_t        reported_size;
+} zstds_ext_memory_t;
+
+void zstds_ext_init_memory(zstds_ext_memory_t* memory_ptr);
+
+// These functions can be used without GVL (zstd workers are using allocator too).
+// Allocate returns NULL when allocation failed.
+
+void* zstds_ext_allocate_memory(zstds_ext_memory_t* memory_ptr, size_t size);
+void  zstds_ext_free_memory(zstds_ext_memory_t* memory_ptr, void* data);
+
+ZSTD_CCtx* zstds_ext_create_memory_cctx(zstds_ext_memory_t* memory_ptr);
+ZSTD_DCtx* zstds_ext_create_memory_dctx(zstds_ext_memory_t* memory_ptr);
+
+// Static context is placed at the beginning of workspace, buffer is placed after it.
+// Static context won't allocate memory, workspace should be freed instead of context.
+// Create returns NULL when workspace can't be allocated, workspace is not allocated in this case.
+
+ZSTD_CCtx* zstds_ext_create_static_cctx(
+  zstds_ext_memory_t* memory_ptr,
+  size_t              ctx_size,
+  size_t              buffer_length,
+  void**              workspace_ptr,
+  void**              buffer_ptr);
+
+ZSTD_DCtx* zstds_ext_create_static_dctx(
+  zstds_ext_memory_t* memory_ptr,
+  size_t              ctx_size,
+  size_t              buffer_length,
+  void**              workspace_ptr,
+  void**              buffer_ptr);
+
+// Returns size of memory allocated using memory object.
+size_t zstds_ext_get_memory_size(zstds_ext_memory_t* memory_ptr);
+
+// Report requires GVL, it should be used after each operation that may allocate or free memory.
+// It is safe to use report inside free function of ruby object.
+void zstds_ext_report_memory(zstds_ext_memory_t* memory_ptr);
+
+#endif // ZSTDS_EXT_MEMORY_H
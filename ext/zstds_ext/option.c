@@ -3,8 +3,16 @@
 
 #include "zstds_ext/option.h"
 
+#include "zstds_ext/batch.h"
 #include "zstds_ext/dictionary.h"
 #include "zstds_ext/error.h"
+#include "zstds_ext/macro.h"
+
+#if defined(HAVE_ZSTD_STATIC_WORKSPACE)
+// Workspace estimation is a part of advanced API, zstd header allows to include it later.
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd.h>
+#endif // HAVE_ZSTD_STATIC_WORKSPACE
 
 // -- values --
 
@@ -51,6 +59,16 @@ static inline size_t get_size_value(VALUE raw_value)
   return NUM2SIZET(raw_value);
 }
 
+static inline double get_double_value(VALUE raw_value)
+{
+  int raw_type = TYPE(raw_value);
+  if (raw_type != T_FLOAT && raw_type != T_FIXNUM) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  return NUM2DBL(raw_value);
+}
+
 static inline ZSTD_strategy get_strategy_value(VALUE raw_value)
 {
   Check_Type(raw_value, T_SYMBOL);
@@ -149,6 +167,87 @@ size_t zstds_ext_get_size_option_value(VALUE options, const char* name)
   return get_size_value(raw_value);
 }
 
+double zstds_ext_get_double_option_value(VALUE options, const char* name)
+{
+  VALUE raw_value = get_raw_value(options, name);
+
+  return get_double_value(raw_value);
+}
+
+VALUE zstds_ext_get_string_option_value(VALUE options, const char* name)
+{
+  VALUE raw_value = get_raw_value(options, name);
+  if (!NIL_P(raw_value)) {
+    Check_Type(raw_value, T_STRING);
+  }
+
+  return raw_value;
+}
+
+zstds_ext_buffer_growth_t zstds_ext_get_buffer_growth_option_value(VALUE options, const char* name)
+{
+  VALUE raw_value = get_raw_value(options, name);
+
+  Check_Type(raw_value, T_SYMBOL);
+
+  ID raw_id = SYM2ID(raw_value);
+  if (raw_id == rb_intern("fixed")) {
+    return ZSTDS_EXT_BUFFER_GROWTH_FIXED;
+  } else if (raw_id == rb_intern("geometric")) {
+    return ZSTDS_EXT_BUFFER_GROWTH_GEOMETRIC;
+  } else if (raw_id == rb_intern("ratio")) {
+    return ZSTDS_EXT_BUFFER_GROWTH_RATIO;
+  } else {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+}
+
+zstds_ext_dictionary_algorithm_t zstds_ext_get_dictionary_algorithm_option_value(VALUE options, const char* name)
+{
+  VALUE raw_value = get_raw_value(options, name);
+  if (NIL_P(raw_value)) {
+    return ZSTDS_EXT_DICTIONARY_ALGORITHM_DEFAULT;
+  }
+
+  Check_Type(raw_value, T_SYMBOL);
+
+  ID raw_id = SYM2ID(raw_value);
+  if (raw_id == rb_intern("cover")) {
+    return ZSTDS_EXT_DICTIONARY_ALGORITHM_COVER;
+  } else if (raw_id == rb_intern("fast_cover")) {
+    return ZSTDS_EXT_DICTIONARY_ALGORITHM_FAST_COVER;
+  } else {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+}
+
+zstds_ext_gvl_t zstds_ext_get_gvl_option_value(VALUE options, const char* name)
+{
+  VALUE raw_value = get_raw_value(options, name);
+
+  int raw_type = TYPE(raw_value);
+  if (raw_type == T_TRUE) {
+    return ZSTDS_EXT_GVL_KEEP;
+  } else if (raw_type == T_FALSE) {
+    return ZSTDS_EXT_GVL_RELEASE;
+  } else if (raw_type == T_SYMBOL && SYM2ID(raw_value) == rb_intern("auto")) {
+    return ZSTDS_EXT_GVL_AUTO;
+  } else {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+}
+
+// Auto GVL mode uses calibrated threshold when custom threshold is not provided.
+size_t zstds_ext_get_gvl_threshold_option_value(VALUE options, const char* name)
+{
+  VALUE raw_value = get_raw_value(options, name);
+  if (NIL_P(raw_value)) {
+    return zstds_ext_get_gvl_threshold();
+  }
+
+  return get_size_value(raw_value);
+}
+
 // -- set params --
 
 #define SET_OPTION_VALUE(function, ctx, param, option)       \
@@ -159,31 +258,72 @@ size_t zstds_ext_get_size_option_value(VALUE options, const char* name)
     }                                                        \
   }
 
-#define SET_COMPRESSOR_PARAM(ctx, param, option) SET_OPTION_VALUE(ZSTD_CCtx_setParameter, ctx, param, option);
+// Digested dictionary replaces compression params for small inputs.
+// So it is possible to use it only when user don't want to change these params.
+
+static inline bool has_compression_params(zstds_ext_compressor_options_t* options)
+{
+  return options->window_log.has_value || options->hash_log.has_value || options->chain_log.has_value ||
+         options->search_log.has_value || options->min_match.has_value || options->target_length.has_value ||
+         options->strategy.has_value;
+}
+
+static inline zstds_ext_result_t set_compressor_dictionary(ZSTD_CCtx* ctx, zstds_ext_compressor_options_t* options)
+{
+  zstds_result_t result;
+
+  if (!has_compression_params(options)) {
+    int compression_level = options->compression_level.has_value ? options->compression_level.value : 0;
+
+    ZSTD_CDict* cdict = zstds_ext_get_dictionary_cdict(options->dictionary, compression_level);
+    if (cdict != NULL) {
+      result = ZSTD_CCtx_refCDict(ctx, cdict);
+      if (ZSTD_isError(result)) {
+        return zstds_ext_get_error(ZSTD_getErrorCode(result));
+      }
+
+      return 0;
+    }
+
+    // Loading dictionary will provide precise error.
+  }
+
+  VALUE dictionary_buffer = rb_attr_get(options->dictionary, rb_intern("@buffer"));
+
+  result = ZSTD_CCtx_loadDictionary(ctx, RSTRING_PTR(dictionary_buffer), RSTRING_LEN(dictionary_buffer));
+  if (ZSTD_isError(result)) {
+    return zstds_ext_get_error(ZSTD_getErrorCode(result));
+  }
+
+  return 0;
+}
+
+#define SET_COMPRESSOR_PARAMS(function, target, options)                                                           \
+  SET_OPTION_VALUE(function, target, ZSTD_c_compressionLevel, (options)->compression_level);                       \
+  SET_OPTION_VALUE(function, target, ZSTD_c_windowLog, (options)->window_log);                                     \
+  SET_OPTION_VALUE(function, target, ZSTD_c_hashLog, (options)->hash_log);                                         \
+  SET_OPTION_VALUE(function, target, ZSTD_c_chainLog, (options)->chain_log);                                       \
+  SET_OPTION_VALUE(function, target, ZSTD_c_searchLog, (options)->search_log);                                     \
+  SET_OPTION_VALUE(function, target, ZSTD_c_minMatch, (options)->min_match);                                       \
+  SET_OPTION_VALUE(function, target, ZSTD_c_targetLength, (options)->target_length);                               \
+  SET_OPTION_VALUE(function, target, ZSTD_c_strategy, (options)->strategy);                                        \
+  SET_OPTION_VALUE(function, target, ZSTD_c_enableLongDistanceMatching, (options)->enable_long_distance_matching); \
+  SET_OPTION_VALUE(function, target, ZSTD_c_ldmHashLog, (options)->ldm_hash_log);                                  \
+  SET_OPTION_VALUE(function, target, ZSTD_c_ldmMinMatch, (options)->ldm_min_match);                                \
+  SET_OPTION_VALUE(function, target, ZSTD_c_ldmBucketSizeLog, (options)->ldm_bucket_size_log);                     \
+  SET_OPTION_VALUE(function, target, ZSTD_c_ldmHashRateLog, (options)->ldm_hash_rate_log);                         \
+  SET_OPTION_VALUE(function, target, ZSTD_c_contentSizeFlag, (options)->content_size_flag);                        \
+  SET_OPTION_VALUE(function, target, ZSTD_c_checksumFlag, (options)->checksum_flag);                               \
+  SET_OPTION_VALUE(function, target, ZSTD_c_dictIDFlag, (options)->dict_id_flag);                                  \
+  SET_OPTION_VALUE(function, target, ZSTD_c_nbWorkers, (options)->nb_workers);                                     \
+  SET_OPTION_VALUE(function, target, ZSTD_c_jobSize, (options)->job_size);                                         \
+  SET_OPTION_VALUE(function, target, ZSTD_c_overlapLog, (options)->overlap_log);
 
 zstds_ext_result_t zstds_ext_set_compressor_options(ZSTD_CCtx* ctx, zstds_ext_compressor_options_t* options)
 {
   zstds_result_t result;
 
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_compressionLevel, options->compression_level);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_windowLog, options->window_log);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_hashLog, options->hash_log);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_chainLog, options->chain_log);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_searchLog, options->search_log);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_minMatch, options->min_match);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_targetLength, options->target_length);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_strategy, options->strategy);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_enableLongDistanceMatching, options->enable_long_distance_matching);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_ldmHashLog, options->ldm_hash_log);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_ldmMinMatch, options->ldm_min_match);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_ldmBucketSizeLog, options->ldm_bucket_size_log);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_ldmHashRateLog, options->ldm_hash_rate_log);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_contentSizeFlag, options->content_size_flag);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_checksumFlag, options->checksum_flag);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_dictIDFlag, options->dict_id_flag);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_nbWorkers, options->nb_workers);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_jobSize, options->job_size);
-  SET_COMPRESSOR_PARAM(ctx, ZSTD_c_overlapLog, options->overlap_log);
+  SET_COMPRESSOR_PARAMS(ZSTD_CCtx_setParameter, ctx, options);
 
   if (options->pledged_size.has_value) {
     result = ZSTD_CCtx_setPledgedSrcSize(ctx, options->pledged_size.value);
@@ -193,12 +333,7 @@ zstds_ext_result_t zstds_ext_set_compressor_options(ZSTD_CCtx* ctx, zstds_ext_co
   }
 
   if (options->dictionary != Qnil) {
-    VALUE dictionary_buffer = rb_attr_get(options->dictionary, rb_intern("@buffer"));
-
-    result = ZSTD_CCtx_loadDictionary(ctx, RSTRING_PTR(dictionary_buffer), RSTRING_LEN(dictionary_buffer));
-    if (ZSTD_isError(result)) {
-      return zstds_ext_get_error(ZSTD_getErrorCode(result));
-    }
+    return set_compressor_dictionary(ctx, options);
   }
 
   return 0;
@@ -213,9 +348,16 @@ zstds_ext_result_t zstds_ext_set_decompressor_options(ZSTD_DCtx* ctx, zstds_ext_
   SET_DECOMPRESSOR_PARAM(ctx, ZSTD_d_windowLogMax, options->window_log_max);
 
   if (options->dictionary != Qnil) {
-    VALUE dictionary_buffer = rb_attr_get(options->dictionary, rb_intern("@buffer"));
+    ZSTD_DDict* ddict = zstds_ext_get_dictionary_ddict(options->dictionary);
+    if (ddict != NULL) {
+      result = ZSTD_DCtx_refDDict(ctx, ddict);
+    } else {
+      // Loading dictionary will provide precise error.
+      VALUE dictionary_buffer = rb_attr_get(options->dictionary, rb_intern("@buffer"));
+
+      result = ZSTD_DCtx_loadDictionary(ctx, RSTRING_PTR(dictionary_buffer), RSTRING_LEN(dictionary_buffer));
+    }
 
-    result = ZSTD_DCtx_loadDictionary(ctx, RSTRING_PTR(dictionary_buffer), RSTRING_LEN(dictionary_buffer));
     if (ZSTD_isError(result)) {
       return zstds_ext_get_error(ZSTD_getErrorCode(result));
     }
@@ -224,6 +366,175 @@ zstds_ext_result_t zstds_ext_set_decompressor_options(ZSTD_DCtx* ctx, zstds_ext_
   return 0;
 }
 
+// -- reference --
+
+// Reference is used as prefix for single frame, it is an equivalent of "zstd --patch-from".
+// Window should include both reference and source, long distance matching finds matches in large reference.
+
+static inline unsigned int get_reference_window_log(size_t content_length)
+{
+  unsigned int window_log = 0;
+  while (window_log < sizeof(size_t) * 8 && ((size_t) 1 << window_log) <= content_length) {
+    window_log++;
+  }
+
+  ZSTD_bounds bounds = ZSTD_cParam_getBounds(ZSTD_c_windowLog);
+  if ((int) window_log < bounds.lowerBound) {
+    return bounds.lowerBound;
+  } else if ((int) window_log > bounds.upperBound) {
+    return bounds.upperBound;
+  }
+
+  return window_log;
+}
+
+// Source length is not known, so decompressor window covers reference and source of the same length.
+// Window won't be smaller than default limit, larger source requires window log max to be provided.
+
+static inline unsigned int get_reference_window_log_max(size_t reference_length)
+{
+  size_t       content_length = reference_length <= SIZE_MAX / 2 ? reference_length * 2 : SIZE_MAX;
+  unsigned int window_log     = get_reference_window_log(content_length);
+
+  if (window_log < ZSTD_WINDOWLOG_LIMIT_DEFAULT) {
+    return ZSTD_WINDOWLOG_LIMIT_DEFAULT;
+  }
+
+  return window_log;
+}
+
+zstds_ext_result_t zstds_ext_set_compressor_reference(
+  ZSTD_CCtx*                      ctx,
+  zstds_ext_compressor_options_t* options,
+  const void*                     reference,
+  size_t                          reference_length)
+{
+  zstds_result_t result;
+
+  if (!options->window_log.has_value) {
+    size_t content_length = reference_length;
+    if (options->pledged_size.has_value) {
+      content_length += options->pledged_size.value;
+    }
+
+    result = ZSTD_CCtx_setParameter(ctx, ZSTD_c_windowLog, get_reference_window_log(content_length));
+    if (ZSTD_isError(result)) {
+      return zstds_ext_get_error(ZSTD_getErrorCode(result));
+    }
+  }
+
+  if (!options->enable_long_distance_matching.has_value) {
+    result = ZSTD_CCtx_setParameter(ctx, ZSTD_c_enableLongDistanceMatching, 1);
+    if (ZSTD_isError(result)) {
+      return zstds_ext_get_error(ZSTD_getErrorCode(result));
+    }
+  }
+
+  result = ZSTD_CCtx_refPrefix(ctx, reference, reference_length);
+  if (ZSTD_isError(result)) {
+    return zstds_ext_get_error(ZSTD_getErrorCode(result));
+  }
+
+  return 0;
+}
+
+zstds_ext_result_t zstds_ext_set_decompressor_reference(
+  ZSTD_DCtx*                        ctx,
+  zstds_ext_decompressor_options_t* options,
+  const void*                       reference,
+  size_t                            reference_length)
+{
+  zstds_result_t result;
+
+  if (!options->window_log_max.has_value) {
+    result = ZSTD_DCtx_setParameter(ctx, ZSTD_d_windowLogMax, get_reference_window_log_max(reference_length));
+    if (ZSTD_isError(result)) {
+      return zstds_ext_get_error(ZSTD_getErrorCode(result));
+    }
+  }
+
+  result = ZSTD_DCtx_refPrefix(ctx, reference, reference_length);
+  if (ZSTD_isError(result)) {
+    return zstds_ext_get_error(ZSTD_getErrorCode(result));
+  }
+
+  return 0;
+}
+
+// -- workspace --
+
+#if defined(HAVE_ZSTD_STATIC_WORKSPACE)
+
+static inline zstds_ext_result_t
+  set_compressor_params(ZSTD_CCtx_params* params, zstds_ext_compressor_options_t* options)
+{
+  zstds_result_t result;
+
+  SET_COMPRESSOR_PARAMS(ZSTD_CCtxParams_setParameter, params, options);
+
+  return 0;
+}
+
+zstds_ext_result_t zstds_ext_get_compressor_workspace_size(zstds_ext_compressor_options_t* options, size_t* size_ptr)
+{
+  ZSTD_CCtx_params* params = ZSTD_createCCtxParams();
+  if (params == NULL) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  zstds_ext_result_t ext_result = set_compressor_params(params, options);
+  if (ext_result != 0) {
+    ZSTD_freeCCtxParams(params);
+    return ext_result;
+  }
+
+  zstds_result_t result = ZSTD_estimateCStreamSize_usingCCtxParams(params);
+  ZSTD_freeCCtxParams(params);
+
+  if (ZSTD_isError(result)) {
+    return zstds_ext_get_error(ZSTD_getErrorCode(result));
+  }
+
+  *size_ptr = result;
+
+  return 0;
+}
+
+zstds_ext_result_t zstds_ext_get_decompressor_workspace_size(
+  zstds_ext_decompressor_options_t* options,
+  size_t*                           size_ptr)
+{
+  zstds_ext_option_value_t window_log =
+    options->window_log_max.has_value ? options->window_log_max.value : ZSTD_WINDOWLOG_LIMIT_DEFAULT;
+
+  zstds_result_t result = ZSTD_estimateDStreamSize((size_t) 1 << window_log);
+  if (ZSTD_isError(result)) {
+    return zstds_ext_get_error(ZSTD_getErrorCode(result));
+  }
+
+  *size_ptr = result;
+
+  return 0;
+}
+
+#else
+
+zstds_ext_result_t zstds_ext_get_compressor_workspace_size(
+  zstds_ext_compressor_options_t* ZSTDS_EXT_UNUSED(options),
+  size_t*                         ZSTDS_EXT_UNUSED(size_ptr))
+{
+  return ZSTDS_EXT_ERROR_NOT_IMPLEMENTED;
+}
+
+zstds_ext_result_t zstds_ext_get_decompressor_workspace_size(
+  zstds_ext_decompressor_options_t* ZSTDS_EXT_UNUSED(options),
+  size_t*                           ZSTDS_EXT_UNUSED(size_ptr))
+{
+  return ZSTDS_EXT_ERROR_NOT_IMPLEMENTED;
+}
+
+#endif // HAVE_ZSTD_STATIC_WORKSPACE
+
 // -- exports --
 
 #define EXPORT_PARAM_BOUNDS(function, module, param, type, name)                 \
@@ -278,4 +589,7 @@ void zstds_ext_option_exports(VALUE root_module)
   EXPORT_COMPRESSOR_PARAM_BOUNDS(module, ZSTD_c_overlapLog, UINT, "OVERLAP_LOG");
 
   EXPORT_DECOMPRESSOR_PARAM_BOUNDS(module, ZSTD_d_windowLogMax, UINT, "WINDOW_LOG_MAX");
+
+  // Current thread is a batch worker too.
+  rb_define_const(module, "MAX_BATCH_WORKERS", SIZET2NUM(ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH));
 }
@@ -9,6 +9,7 @@
 
 #include "ruby.h"
 #include "zstds_ext/common.h"
+#include "zstds_ext/gvl.h"
 
 // Default option values depends on zstd library.
 // We will set only user defined values.
@@ -131,15 +132,75 @@ void zstds_ext_resolve_dictionary_option(VALUE options, VALUE* option, const cha
   ZSTDS_EXT_RESOLVE_OPTION(options, dictionary_options, ZSTDS_EXT_OPTION_TYPE_UINT, notification_level); \
   ZSTDS_EXT_RESOLVE_OPTION(options, dictionary_options, ZSTDS_EXT_OPTION_TYPE_UINT, dictionary_id);
 
-bool   zstds_ext_get_bool_option_value(VALUE options, const char* name);
-size_t zstds_ext_get_size_option_value(VALUE options, const char* name);
+enum
+{
+  ZSTDS_EXT_BUFFER_GROWTH_FIXED = 1,
+  ZSTDS_EXT_BUFFER_GROWTH_GEOMETRIC,
+  ZSTDS_EXT_BUFFER_GROWTH_RATIO
+};
 
-#define ZSTDS_EXT_GET_BOOL_OPTION(options, name) size_t name = zstds_ext_get_bool_option_value(options, #name);
-#define ZSTDS_EXT_GET_SIZE_OPTION(options, name) size_t name = zstds_ext_get_size_option_value(options, #name);
+typedef zstds_ext_byte_fast_t zstds_ext_buffer_growth_t;
+
+enum
+{
+  ZSTDS_EXT_DICTIONARY_ALGORITHM_DEFAULT = 1,
+  ZSTDS_EXT_DICTIONARY_ALGORITHM_COVER,
+  ZSTDS_EXT_DICTIONARY_ALGORITHM_FAST_COVER
+};
+
+typedef zstds_ext_byte_fast_t zstds_ext_dictionary_algorithm_t;
+
+bool                             zstds_ext_get_bool_option_value(VALUE options, const char* name);
+size_t                           zstds_ext_get_size_option_value(VALUE options, const char* name);
+double                           zstds_ext_get_double_option_value(VALUE options, const char* name);
+VALUE                            zstds_ext_get_string_option_value(VALUE options, const char* name);
+zstds_ext_buffer_growth_t        zstds_ext_get_buffer_growth_option_value(VALUE options, const char* name);
+zstds_ext_dictionary_algorithm_t zstds_ext_get_dictionary_algorithm_option_value(VALUE options, const char* name);
+zstds_ext_gvl_t                  zstds_ext_get_gvl_option_value(VALUE options, const char* name);
+size_t                           zstds_ext_get_gvl_threshold_option_value(VALUE options, const char* name);
+
+#define ZSTDS_EXT_GET_BOOL_OPTION(options, name)   size_t name = zstds_ext_get_bool_option_value(options, #name);
+#define ZSTDS_EXT_GET_SIZE_OPTION(options, name)   size_t name = zstds_ext_get_size_option_value(options, #name);
+#define ZSTDS_EXT_GET_DOUBLE_OPTION(options, name) double name = zstds_ext_get_double_option_value(options, #name);
+#define ZSTDS_EXT_GET_STRING_OPTION(options, name) VALUE name = zstds_ext_get_string_option_value(options, #name);
+#define ZSTDS_EXT_GET_BUFFER_GROWTH_OPTION(options, name) \
+  zstds_ext_buffer_growth_t name = zstds_ext_get_buffer_growth_option_value(options, #name);
+#define ZSTDS_EXT_GET_DICTIONARY_ALGORITHM_OPTION(options, name) \
+  zstds_ext_dictionary_algorithm_t name = zstds_ext_get_dictionary_algorithm_option_value(options, #name);
+
+// GVL option is resolved into boolean "gvl" later, when processed length is known.
+#define ZSTDS_EXT_GET_GVL_OPTION(options) zstds_ext_gvl_t gvl_mode = zstds_ext_get_gvl_option_value(options, "gvl");
+#define ZSTDS_EXT_GET_GVL_THRESHOLD_OPTION(options) \
+  size_t gvl_threshold = zstds_ext_get_gvl_threshold_option_value(options, "gvl_threshold");
 
 zstds_ext_result_t zstds_ext_set_compressor_options(ZSTD_CCtx* ctx, zstds_ext_compressor_options_t* options);
 zstds_ext_result_t zstds_ext_set_decompressor_options(ZSTD_DCtx* ctx, zstds_ext_decompressor_options_t* options);
 
+// Reference is used as prefix for next frame only, it should be kept until frame is finished.
+// Compressor window log and long distance matching are enabled for reference when user didn't set them.
+// Decompressor window log max is not limited when user didn't set it.
+
+zstds_ext_result_t zstds_ext_set_compressor_reference(
+  ZSTD_CCtx*                      ctx,
+  zstds_ext_compressor_options_t* options,
+  const void*                     reference,
+  size_t                          reference_length);
+
+zstds_ext_result_t zstds_ext_set_decompressor_reference(
+  ZSTD_DCtx*                        ctx,
+  zstds_ext_decompressor_options_t* options,
+  const void*                       reference,
+  size_t                            reference_length);
+
+// Workspace size is enough for static context with any source size.
+// Decompressor workspace depends on window log max option.
+// Not implemented error is returned when zstd doesn't provide static workspace support.
+
+zstds_ext_result_t zstds_ext_get_compressor_workspace_size(zstds_ext_compressor_options_t* options, size_t* size_ptr);
+zstds_ext_result_t zstds_ext_get_decompressor_workspace_size(
+  zstds_ext_decompressor_options_t* options,
+  size_t*                           size_ptr);
+
 void zstds_ext_option_exports(VALUE root_module);
 
 #endif // ZSTDS_EXT_OPTIONS_H
@@ -0,0 +1,497 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#include "zstds_ext/pipeline.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "zstds_ext/error.h"
+
+// -- ring --
+
+// Ring has single producer and single consumer, they exchange chunks using atomic indexes.
+// Thread sleeps only when ring is full (producer) or empty (consumer).
+
+typedef struct
+{
+  zstds_ext_byte_t*  buffer;
+  size_t             length;
+  zstds_ext_result_t ext_result;
+} chunk_t;
+
+typedef struct
+{
+  chunk_t         chunks[ZSTDS_EXT_PIPELINE_CHUNKS_LENGTH];
+  atomic_size_t   head;
+  atomic_size_t   tail;
+  atomic_bool     is_producer_waiting;
+  atomic_bool     is_consumer_waiting;
+  pthread_mutex_t mutex;
+  pthread_cond_t  changed;
+} ring_t;
+
+static inline bool is_ring_ready(ring_t* ring_ptr, bool is_producer)
+{
+  size_t length = atomic_load(&ring_ptr->tail) - atomic_load(&ring_ptr->head);
+
+  return is_producer ? length != ZSTDS_EXT_PIPELINE_CHUNKS_LENGTH : length != 0;
+}
+
+static inline atomic_bool* get_ring_waiting_flag(ring_t* ring_ptr, bool is_producer)
+{
+  return is_producer ? &ring_ptr->is_producer_waiting : &ring_ptr->is_consumer_waiting;
+}
+
+// Producer and consumer have separate waiting flags, so one side can't reset flag of another side.
+// Waiting flag is set before ring check, so waiting thread will receive changes or notification.
+
+static inline void notify_ring(ring_t* ring_ptr, bool is_producer)
+{
+  if (atomic_load(get_ring_waiting_flag(ring_ptr, is_producer))) {
+    pthread_mutex_lock(&ring_ptr->mutex);
+    pthread_cond_broadcast(&ring_ptr->changed);
+    pthread_mutex_unlock(&ring_ptr->mutex);
+  }
+}
+
+// -- pipeline --
+
+struct zstds_ext_pipeline
+{
+  int    source_fd;
+  size_t source_buffer_length;
+  int    destination_fd;
+  size_t destination_buffer_length;
+
+  ring_t source_ring;
+  ring_t destination_ring;
+
+  zstds_ext_byte_t* buffers;
+
+  // Cancel pipe wakes reader and writer threads waiting for descriptors.
+  int                cancel_fds[2];
+  atomic_bool        is_cancelled;
+  atomic_bool        is_interrupted;
+  zstds_ext_result_t writer_ext_result;
+
+  pthread_t reader_thread;
+  pthread_t writer_thread;
+  bool      is_reader_started;
+  bool      is_writer_started;
+};
+
+// Cancelled pipeline can't be used anymore.
+
+static inline bool wait_ring(zstds_ext_pipeline_t* pipeline_ptr, ring_t* ring_ptr, bool is_producer)
+{
+  if (atomic_load(&pipeline_ptr->is_cancelled)) {
+    return false;
+  }
+
+  if (is_ring_ready(ring_ptr, is_producer)) {
+    return true;
+  }
+
+  atomic_bool* is_waiting_ptr = get_ring_waiting_flag(ring_ptr, is_producer);
+
+  pthread_mutex_lock(&ring_ptr->mutex);
+  atomic_store(is_waiting_ptr, true);
+
+  while (!is_ring_ready(ring_ptr, is_producer) && !atomic_load(&pipeline_ptr->is_cancelled)) {
+    pthread_cond_wait(&ring_ptr->changed, &ring_ptr->mutex);
+  }
+
+  atomic_store(is_waiting_ptr, false);
+  pthread_mutex_unlock(&ring_ptr->mutex);
+
+  return !atomic_load(&pipeline_ptr->is_cancelled);
+}
+
+static inline void cancel_ring(ring_t* ring_ptr)
+{
+  pthread_mutex_lock(&ring_ptr->mutex);
+  pthread_cond_broadcast(&ring_ptr->changed);
+  pthread_mutex_unlock(&ring_ptr->mutex);
+}
+
+static inline void cancel_pipeline(zstds_ext_pipeline_t* pipeline_ptr)
+{
+  if (atomic_exchange(&pipeline_ptr->is_cancelled, true)) {
+    return;
+  }
+
+  char byte = 0;
+  while (write(pipeline_ptr->cancel_fds[1], &byte, 1) < 0 && errno == EINTR) {
+  }
+
+  cancel_ring(&pipeline_ptr->source_ring);
+  cancel_ring(&pipeline_ptr->destination_ring);
+}
+
+// Reader and writer threads can fail after interrupt, so interrupt has priority over their results.
+
+static inline bool is_pipeline_interrupted(zstds_ext_pipeline_t* pipeline_ptr)
+{
+  return atomic_load(&pipeline_ptr->is_interrupted);
+}
+
+static inline zstds_ext_result_t get_cancelled_result(zstds_ext_pipeline_t* pipeline_ptr)
+{
+  if (is_pipeline_interrupted(pipeline_ptr)) {
+    return ZSTDS_EXT_PIPELINE_INTERRUPTED;
+  }
+
+  // Otherwise pipeline can be cancelled by writer thread only.
+  return pipeline_ptr->writer_ext_result;
+}
+
+// -- file --
+
+// Descriptor may be blocking, so we are waiting for descriptor and cancel pipe together.
+
+static inline bool wait_file(zstds_ext_pipeline_t* pipeline_ptr, int fd, short events)
+{
+  struct pollfd poll_fds[2] = {
+    {.fd = fd, .events = events, .revents = 0}, {.fd = pipeline_ptr->cancel_fds[0], .events = POLLIN, .revents = 0}};
+
+  while (true) {
+    if (poll(poll_fds, 2, -1) >= 0) {
+      // Error or hang up will be received by next read or write.
+      return poll_fds[1].revents == 0;
+    }
+
+    if (errno != EINTR) {
+      return false;
+    }
+  }
+}
+
+static inline zstds_ext_result_t
+  read_file(zstds_ext_pipeline_t* pipeline_ptr, zstds_ext_byte_t* buffer, size_t* length_ptr)
+{
+  int fd = pipeline_ptr->source_fd;
+
+  while (true) {
+    if (!wait_file(pipeline_ptr, fd, POLLIN)) {
+      return ZSTDS_EXT_ERROR_READ_IO;
+    }
+
+    ssize_t read_length = read(fd, buffer, pipeline_ptr->source_buffer_length);
+    if (read_length >= 0) {
+      *length_ptr = read_length;
+      return 0;
+    }
+
+    if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+      return ZSTDS_EXT_ERROR_READ_IO;
+    }
+  }
+}
+
+static inline zstds_ext_result_t write_file(zstds_ext_pipeline_t* pipeline_ptr, zstds_ext_byte_t* buffer, size_t length)
+{
+  int fd = pipeline_ptr->destination_fd;
+
+  while (length != 0) {
+    if (!wait_file(pipeline_ptr, fd, POLLOUT)) {
+      return ZSTDS_EXT_ERROR_WRITE_IO;
+    }
+
+    ssize_t written_length = write(fd, buffer, length);
+    if (written_length >= 0) {
+      buffer += written_length;
+      length -= written_length;
+      continue;
+    }
+
+    if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+      return ZSTDS_EXT_ERROR_WRITE_IO;
+    }
+  }
+
+  return 0;
+}
+
+// -- threads --
+
+// Reader thread finishes after source end or error, it is provided as last chunk.
+
+static void* run_reader(void* data)
+{
+  zstds_ext_pipeline_t* pipeline_ptr = data;
+  ring_t*               ring_ptr     = &pipeline_ptr->source_ring;
+
+  while (wait_ring(pipeline_ptr, ring_ptr, true)) {
+    size_t   tail      = atomic_load_explicit(&ring_ptr->tail, memory_order_relaxed);
+    chunk_t* chunk_ptr = &ring_ptr->chunks[tail % ZSTDS_EXT_PIPELINE_CHUNKS_LENGTH];
+
+    chunk_ptr->ext_result = read_file(pipeline_ptr, chunk_ptr->buffer, &chunk_ptr->length);
+
+    atomic_store(&ring_ptr->tail, tail + 1);
+    notify_ring(ring_ptr, false);
+
+    if (chunk_ptr->ext_result != 0 || chunk_ptr->length == 0) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+// Writer thread finishes after empty chunk or error, error cancels pipeline.
+
+static void* run_writer(void* data)
+{
+  zstds_ext_pipeline_t* pipeline_ptr = data;
+  ring_t*               ring_ptr     = &pipeline_ptr->destination_ring;
+
+  while (wait_ring(pipeline_ptr, ring_ptr, false)) {
+    size_t   head      = atomic_load_explicit(&ring_ptr->head, memory_order_relaxed);
+    chunk_t* chunk_ptr = &ring_ptr->chunks[head % ZSTDS_EXT_PIPELINE_CHUNKS_LENGTH];
+
+    if (chunk_ptr->length == 0) {
+      break;
+    }
+
+    zstds_ext_result_t ext_result = write_file(pipeline_ptr, chunk_ptr->buffer, chunk_ptr->length);
+    if (ext_result != 0) {
+      pipeline_ptr->writer_ext_result = ext_result;
+      cancel_pipeline(pipeline_ptr);
+      break;
+    }
+
+    atomic_store(&ring_ptr->head, head + 1);
+    notify_ring(ring_ptr, true);
+  }
+
+  return NULL;
+}
+
+// Signals should be received by ruby threads only.
+
+static inline bool create_thread(pthread_t* thread_ptr, void* (*function)(void*), void* data)
+{
+  sigset_t signals, old_signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_SETMASK, &signals, &old_signals);
+
+  bool is_created = pthread_create(thread_ptr, NULL, function, data) == 0;
+
+  pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+
+  return is_created;
+}
+
+// -- create --
+
+static inline void init_ring(ring_t* ring_ptr, zstds_ext_byte_t* buffers, size_t buffer_length)
+{
+  for (size_t index = 0; index < ZSTDS_EXT_PIPELINE_CHUNKS_LENGTH; index++) {
+    chunk_t* chunk_ptr    = &ring_ptr->chunks[index];
+    chunk_ptr->buffer     = buffers + buffer_length * index;
+    chunk_ptr->length     = 0;
+    chunk_ptr->ext_result = 0;
+  }
+
+  atomic_init(&ring_ptr->head, 0);
+  atomic_init(&ring_ptr->tail, 0);
+  atomic_init(&ring_ptr->is_producer_waiting, false);
+  atomic_init(&ring_ptr->is_consumer_waiting, false);
+  pthread_mutex_init(&ring_ptr->mutex, NULL);
+  pthread_cond_init(&ring_ptr->changed, NULL);
+}
+
+static inline void free_ring(ring_t* ring_ptr)
+{
+  pthread_mutex_destroy(&ring_ptr->mutex);
+  pthread_cond_destroy(&ring_ptr->changed);
+}
+
+zstds_ext_result_t zstds_ext_create_pipeline(
+  zstds_ext_pipeline_t** pipeline_ptr_ptr,
+  int                    source_fd,
+  size_t                 source_buffer_length,
+  int                    destination_fd,
+  size_t                 destination_buffer_length)
+{
+  size_t chunks_length = ZSTDS_EXT_PIPELINE_CHUNKS_LENGTH;
+  if (
+    destination_buffer_length > SIZE_MAX / chunks_length ||
+    source_buffer_length > SIZE_MAX / chunks_length - destination_buffer_length) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  zstds_ext_pipeline_t* pipeline_ptr = malloc(sizeof(zstds_ext_pipeline_t));
+  if (pipeline_ptr == NULL) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  zstds_ext_byte_t* buffers = malloc((source_buffer_length + destination_buffer_length) * chunks_length);
+  if (buffers == NULL) {
+    free(pipeline_ptr);
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  if (pipe(pipeline_ptr->cancel_fds) != 0) {
+    free(buffers);
+    free(pipeline_ptr);
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  fcntl(pipeline_ptr->cancel_fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(pipeline_ptr->cancel_fds[1], F_SETFD, FD_CLOEXEC);
+
+  pipeline_ptr->source_fd                 = source_fd;
+  pipeline_ptr->source_buffer_length      = source_buffer_length;
+  pipeline_ptr->destination_fd            = destination_fd;
+  pipeline_ptr->destination_buffer_length = destination_buffer_length;
+  pipeline_ptr->buffers                   = buffers;
+  pipeline_ptr->writer_ext_result         = 0;
+  pipeline_ptr->is_reader_started         = false;
+  pipeline_ptr->is_writer_started         = false;
+
+  atomic_init(&pipeline_ptr->is_cancelled, false);
+  atomic_init(&pipeline_ptr->is_interrupted, false);
+
+  init_ring(&pipeline_ptr->source_ring, buffers, source_buffer_length);
+  init_ring(
+    &pipeline_ptr->destination_ring, buffers + source_buffer_length * chunks_length, destination_buffer_length);
+
+  pipeline_ptr->is_reader_started = create_thread(&pipeline_ptr->reader_thread, run_reader, pipeline_ptr);
+  if (pipeline_ptr->is_reader_started) {
+    pipeline_ptr->is_writer_started = create_thread(&pipeline_ptr->writer_thread, run_writer, pipeline_ptr);
+  }
+
+  if (!pipeline_ptr->is_writer_started) {
+    zstds_ext_free_pipeline(pipeline_ptr);
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  *pipeline_ptr_ptr = pipeline_ptr;
+
+  return 0;
+}
+
+// -- source --
+
+zstds_ext_result_t zstds_ext_pipeline_read_source(
+  zstds_ext_pipeline_t* pipeline_ptr, const zstds_ext_byte_t** source_ptr, size_t* source_length_ptr)
+{
+  ring_t* ring_ptr = &pipeline_ptr->source_ring;
+
+  if (!wait_ring(pipeline_ptr, ring_ptr, false)) {
+    return get_cancelled_result(pipeline_ptr);
+  }
+
+  size_t   head      = atomic_load_explicit(&ring_ptr->head, memory_order_relaxed);
+  chunk_t* chunk_ptr = &ring_ptr->chunks[head % ZSTDS_EXT_PIPELINE_CHUNKS_LENGTH];
+
+  if (chunk_ptr->ext_result != 0) {
+    return is_pipeline_interrupted(pipeline_ptr) ? ZSTDS_EXT_PIPELINE_INTERRUPTED : chunk_ptr->ext_result;
+  }
+
+  *source_ptr        = chunk_ptr->buffer;
+  *source_length_ptr = chunk_ptr->length;
+
+  return 0;
+}
+
+void zstds_ext_pipeline_release_source(zstds_ext_pipeline_t* pipeline_ptr)
+{
+  ring_t* ring_ptr = &pipeline_ptr->source_ring;
+
+  atomic_fetch_add(&ring_ptr->head, 1);
+  notify_ring(ring_ptr, true);
+}
+
+// -- destination --
+
+zstds_ext_result_t
+  zstds_ext_pipeline_acquire_destination(zstds_ext_pipeline_t* pipeline_ptr, zstds_ext_byte_t** destination_buffer_ptr)
+{
+  ring_t* ring_ptr = &pipeline_ptr->destination_ring;
+
+  if (!wait_ring(pipeline_ptr, ring_ptr, true)) {
+    return get_cancelled_result(pipeline_ptr);
+  }
+
+  size_t tail = atomic_load_explicit(&ring_ptr->tail, memory_order_relaxed);
+
+  *destination_buffer_ptr = ring_ptr->chunks[tail % ZSTDS_EXT_PIPELINE_CHUNKS_LENGTH].buffer;
+
+  return 0;
+}
+
+void zstds_ext_pipeline_write_destination(zstds_ext_pipeline_t* pipeline_ptr, size_t destination_length)
+{
+  ring_t* ring_ptr = &pipeline_ptr->destination_ring;
+  size_t  tail     = atomic_load_explicit(&ring_ptr->tail, memory_order_relaxed);
+
+  ring_ptr->chunks[tail % ZSTDS_EXT_PIPELINE_CHUNKS_LENGTH].length = destination_length;
+
+  atomic_store(&ring_ptr->tail, tail + 1);
+  notify_ring(ring_ptr, false);
+}
+
+// -- finish --
+
+zstds_ext_result_t zstds_ext_pipeline_finish(zstds_ext_pipeline_t* pipeline_ptr)
+{
+  zstds_ext_byte_t* destination_buffer;
+
+  zstds_ext_result_t ext_result = zstds_ext_pipeline_acquire_destination(pipeline_ptr, &destination_buffer);
+  if (ext_result != 0) {
+    return ext_result;
+  }
+
+  // Empty chunk finishes writer thread.
+  zstds_ext_pipeline_write_destination(pipeline_ptr, 0);
+
+  pthread_join(pipeline_ptr->writer_thread, NULL);
+  pipeline_ptr->is_writer_started = false;
+
+  if (pipeline_ptr->writer_ext_result != 0) {
+    return get_cancelled_result(pipeline_ptr);
+  }
+
+  return 0;
+}
+
+// -- interrupt --
+
+void zstds_ext_interrupt_pipeline(zstds_ext_pipeline_t* pipeline_ptr)
+{
+  atomic_store(&pipeline_ptr->is_interrupted, true);
+  cancel_pipeline(pipeline_ptr);
+}
+
+void zstds_ext_free_pipeline(zstds_ext_pipeline_t* pipeline_ptr)
+{
+  cancel_pipeline(pipeline_ptr);
+
+  if (pipeline_ptr->is_reader_started) {
+    pthread_join(pipeline_ptr->reader_thread, NULL);
+  }
+
+  if (pipeline_ptr->is_writer_started) {
+    pthread_join(pipeline_ptr->writer_thread, NULL);
+  }
+
+  free_ring(&pipeline_ptr->source_ring);
+  free_ring(&pipeline_ptr->destination_ring);
+
+  close(pipeline_ptr->cancel_fds[0]);
+  close(pipeline_ptr->cancel_fds[1]);
+
+  free(pipeline_ptr->buffers);
+  free(pipeline_ptr);
+}
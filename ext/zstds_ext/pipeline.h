@@ -0,0 +1,58 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#if !defined(ZSTDS_EXT_PIPELINE_H)
+#define ZSTDS_EXT_PIPELINE_H
+
+#include <stddef.h>
+
+#include "zstds_ext/common.h"
+
+// Each ring keeps several chunks, so reader and writer threads can work ahead of algorithm.
+#define ZSTDS_EXT_PIPELINE_CHUNKS_LENGTH 4
+
+// Additional possible result:
+enum
+{
+  ZSTDS_EXT_PIPELINE_INTERRUPTED = 192
+};
+
+// Pipeline reads source chunks using reader thread and writes destination chunks using writer thread.
+// Current thread receives source chunks and provides destination chunks in order.
+// All functions can't use ruby api, so they can be used without GVL.
+
+typedef struct zstds_ext_pipeline zstds_ext_pipeline_t;
+
+zstds_ext_result_t zstds_ext_create_pipeline(
+  zstds_ext_pipeline_t** pipeline_ptr,
+  int                    source_fd,
+  size_t                 source_buffer_length,
+  int                    destination_fd,
+  size_t                 destination_buffer_length);
+
+// Zero source length means that source is finished.
+// Source can be accessed until it will be released.
+
+zstds_ext_result_t zstds_ext_pipeline_read_source(
+  zstds_ext_pipeline_t* pipeline_ptr, const zstds_ext_byte_t** source_ptr, size_t* source_length_ptr);
+
+void zstds_ext_pipeline_release_source(zstds_ext_pipeline_t* pipeline_ptr);
+
+// Destination buffer has destination buffer length, it can be written after acquire only.
+
+zstds_ext_result_t
+  zstds_ext_pipeline_acquire_destination(zstds_ext_pipeline_t* pipeline_ptr, zstds_ext_byte_t** destination_buffer_ptr);
+
+void zstds_ext_pipeline_write_destination(zstds_ext_pipeline_t* pipeline_ptr, size_t destination_length);
+
+// Waits until all destination chunks will be written.
+zstds_ext_result_t zstds_ext_pipeline_finish(zstds_ext_pipeline_t* pipeline_ptr);
+
+// Cancels pipeline from another thread, it can be used as unblocking function.
+// Current thread will receive interrupted result.
+void zstds_ext_interrupt_pipeline(zstds_ext_pipeline_t* pipeline_ptr);
+
+// Cancels unfinished pipeline.
+void zstds_ext_free_pipeline(zstds_ext_pipeline_t* pipeline_ptr);
+
+#endif // ZSTDS_EXT_PIPELINE_H
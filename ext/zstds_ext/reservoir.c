@@ -0,0 +1,245 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#include "zstds_ext/reservoir.h"
+
+#include <string.h>
+
+#include "zstds_ext/error.h"
+
+#define INITIAL_SAMPLES_CAPACITY 64
+
+// -- initialization --
+
+static inline void free_samples(zstds_ext_reservoir_sample_t* samples, size_t samples_length)
+{
+  for (size_t index = 0; index < samples_length; index++) {
+    free(samples[index].data);
+  }
+
+  free(samples);
+}
+
+static void free_reservoir(zstds_ext_reservoir_t* reservoir_ptr)
+{
+  zstds_ext_reservoir_sample_t* samples = reservoir_ptr->samples;
+  if (samples != NULL) {
+    free_samples(samples, reservoir_ptr->samples_length);
+  }
+
+  if (reservoir_ptr->samples_size != 0) {
+    rb_gc_adjust_memory_usage(-(ssize_t) reservoir_ptr->samples_size);
+  }
+
+  free(reservoir_ptr);
+}
+
+static size_t get_reservoir_size(const zstds_ext_reservoir_t* reservoir_ptr)
+{
+  return sizeof(zstds_ext_reservoir_t) + reservoir_ptr->samples_capacity * sizeof(zstds_ext_reservoir_sample_t) +
+         reservoir_ptr->samples_size;
+}
+
+static const rb_data_type_t reservoir_type = {
+  .wrap_struct_name = "ZSTDS::Dictionary::Reservoir",
+  .function =
+    {.dmark = NULL, .dfree = (RUBY_DATA_FUNC) free_reservoir, .dsize = (size_t(*)(const void*)) get_reservoir_size},
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY};
+
+static VALUE allocate_reservoir(VALUE klass)
+{
+  zstds_ext_reservoir_t* reservoir_ptr;
+  VALUE                  self = TypedData_Make_Struct(klass, zstds_ext_reservoir_t, &reservoir_type, reservoir_ptr);
+
+  reservoir_ptr->samples                 = NULL;
+  reservoir_ptr->samples_length          = 0;
+  reservoir_ptr->samples_capacity        = 0;
+  reservoir_ptr->samples_size            = 0;
+  reservoir_ptr->max_samples_size        = 0;
+  reservoir_ptr->received_samples_length = 0;
+
+  return self;
+}
+
+#define GET_RESERVOIR(self)             \
+  zstds_ext_reservoir_t* reservoir_ptr; \
+  TypedData_Get_Struct(self, zstds_ext_reservoir_t, &reservoir_type, reservoir_ptr);
+
+static VALUE initialize_reservoir(VALUE self, VALUE max_samples_size)
+{
+  GET_RESERVOIR(self);
+  Check_Type(max_samples_size, T_FIXNUM);
+
+  size_t max_samples_size_value = NUM2SIZET(max_samples_size);
+  if (max_samples_size_value == 0) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  reservoir_ptr->max_samples_size = max_samples_size_value;
+
+  return Qnil;
+}
+
+// -- samples --
+
+// Samples size is reported to ruby GC, reservoir may keep hundreds of MB.
+
+static inline void add_samples_size(zstds_ext_reservoir_t* reservoir_ptr, size_t size)
+{
+  reservoir_ptr->samples_size += size;
+  rb_gc_adjust_memory_usage((ssize_t) size);
+}
+
+static inline void remove_samples_size(zstds_ext_reservoir_t* reservoir_ptr, size_t size)
+{
+  reservoir_ptr->samples_size -= size;
+  rb_gc_adjust_memory_usage(-(ssize_t) size);
+}
+
+static inline zstds_ext_byte_t* copy_sample_data(VALUE sample)
+{
+  size_t            size = RSTRING_LEN(sample);
+  zstds_ext_byte_t* data = malloc(size);
+  if (data == NULL) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  }
+
+  memcpy(data, RSTRING_PTR(sample), size);
+
+  return data;
+}
+
+static inline void append_sample(zstds_ext_reservoir_t* reservoir_ptr, VALUE sample)
+{
+  size_t samples_length = reservoir_ptr->samples_length;
+
+  if (samples_length == reservoir_ptr->samples_capacity) {
+    size_t samples_capacity = samples_length == 0 ? INITIAL_SAMPLES_CAPACITY : samples_length * 2;
+
+    zstds_ext_reservoir_sample_t* samples =
+      realloc(reservoir_ptr->samples, samples_capacity * sizeof(zstds_ext_reservoir_sample_t));
+    if (samples == NULL) {
+      zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    }
+
+    reservoir_ptr->samples          = samples;
+    reservoir_ptr->samples_capacity = samples_capacity;
+  }
+
+  zstds_ext_reservoir_sample_t* sample_ptr = &reservoir_ptr->samples[samples_length];
+  sample_ptr->data                         = copy_sample_data(sample);
+  sample_ptr->size                         = RSTRING_LEN(sample);
+
+  reservoir_ptr->samples_length = samples_length + 1;
+  add_samples_size(reservoir_ptr, sample_ptr->size);
+}
+
+static inline void replace_sample(zstds_ext_reservoir_t* reservoir_ptr, size_t index, VALUE sample)
+{
+  zstds_ext_reservoir_sample_t* sample_ptr = &reservoir_ptr->samples[index];
+  zstds_ext_byte_t*             data       = copy_sample_data(sample);
+
+  free(sample_ptr->data);
+  remove_samples_size(reservoir_ptr, sample_ptr->size);
+
+  sample_ptr->data = data;
+  sample_ptr->size = RSTRING_LEN(sample);
+  add_samples_size(reservoir_ptr, sample_ptr->size);
+}
+
+// Samples are appended until max size is reached.
+// After that each received sample replaces random sample with probability "length / received length".
+// Sample is dropped when replacement doesn't fit into max size, sample larger than max size is ignored.
+
+static VALUE add_sample(VALUE self, VALUE sample)
+{
+  GET_RESERVOIR(self);
+  Check_Type(sample, T_STRING);
+
+  size_t size = RSTRING_LEN(sample);
+  if (size == 0) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  size_t max_samples_size = reservoir_ptr->max_samples_size;
+  if (size > max_samples_size) {
+    return Qfalse;
+  }
+
+  size_t received_samples_length = ++reservoir_ptr->received_samples_length;
+  size_t samples_length          = reservoir_ptr->samples_length;
+  size_t samples_size            = reservoir_ptr->samples_size;
+
+  if (samples_length == received_samples_length - 1 && size <= max_samples_size - samples_size) {
+    append_sample(reservoir_ptr, sample);
+    return Qtrue;
+  }
+
+  size_t index = rb_genrand_ulong_limited(received_samples_length - 1);
+  if (index >= samples_length) {
+    return Qfalse;
+  }
+
+  size_t replaced_size = reservoir_ptr->samples[index].size;
+  if (size > max_samples_size - (samples_size - replaced_size)) {
+    return Qfalse;
+  }
+
+  replace_sample(reservoir_ptr, index, sample);
+
+  return Qtrue;
+}
+
+zstds_ext_reservoir_sample_t* zstds_ext_take_reservoir_samples(VALUE self, size_t* samples_length_ptr)
+{
+  GET_RESERVOIR(self);
+
+  zstds_ext_reservoir_sample_t* samples = reservoir_ptr->samples;
+  *samples_length_ptr                   = reservoir_ptr->samples_length;
+
+  remove_samples_size(reservoir_ptr, reservoir_ptr->samples_size);
+
+  reservoir_ptr->samples                 = NULL;
+  reservoir_ptr->samples_length          = 0;
+  reservoir_ptr->samples_capacity        = 0;
+  reservoir_ptr->received_samples_length = 0;
+
+  return samples;
+}
+
+// -- other --
+
+static VALUE get_samples_length(VALUE self)
+{
+  GET_RESERVOIR(self);
+
+  return SIZET2NUM(reservoir_ptr->samples_length);
+}
+
+static VALUE get_samples_size(VALUE self)
+{
+  GET_RESERVOIR(self);
+
+  return SIZET2NUM(reservoir_ptr->samples_size);
+}
+
+static VALUE get_received_samples_length(VALUE self)
+{
+  GET_RESERVOIR(self);
+
+  return SIZET2NUM(reservoir_ptr->received_samples_length);
+}
+
+// -- exports --
+
+void zstds_ext_reservoir_exports(VALUE dictionary)
+{
+  VALUE reservoir = rb_define_class_under(dictionary, "Reservoir", rb_cObject);
+
+  rb_define_alloc_func(reservoir, allocate_reservoir);
+  rb_define_method(reservoir, "initialize", initialize_reservoir, 1);
+  rb_define_method(reservoir, "add", add_sample, 1);
+  rb_define_method(reservoir, "samples_length", get_samples_length, 0);
+  rb_define_method(reservoir, "samples_size", get_samples_size, 0);
+  rb_define_method(reservoir, "received_samples_length", get_received_samples_length, 0);
+}
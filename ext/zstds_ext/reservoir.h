@@ -0,0 +1,37 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#if !defined(ZSTDS_EXT_RESERVOIR_H)
+#define ZSTDS_EXT_RESERVOIR_H
+
+#include <stddef.h>
+
+#include "ruby.h"
+#include "zstds_ext/common.h"
+
+// Reservoir keeps native copies of dictionary samples, total size of samples is limited by max size.
+// Samples are received one by one, reservoir keeps random subset of them when max size is reached.
+
+typedef struct
+{
+  zstds_ext_byte_t* data;
+  size_t            size;
+} zstds_ext_reservoir_sample_t;
+
+typedef struct
+{
+  zstds_ext_reservoir_sample_t* samples;
+  size_t                        samples_length;
+  size_t                        samples_capacity;
+  size_t                        samples_size;
+  size_t                        max_samples_size;
+  size_t                        received_samples_length;
+} zstds_ext_reservoir_t;
+
+// Samples are moved out of reservoir, reservoir becomes empty.
+// Samples and their data should be freed by receiver.
+zstds_ext_reservoir_sample_t* zstds_ext_take_reservoir_samples(VALUE self, size_t* samples_length_ptr);
+
+void zstds_ext_reservoir_exports(VALUE dictionary);
+
+#endif // ZSTDS_EXT_RESERVOIR_H
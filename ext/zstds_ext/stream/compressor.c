@@ -3,14 +3,29 @@
 
 #include "zstds_ext/stream/compressor.h"
 
+#include "zstds_ext/buffer.h"
 #include "zstds_ext/error.h"
 #include "zstds_ext/gvl.h"
+#include "zstds_ext/io.h"
 #include "zstds_ext/option.h"
 
 // -- initialization --
 
-static void free_compressor(zstds_ext_compressor_t* compressor_ptr)
+static void mark_compressor(zstds_ext_compressor_t* compressor_ptr)
+{
+  rb_gc_mark(compressor_ptr->dictionary);
+}
+
+// Static context and destination buffer are placed inside workspace.
+
+static inline void free_context(zstds_ext_compressor_t* compressor_ptr)
 {
+  void* workspace = compressor_ptr->workspace;
+  if (workspace != NULL) {
+    zstds_ext_free_memory(&compressor_ptr->memory, workspace);
+    return;
+  }
+
   ZSTD_CCtx* ctx = compressor_ptr->ctx;
   if (ctx != NULL) {
     ZSTD_freeCCtx(ctx);
@@ -18,66 +33,139 @@ static void free_compressor(zstds_ext_compressor_t* compressor_ptr)
 
   zstds_ext_byte_t* destination_buffer = compressor_ptr->destination_buffer;
   if (destination_buffer != NULL) {
-    free(destination_buffer);
+    zstds_ext_free_memory(&compressor_ptr->memory, destination_buffer);
   }
+}
+
+static void free_compressor(zstds_ext_compressor_t* compressor_ptr)
+{
+  free_context(compressor_ptr);
+
+  // Ruby GC receives released size.
+  zstds_ext_report_memory(&compressor_ptr->memory);
 
   free(compressor_ptr);
 }
 
+static size_t get_compressor_size(zstds_ext_compressor_t* compressor_ptr)
+{
+  size_t size = sizeof(zstds_ext_compressor_t);
+
+  // Workspace is the only memory allocated for static context.
+  if (compressor_ptr->workspace != NULL) {
+    return size + zstds_ext_get_memory_size(&compressor_ptr->memory);
+  }
+
+  ZSTD_CCtx* ctx = compressor_ptr->ctx;
+  if (ctx != NULL) {
+    size += ZSTD_sizeof_CCtx(ctx);
+  }
+
+  if (compressor_ptr->destination_buffer != NULL) {
+    size += compressor_ptr->destination_buffer_length;
+  }
+
+  return size;
+}
+
+static const rb_data_type_t compressor_type = {
+  .wrap_struct_name = "ZSTDS::Stream::NativeCompressor",
+  .function =
+    {.dmark = (RUBY_DATA_FUNC) mark_compressor,
+     .dfree = (RUBY_DATA_FUNC) free_compressor,
+     .dsize = (size_t(*)(const void*)) get_compressor_size},
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY};
+
 VALUE zstds_ext_allocate_compressor(VALUE klass)
 {
   zstds_ext_compressor_t* compressor_ptr;
-  VALUE                   self = Data_Make_Struct(klass, zstds_ext_compressor_t, NULL, free_compressor, compressor_ptr);
+  VALUE                   self = TypedData_Make_Struct(klass, zstds_ext_compressor_t, &compressor_type, compressor_ptr);
 
   compressor_ptr->ctx                                 = NULL;
+  compressor_ptr->workspace                           = NULL;
   compressor_ptr->destination_buffer                  = NULL;
   compressor_ptr->destination_buffer_length           = 0;
   compressor_ptr->remaining_destination_buffer        = NULL;
   compressor_ptr->remaining_destination_buffer_length = 0;
-  compressor_ptr->gvl                                 = false;
+  compressor_ptr->pending_source_length               = 0;
+  compressor_ptr->gvl                                 = ZSTDS_EXT_GVL_RELEASE;
+  compressor_ptr->dictionary                          = Qnil;
+
+  zstds_ext_init_stream_stats(&compressor_ptr->stats);
+  zstds_ext_init_memory(&compressor_ptr->memory);
 
   return self;
 }
 
 #define GET_COMPRESSOR(self)              \
   zstds_ext_compressor_t* compressor_ptr; \
-  Data_Get_Struct(self, zstds_ext_compressor_t, compressor_ptr);
+  TypedData_Get_Struct(self, zstds_ext_compressor_t, &compressor_type, compressor_ptr);
 
 VALUE zstds_ext_initialize_compressor(VALUE self, VALUE options)
 {
   GET_COMPRESSOR(self);
   Check_Type(options, T_HASH);
   ZSTDS_EXT_GET_SIZE_OPTION(options, destination_buffer_length);
-  ZSTDS_EXT_GET_BOOL_OPTION(options, gvl);
+  ZSTDS_EXT_GET_BOOL_OPTION(options, static_workspace);
+  ZSTDS_EXT_GET_GVL_OPTION(options);
   ZSTDS_EXT_GET_COMPRESSOR_OPTIONS(options);
 
-  ZSTD_CCtx* ctx = ZSTD_createCCtx();
-  if (ctx == NULL) {
-    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  if (destination_buffer_length == 0) {
+    destination_buffer_length = ZSTD_CStreamOutSize();
+  }
+
+  void*             workspace = NULL;
+  zstds_ext_byte_t* destination_buffer;
+  ZSTD_CCtx*        ctx;
+
+  if (static_workspace) {
+    size_t             ctx_size;
+    zstds_ext_result_t ext_result = zstds_ext_get_compressor_workspace_size(&compressor_options, &ctx_size);
+    if (ext_result != 0) {
+      zstds_ext_raise_error(ext_result);
+    }
+
+    ctx = zstds_ext_create_static_cctx(
+      &compressor_ptr->memory, ctx_size, destination_buffer_length, &workspace, (void**) &destination_buffer);
+    if (ctx == NULL) {
+      zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    }
+  } else {
+    ctx = zstds_ext_create_memory_cctx(&compressor_ptr->memory);
+    if (ctx == NULL) {
+      zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    }
+
+    destination_buffer = zstds_ext_allocate_memory(&compressor_ptr->memory, destination_buffer_length);
+    if (destination_buffer == NULL) {
+      ZSTD_freeCCtx(ctx);
+      zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    }
   }
 
   zstds_ext_result_t ext_result = zstds_ext_set_compressor_options(ctx, &compressor_options);
   if (ext_result != 0) {
-    ZSTD_freeCCtx(ctx);
-    zstds_ext_raise_error(ext_result);
-  }
-
-  if (destination_buffer_length == 0) {
-    destination_buffer_length = ZSTD_CStreamOutSize();
-  }
+    if (workspace != NULL) {
+      zstds_ext_free_memory(&compressor_ptr->memory, workspace);
+    } else {
+      ZSTD_freeCCtx(ctx);
+      zstds_ext_free_memory(&compressor_ptr->memory, destination_buffer);
+    }
 
-  zstds_ext_byte_t* destination_buffer = malloc(destination_buffer_length);
-  if (destination_buffer == NULL) {
-    ZSTD_freeCCtx(ctx);
-    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    zstds_ext_raise_error(ext_result);
   }
 
   compressor_ptr->ctx                                 = ctx;
+  compressor_ptr->workspace                           = workspace;
   compressor_ptr->destination_buffer                  = destination_buffer;
   compressor_ptr->destination_buffer_length           = destination_buffer_length;
   compressor_ptr->remaining_destination_buffer        = destination_buffer;
   compressor_ptr->remaining_destination_buffer_length = destination_buffer_length;
-  compressor_ptr->gvl                                 = gvl;
+  compressor_ptr->pending_source_length               = 0;
+  compressor_ptr->gvl                                 = gvl_mode;
+  compressor_ptr->dictionary                          = compressor_options.dictionary;
+
+  zstds_ext_report_memory(&compressor_ptr->memory);
 
   return Qnil;
 }
@@ -101,21 +189,18 @@ static inline void* compress_wrapper(void* data)
 {
   compress_args_t* args = data;
 
-  args->result =
-    ZSTD_compressStream2(args->compressor_ptr->ctx, args->out_buffer_ptr, args->in_buffer_ptr, ZSTD_e_continue);
+  zstds_ext_compressor_t* compressor_ptr = args->compressor_ptr;
+
+  ZSTDS_EXT_STREAM_STATS_MEASURE_ZSTD(
+    &compressor_ptr->stats,
+    args->result =
+      ZSTD_compressStream2(compressor_ptr->ctx, args->out_buffer_ptr, args->in_buffer_ptr, ZSTD_e_continue));
 
   return NULL;
 }
 
-VALUE zstds_ext_compress(VALUE self, VALUE source_value)
+static inline size_t compress_source(zstds_ext_compressor_t* compressor_ptr, const char* source, size_t source_length)
 {
-  GET_COMPRESSOR(self);
-  DO_NOT_USE_AFTER_CLOSE(compressor_ptr);
-  Check_Type(source_value, T_STRING);
-
-  const char* source        = RSTRING_PTR(source_value);
-  size_t      source_length = RSTRING_LEN(source_value);
-
   ZSTD_inBuffer  in_buffer  = {.src = source, .size = source_length, .pos = 0};
   ZSTD_outBuffer out_buffer = {
     .dst  = compressor_ptr->remaining_destination_buffer,
@@ -124,7 +209,10 @@ VALUE zstds_ext_compress(VALUE self, VALUE source_value)
 
   compress_args_t args = {.compressor_ptr = compressor_ptr, .in_buffer_ptr = &in_buffer, .out_buffer_ptr = &out_buffer};
 
-  ZSTDS_EXT_GVL_WRAP(compressor_ptr->gvl, compress_wrapper, &args);
+  bool gvl = zstds_ext_keep_gvl(compressor_ptr->gvl, source_length);
+
+  ZSTDS_EXT_STREAM_STATS_GVL_WRAP(&compressor_ptr->stats, gvl, compress_wrapper, &args);
+  zstds_ext_report_memory(&compressor_ptr->memory);
   if (ZSTD_isError(args.result)) {
     zstds_ext_raise_error(zstds_ext_get_error(ZSTD_getErrorCode(args.result)));
   }
@@ -132,12 +220,54 @@ VALUE zstds_ext_compress(VALUE self, VALUE source_value)
   compressor_ptr->remaining_destination_buffer += out_buffer.pos;
   compressor_ptr->remaining_destination_buffer_length -= out_buffer.pos;
 
-  VALUE bytes_written          = SIZET2NUM(in_buffer.pos);
+  compressor_ptr->pending_source_length += in_buffer.pos;
+
+  compressor_ptr->stats.bytes_in += in_buffer.pos;
+  compressor_ptr->stats.bytes_out += out_buffer.pos;
+
+  return in_buffer.pos;
+}
+
+VALUE zstds_ext_compress(VALUE self, VALUE source_value)
+{
+  GET_COMPRESSOR(self);
+  DO_NOT_USE_AFTER_CLOSE(compressor_ptr);
+  Check_Type(source_value, T_STRING);
+
+  const char* source        = RSTRING_PTR(source_value);
+  size_t      source_length = RSTRING_LEN(source_value);
+
+  VALUE bytes_written          = SIZET2NUM(compress_source(compressor_ptr, source, source_length));
   VALUE needs_more_destination = compressor_ptr->remaining_destination_buffer_length == 0 ? Qtrue : Qfalse;
 
   return rb_ary_new_from_args(2, bytes_written, needs_more_destination);
 }
 
+// Part of source can be processed without slicing and result array allocation.
+
+VALUE zstds_ext_compress_part(VALUE self, VALUE source_value, VALUE offset_value, VALUE length_value)
+{
+  GET_COMPRESSOR(self);
+  DO_NOT_USE_AFTER_CLOSE(compressor_ptr);
+
+  size_t      source_length;
+  const char* source = zstds_ext_get_string_part(source_value, offset_value, length_value, &source_length);
+
+  size_t bytes_written = compress_source(compressor_ptr, source, source_length);
+
+  RB_GC_GUARD(source_value);
+
+  return SIZET2NUM(bytes_written);
+}
+
+VALUE zstds_ext_compressor_needs_more_destination(VALUE self)
+{
+  GET_COMPRESSOR(self);
+  DO_NOT_USE_AFTER_CLOSE(compressor_ptr);
+
+  return compressor_ptr->remaining_destination_buffer_length == 0 ? Qtrue : Qfalse;
+}
+
 // -- compressor flush --
 
 typedef struct
@@ -152,7 +282,11 @@ static inline void* compress_flush_wrapper(void* data)
   compress_flush_args_t* args      = data;
   ZSTD_inBuffer          in_buffer = {.src = NULL, .size = 0, .pos = 0};
 
-  args->result = ZSTD_compressStream2(args->compressor_ptr->ctx, args->out_buffer_ptr, &in_buffer, ZSTD_e_flush);
+  zstds_ext_compressor_t* compressor_ptr = args->compressor_ptr;
+
+  ZSTDS_EXT_STREAM_STATS_MEASURE_ZSTD(
+    &compressor_ptr->stats,
+    args->result = ZSTD_compressStream2(compressor_ptr->ctx, args->out_buffer_ptr, &in_buffer, ZSTD_e_flush));
 
   return NULL;
 }
@@ -169,7 +303,11 @@ VALUE zstds_ext_flush_compressor(VALUE self)
 
   compress_flush_args_t args = {.compressor_ptr = compressor_ptr, .out_buffer_ptr = &out_buffer};
 
-  ZSTDS_EXT_GVL_WRAP(compressor_ptr->gvl, compress_flush_wrapper, &args);
+  // Flush processes source that was not compressed yet.
+  bool gvl = zstds_ext_keep_gvl(compressor_ptr->gvl, compressor_ptr->pending_source_length);
+
+  ZSTDS_EXT_STREAM_STATS_GVL_WRAP(&compressor_ptr->stats, gvl, compress_flush_wrapper, &args);
+  zstds_ext_report_memory(&compressor_ptr->memory);
   if (ZSTD_isError(args.result)) {
     zstds_ext_raise_error(zstds_ext_get_error(ZSTD_getErrorCode(args.result)));
   }
@@ -177,6 +315,12 @@ VALUE zstds_ext_flush_compressor(VALUE self)
   compressor_ptr->remaining_destination_buffer += out_buffer.pos;
   compressor_ptr->remaining_destination_buffer_length -= out_buffer.pos;
 
+  compressor_ptr->stats.bytes_out += out_buffer.pos;
+
+  if (args.result == 0) {
+    compressor_ptr->pending_source_length = 0;
+  }
+
   return args.result != 0 ? Qtrue : Qfalse;
 }
 
@@ -194,7 +338,11 @@ static inline void* compress_finish_wrapper(void* data)
   compress_finish_args_t* args      = data;
   ZSTD_inBuffer           in_buffer = {.src = NULL, .size = 0, .pos = 0};
 
-  args->result = ZSTD_compressStream2(args->compressor_ptr->ctx, args->out_buffer_ptr, &in_buffer, ZSTD_e_end);
+  zstds_ext_compressor_t* compressor_ptr = args->compressor_ptr;
+
+  ZSTDS_EXT_STREAM_STATS_MEASURE_ZSTD(
+    &compressor_ptr->stats,
+    args->result = ZSTD_compressStream2(compressor_ptr->ctx, args->out_buffer_ptr, &in_buffer, ZSTD_e_end));
 
   return NULL;
 }
@@ -211,7 +359,11 @@ VALUE zstds_ext_finish_compressor(VALUE self)
 
   compress_finish_args_t args = {.compressor_ptr = compressor_ptr, .out_buffer_ptr = &out_buffer};
 
-  ZSTDS_EXT_GVL_WRAP(compressor_ptr->gvl, compress_finish_wrapper, &args);
+  // Finish processes source that was not compressed yet.
+  bool gvl = zstds_ext_keep_gvl(compressor_ptr->gvl, compressor_ptr->pending_source_length);
+
+  ZSTDS_EXT_STREAM_STATS_GVL_WRAP(&compressor_ptr->stats, gvl, compress_finish_wrapper, &args);
+  zstds_ext_report_memory(&compressor_ptr->memory);
   if (ZSTD_isError(args.result)) {
     zstds_ext_raise_error(zstds_ext_get_error(ZSTD_getErrorCode(args.result)));
   }
@@ -219,6 +371,13 @@ VALUE zstds_ext_finish_compressor(VALUE self)
   compressor_ptr->remaining_destination_buffer += out_buffer.pos;
   compressor_ptr->remaining_destination_buffer_length -= out_buffer.pos;
 
+  compressor_ptr->stats.bytes_out += out_buffer.pos;
+
+  if (args.result == 0) {
+    compressor_ptr->pending_source_length = 0;
+    compressor_ptr->stats.frames++;
+  }
+
   return args.result != 0 ? Qtrue : Qfalse;
 }
 
@@ -237,33 +396,102 @@ VALUE zstds_ext_compressor_read_result(VALUE self)
   size_t      result_length = destination_buffer_length - remaining_destination_buffer_length;
   VALUE       result_value  = rb_str_new(result, result_length);
 
+  if (result_length != 0) {
+    compressor_ptr->stats.flushes++;
+  }
+
   compressor_ptr->remaining_destination_buffer        = destination_buffer;
   compressor_ptr->remaining_destination_buffer_length = destination_buffer_length;
 
   return result_value;
 }
 
-// -- cleanup --
+// Result can be drained without allocation of new string.
 
-VALUE zstds_ext_compressor_close(VALUE self)
+VALUE zstds_ext_compressor_read_result_into(VALUE self, VALUE buffer)
 {
   GET_COMPRESSOR(self);
   DO_NOT_USE_AFTER_CLOSE(compressor_ptr);
+  Check_Type(buffer, T_STRING);
 
-  ZSTD_CCtx* ctx = compressor_ptr->ctx;
-  if (ctx != NULL) {
-    ZSTD_freeCCtx(ctx);
+  zstds_ext_byte_t* destination_buffer                  = compressor_ptr->destination_buffer;
+  size_t            destination_buffer_length           = compressor_ptr->destination_buffer_length;
+  size_t            remaining_destination_buffer_length = compressor_ptr->remaining_destination_buffer_length;
+
+  const char* result        = (const char*) destination_buffer;
+  size_t      result_length = destination_buffer_length - remaining_destination_buffer_length;
 
-    compressor_ptr->ctx = NULL;
+  if (zstds_ext_write_string_buffer(buffer, result, result_length)) {
+    compressor_ptr->stats.string_resizes++;
   }
 
-  zstds_ext_byte_t* destination_buffer = compressor_ptr->destination_buffer;
-  if (destination_buffer != NULL) {
-    free(destination_buffer);
+  if (result_length != 0) {
+    compressor_ptr->stats.flushes++;
+  }
+
+  compressor_ptr->remaining_destination_buffer        = destination_buffer;
+  compressor_ptr->remaining_destination_buffer_length = destination_buffer_length;
+
+  return buffer;
+}
 
-    compressor_ptr->destination_buffer = NULL;
+// Result will be kept when it can't be written.
+
+VALUE zstds_ext_compressor_read_result_to(VALUE self, VALUE io)
+{
+  GET_COMPRESSOR(self);
+  DO_NOT_USE_AFTER_CLOSE(compressor_ptr);
+
+  zstds_ext_byte_t* destination_buffer                  = compressor_ptr->destination_buffer;
+  size_t            destination_buffer_length           = compressor_ptr->destination_buffer_length;
+  size_t            remaining_destination_buffer_length = compressor_ptr->remaining_destination_buffer_length;
+
+  size_t result_length = destination_buffer_length - remaining_destination_buffer_length;
+
+  bool gvl   = zstds_ext_keep_gvl(compressor_ptr->gvl, ZSTDS_EXT_GVL_UNKNOWN_LENGTH);
+  int  state = 0;
+
+  zstds_ext_result_t ext_result = zstds_ext_write_io(io, destination_buffer, result_length, gvl, &state);
+  if (ext_result != 0) {
+    zstds_ext_raise_io_error(ext_result, state);
+  }
+
+  if (result_length != 0) {
+    compressor_ptr->stats.flushes++;
   }
 
+  compressor_ptr->remaining_destination_buffer        = destination_buffer;
+  compressor_ptr->remaining_destination_buffer_length = destination_buffer_length;
+
+  return SIZET2NUM(result_length);
+}
+
+// -- stats --
+
+// Stats are available after close.
+
+VALUE zstds_ext_compressor_get_stats(VALUE self)
+{
+  GET_COMPRESSOR(self);
+
+  return zstds_ext_get_stream_stats_hash(&compressor_ptr->stats);
+}
+
+// -- cleanup --
+
+VALUE zstds_ext_compressor_close(VALUE self)
+{
+  GET_COMPRESSOR(self);
+  DO_NOT_USE_AFTER_CLOSE(compressor_ptr);
+
+  free_context(compressor_ptr);
+
+  compressor_ptr->ctx                = NULL;
+  compressor_ptr->workspace          = NULL;
+  compressor_ptr->destination_buffer = NULL;
+
+  zstds_ext_report_memory(&compressor_ptr->memory);
+
   // It is possible to keep "destination_buffer_length", "remaining_destination_buffer"
   //   and "remaining_destination_buffer_length" as is.
 
@@ -281,8 +509,13 @@ void zstds_ext_compressor_exports(VALUE root_module)
   rb_define_alloc_func(compressor, zstds_ext_allocate_compressor);
   rb_define_method(compressor, "initialize", zstds_ext_initialize_compressor, 1);
   rb_define_method(compressor, "write", zstds_ext_compress, 1);
+  rb_define_method(compressor, "write_part", zstds_ext_compress_part, 3);
+  rb_define_method(compressor, "needs_more_destination?", zstds_ext_compressor_needs_more_destination, 0);
   rb_define_method(compressor, "flush", zstds_ext_flush_compressor, 0);
   rb_define_method(compressor, "finish", zstds_ext_finish_compressor, 0);
   rb_define_method(compressor, "read_result", zstds_ext_compressor_read_result, 0);
+  rb_define_method(compressor, "read_result_into", zstds_ext_compressor_read_result_into, 1);
+  rb_define_method(compressor, "read_result_to", zstds_ext_compressor_read_result_to, 1);
+  rb_define_method(compressor, "stats", zstds_ext_compressor_get_stats, 0);
   rb_define_method(compressor, "close", zstds_ext_compressor_close, 0);
 }
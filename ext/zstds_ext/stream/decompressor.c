@@ -3,14 +3,29 @@
 
 #include "zstds_ext/stream/decompressor.h"
 
+#include "zstds_ext/buffer.h"
 #include "zstds_ext/error.h"
 #include "zstds_ext/gvl.h"
+#include "zstds_ext/io.h"
 #include "zstds_ext/option.h"
 
 // -- initialization --
 
-static void free_decompressor(zstds_ext_decompressor_t* decompressor_ptr)
+static void mark_decompressor(zstds_ext_decompressor_t* decompressor_ptr)
+{
+  rb_gc_mark(decompressor_ptr->dictionary);
+}
+
+// Static context and destination buffer are placed inside workspace.
+
+static inline void free_context(zstds_ext_decompressor_t* decompressor_ptr)
 {
+  void* workspace = decompressor_ptr->workspace;
+  if (workspace != NULL) {
+    zstds_ext_free_memory(&decompressor_ptr->memory, workspace);
+    return;
+  }
+
   ZSTD_DCtx* ctx = decompressor_ptr->ctx;
   if (ctx != NULL) {
     ZSTD_freeDCtx(ctx);
@@ -18,65 +33,138 @@ static void free_decompressor(zstds_ext_decompressor_t* decompressor_ptr)
 
   zstds_ext_byte_t* destination_buffer = decompressor_ptr->destination_buffer;
   if (destination_buffer != NULL) {
-    free(destination_buffer);
+    zstds_ext_free_memory(&decompressor_ptr->memory, destination_buffer);
   }
+}
+
+static void free_decompressor(zstds_ext_decompressor_t* decompressor_ptr)
+{
+  free_context(decompressor_ptr);
+
+  // Ruby GC receives released size.
+  zstds_ext_report_memory(&decompressor_ptr->memory);
 
   free(decompressor_ptr);
 }
 
+static size_t get_decompressor_size(zstds_ext_decompressor_t* decompressor_ptr)
+{
+  size_t size = sizeof(zstds_ext_decompressor_t);
+
+  // Workspace is the only memory allocated for static context.
+  if (decompressor_ptr->workspace != NULL) {
+    return size + zstds_ext_get_memory_size(&decompressor_ptr->memory);
+  }
+
+  ZSTD_DCtx* ctx = decompressor_ptr->ctx;
+  if (ctx != NULL) {
+    size += ZSTD_sizeof_DCtx(ctx);
+  }
+
+  if (decompressor_ptr->destination_buffer != NULL) {
+    size += decompressor_ptr->destination_buffer_length;
+  }
+
+  return size;
+}
+
+static const rb_data_type_t decompressor_type = {
+  .wrap_struct_name = "ZSTDS::Stream::NativeDecompressor",
+  .function =
+    {.dmark = (RUBY_DATA_FUNC) mark_decompressor,
+     .dfree = (RUBY_DATA_FUNC) free_decompressor,
+     .dsize = (size_t(*)(const void*)) get_decompressor_size},
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY};
+
 VALUE zstds_ext_allocate_decompressor(VALUE klass)
 {
   zstds_ext_decompressor_t* decompressor_ptr;
-  VALUE self = Data_Make_Struct(klass, zstds_ext_decompressor_t, NULL, free_decompressor, decompressor_ptr);
+  VALUE                     self =
+    TypedData_Make_Struct(klass, zstds_ext_decompressor_t, &decompressor_type, decompressor_ptr);
 
   decompressor_ptr->ctx                                 = NULL;
+  decompressor_ptr->workspace                           = NULL;
   decompressor_ptr->destination_buffer                  = NULL;
   decompressor_ptr->destination_buffer_length           = 0;
   decompressor_ptr->remaining_destination_buffer        = NULL;
   decompressor_ptr->remaining_destination_buffer_length = 0;
+  decompressor_ptr->gvl                                 = ZSTDS_EXT_GVL_RELEASE;
+  decompressor_ptr->dictionary                          = Qnil;
+
+  zstds_ext_init_stream_stats(&decompressor_ptr->stats);
+  zstds_ext_init_memory(&decompressor_ptr->memory);
 
   return self;
 }
 
 #define GET_DECOMPRESSOR(self)                \
   zstds_ext_decompressor_t* decompressor_ptr; \
-  Data_Get_Struct(self, zstds_ext_decompressor_t, decompressor_ptr);
+  TypedData_Get_Struct(self, zstds_ext_decompressor_t, &decompressor_type, decompressor_ptr);
 
 VALUE zstds_ext_initialize_decompressor(VALUE self, VALUE options)
 {
   GET_DECOMPRESSOR(self);
   Check_Type(options, T_HASH);
   ZSTDS_EXT_GET_SIZE_OPTION(options, destination_buffer_length);
-  ZSTDS_EXT_GET_BOOL_OPTION(options, gvl);
+  ZSTDS_EXT_GET_BOOL_OPTION(options, static_workspace);
+  ZSTDS_EXT_GET_GVL_OPTION(options);
   ZSTDS_EXT_GET_DECOMPRESSOR_OPTIONS(options);
 
-  ZSTD_DCtx* ctx = ZSTD_createDCtx();
-  if (ctx == NULL) {
-    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  if (destination_buffer_length == 0) {
+    destination_buffer_length = ZSTD_DStreamOutSize();
   }
 
-  zstds_ext_result_t ext_result = zstds_ext_set_decompressor_options(ctx, &decompressor_options);
-  if (ext_result != 0) {
-    ZSTD_freeDCtx(ctx);
-    zstds_ext_raise_error(ext_result);
+  void*             workspace = NULL;
+  zstds_ext_byte_t* destination_buffer;
+  ZSTD_DCtx*        ctx;
+
+  if (static_workspace) {
+    size_t             ctx_size;
+    zstds_ext_result_t ext_result = zstds_ext_get_decompressor_workspace_size(&decompressor_options, &ctx_size);
+    if (ext_result != 0) {
+      zstds_ext_raise_error(ext_result);
+    }
+
+    ctx = zstds_ext_create_static_dctx(
+      &decompressor_ptr->memory, ctx_size, destination_buffer_length, &workspace, (void**) &destination_buffer);
+    if (ctx == NULL) {
+      zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    }
+  } else {
+    ctx = zstds_ext_create_memory_dctx(&decompressor_ptr->memory);
+    if (ctx == NULL) {
+      zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    }
+
+    destination_buffer = zstds_ext_allocate_memory(&decompressor_ptr->memory, destination_buffer_length);
+    if (destination_buffer == NULL) {
+      ZSTD_freeDCtx(ctx);
+      zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    }
   }
 
-  if (destination_buffer_length == 0) {
-    destination_buffer_length = ZSTD_DStreamOutSize();
-  }
+  zstds_ext_result_t ext_result = zstds_ext_set_decompressor_options(ctx, &decompressor_options);
+  if (ext_result != 0) {
+    if (workspace != NULL) {
+      zstds_ext_free_memory(&decompressor_ptr->memory, workspace);
+    } else {
+      ZSTD_freeDCtx(ctx);
+      zstds_ext_free_memory(&decompressor_ptr->memory, destination_buffer);
+    }
 
-  zstds_ext_byte_t* destination_buffer = malloc(destination_buffer_length);
-  if (destination_buffer == NULL) {
-    ZSTD_freeDCtx(ctx);
-    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    zstds_ext_raise_error(ext_result);
   }
 
   decompressor_ptr->ctx                                 = ctx;
+  decompressor_ptr->workspace                           = workspace;
   decompressor_ptr->destination_buffer                  = destination_buffer;
   decompressor_ptr->destination_buffer_length           = destination_buffer_length;
   decompressor_ptr->remaining_destination_buffer        = destination_buffer;
   decompressor_ptr->remaining_destination_buffer_length = destination_buffer_length;
-  decompressor_ptr->gvl                                 = gvl;
+  decompressor_ptr->gvl                                 = gvl_mode;
+  decompressor_ptr->dictionary                          = decompressor_options.dictionary;
+
+  zstds_ext_report_memory(&decompressor_ptr->memory);
 
   return Qnil;
 }
@@ -100,20 +188,18 @@ static inline void* decompress_wrapper(void* data)
 {
   decompress_args_t* args = data;
 
-  args->result = ZSTD_decompressStream(args->decompressor_ptr->ctx, args->out_buffer_ptr, args->in_buffer_ptr);
+  zstds_ext_decompressor_t* decompressor_ptr = args->decompressor_ptr;
+
+  ZSTDS_EXT_STREAM_STATS_MEASURE_ZSTD(
+    &decompressor_ptr->stats,
+    args->result = ZSTD_decompressStream(decompressor_ptr->ctx, args->out_buffer_ptr, args->in_buffer_ptr));
 
   return NULL;
 }
 
-VALUE zstds_ext_decompress(VALUE self, VALUE source_value)
+static inline size_t
+  decompress_source(zstds_ext_decompressor_t* decompressor_ptr, const char* source, size_t source_length)
 {
-  GET_DECOMPRESSOR(self);
-  DO_NOT_USE_AFTER_CLOSE(decompressor_ptr);
-  Check_Type(source_value, T_STRING);
-
-  const char* source        = RSTRING_PTR(source_value);
-  size_t      source_length = RSTRING_LEN(source_value);
-
   ZSTD_inBuffer  in_buffer  = {.src = source, .size = source_length, .pos = 0};
   ZSTD_outBuffer out_buffer = {
     .dst  = decompressor_ptr->remaining_destination_buffer,
@@ -123,7 +209,10 @@ VALUE zstds_ext_decompress(VALUE self, VALUE source_value)
   decompress_args_t args = {
     .decompressor_ptr = decompressor_ptr, .in_buffer_ptr = &in_buffer, .out_buffer_ptr = &out_buffer};
 
-  ZSTDS_EXT_GVL_WRAP(decompressor_ptr->gvl, decompress_wrapper, &args);
+  bool gvl = zstds_ext_keep_gvl(decompressor_ptr->gvl, source_length);
+
+  ZSTDS_EXT_STREAM_STATS_GVL_WRAP(&decompressor_ptr->stats, gvl, decompress_wrapper, &args);
+  zstds_ext_report_memory(&decompressor_ptr->memory);
   if (ZSTD_isError(args.result)) {
     zstds_ext_raise_error(zstds_ext_get_error(ZSTD_getErrorCode(args.result)));
   }
@@ -131,12 +220,57 @@ VALUE zstds_ext_decompress(VALUE self, VALUE source_value)
   decompressor_ptr->remaining_destination_buffer += out_buffer.pos;
   decompressor_ptr->remaining_destination_buffer_length -= out_buffer.pos;
 
-  VALUE bytes_read             = SIZET2NUM(in_buffer.pos);
+  decompressor_ptr->stats.bytes_in += in_buffer.pos;
+  decompressor_ptr->stats.bytes_out += out_buffer.pos;
+
+  // Zero result means that frame was completely decoded and flushed.
+  if (args.result == 0) {
+    decompressor_ptr->stats.frames++;
+  }
+
+  return in_buffer.pos;
+}
+
+VALUE zstds_ext_decompress(VALUE self, VALUE source_value)
+{
+  GET_DECOMPRESSOR(self);
+  DO_NOT_USE_AFTER_CLOSE(decompressor_ptr);
+  Check_Type(source_value, T_STRING);
+
+  const char* source        = RSTRING_PTR(source_value);
+  size_t      source_length = RSTRING_LEN(source_value);
+
+  VALUE bytes_read             = SIZET2NUM(decompress_source(decompressor_ptr, source, source_length));
   VALUE needs_more_destination = decompressor_ptr->remaining_destination_buffer_length == 0 ? Qtrue : Qfalse;
 
   return rb_ary_new_from_args(2, bytes_read, needs_more_destination);
 }
 
+// Part of source can be processed without slicing and result array allocation.
+
+VALUE zstds_ext_decompress_part(VALUE self, VALUE source_value, VALUE offset_value, VALUE length_value)
+{
+  GET_DECOMPRESSOR(self);
+  DO_NOT_USE_AFTER_CLOSE(decompressor_ptr);
+
+  size_t      source_length;
+  const char* source = zstds_ext_get_string_part(source_value, offset_value, length_value, &source_length);
+
+  size_t bytes_read = decompress_source(decompressor_ptr, source, source_length);
+
+  RB_GC_GUARD(source_value);
+
+  return SIZET2NUM(bytes_read);
+}
+
+VALUE zstds_ext_decompressor_needs_more_destination(VALUE self)
+{
+  GET_DECOMPRESSOR(self);
+  DO_NOT_USE_AFTER_CLOSE(decompressor_ptr);
+
+  return decompressor_ptr->remaining_destination_buffer_length == 0 ? Qtrue : Qfalse;
+}
+
 // -- other --
 
 VALUE zstds_ext_decompressor_read_result(VALUE self)
@@ -152,33 +286,102 @@ VALUE zstds_ext_decompressor_read_result(VALUE self)
   size_t      result_length = destination_buffer_length - remaining_destination_buffer_length;
   VALUE       result_value  = rb_str_new(result, result_length);
 
+  if (result_length != 0) {
+    decompressor_ptr->stats.flushes++;
+  }
+
   decompressor_ptr->remaining_destination_buffer        = destination_buffer;
   decompressor_ptr->remaining_destination_buffer_length = destination_buffer_length;
 
   return result_value;
 }
 
-// -- cleanup --
+// Result can be drained without allocation of new string.
 
-VALUE zstds_ext_decompressor_close(VALUE self)
+VALUE zstds_ext_decompressor_read_result_into(VALUE self, VALUE buffer)
 {
   GET_DECOMPRESSOR(self);
   DO_NOT_USE_AFTER_CLOSE(decompressor_ptr);
+  Check_Type(buffer, T_STRING);
 
-  ZSTD_DCtx* ctx = decompressor_ptr->ctx;
-  if (ctx != NULL) {
-    ZSTD_freeDCtx(ctx);
+  zstds_ext_byte_t* destination_buffer                  = decompressor_ptr->destination_buffer;
+  size_t            destination_buffer_length           = decompressor_ptr->destination_buffer_length;
+  size_t            remaining_destination_buffer_length = decompressor_ptr->remaining_destination_buffer_length;
 
-    decompressor_ptr->ctx = NULL;
+  const char* result        = (const char*) destination_buffer;
+  size_t      result_length = destination_buffer_length - remaining_destination_buffer_length;
+
+  if (zstds_ext_write_string_buffer(buffer, result, result_length)) {
+    decompressor_ptr->stats.string_resizes++;
   }
 
-  zstds_ext_byte_t* destination_buffer = decompressor_ptr->destination_buffer;
-  if (destination_buffer != NULL) {
-    free(destination_buffer);
+  if (result_length != 0) {
+    decompressor_ptr->stats.flushes++;
+  }
+
+  decompressor_ptr->remaining_destination_buffer        = destination_buffer;
+  decompressor_ptr->remaining_destination_buffer_length = destination_buffer_length;
+
+  return buffer;
+}
+
+// Result will be kept when it can't be written.
+
+VALUE zstds_ext_decompressor_read_result_to(VALUE self, VALUE io)
+{
+  GET_DECOMPRESSOR(self);
+  DO_NOT_USE_AFTER_CLOSE(decompressor_ptr);
+
+  zstds_ext_byte_t* destination_buffer                  = decompressor_ptr->destination_buffer;
+  size_t            destination_buffer_length           = decompressor_ptr->destination_buffer_length;
+  size_t            remaining_destination_buffer_length = decompressor_ptr->remaining_destination_buffer_length;
+
+  size_t result_length = destination_buffer_length - remaining_destination_buffer_length;
+
+  bool gvl   = zstds_ext_keep_gvl(decompressor_ptr->gvl, ZSTDS_EXT_GVL_UNKNOWN_LENGTH);
+  int  state = 0;
 
-    decompressor_ptr->destination_buffer = NULL;
+  zstds_ext_result_t ext_result = zstds_ext_write_io(io, destination_buffer, result_length, gvl, &state);
+  if (ext_result != 0) {
+    zstds_ext_raise_io_error(ext_result, state);
+  }
+
+  if (result_length != 0) {
+    decompressor_ptr->stats.flushes++;
   }
 
+  decompressor_ptr->remaining_destination_buffer        = destination_buffer;
+  decompressor_ptr->remaining_destination_buffer_length = destination_buffer_length;
+
+  return SIZET2NUM(result_length);
+}
+
+// -- stats --
+
+// Stats are available after close.
+
+VALUE zstds_ext_decompressor_get_stats(VALUE self)
+{
+  GET_DECOMPRESSOR(self);
+
+  return zstds_ext_get_stream_stats_hash(&decompressor_ptr->stats);
+}
+
+// -- cleanup --
+
+VALUE zstds_ext_decompressor_close(VALUE self)
+{
+  GET_DECOMPRESSOR(self);
+  DO_NOT_USE_AFTER_CLOSE(decompressor_ptr);
+
+  free_context(decompressor_ptr);
+
+  decompressor_ptr->ctx                = NULL;
+  decompressor_ptr->workspace          = NULL;
+  decompressor_ptr->destination_buffer = NULL;
+
+  zstds_ext_report_memory(&decompressor_ptr->memory);
+
   // It is possible to keep "destination_buffer_length", "remaining_destination_buffer"
   //   and "remaining_destination_buffer_length" as is.
 
@@ -196,6 +399,11 @@ void zstds_ext_decompressor_exports(VALUE root_module)
   rb_define_alloc_func(decompressor, zstds_ext_allocate_decompressor);
   rb_define_method(decompressor, "initialize", zstds_ext_initialize_decompressor, 1);
   rb_define_method(decompressor, "read", zstds_ext_decompress, 1);
+  rb_define_method(decompressor, "read_part", zstds_ext_decompress_part, 3);
+  rb_define_method(decompressor, "needs_more_destination?", zstds_ext_decompressor_needs_more_destination, 0);
   rb_define_method(decompressor, "read_result", zstds_ext_decompressor_read_result, 0);
+  rb_define_method(decompressor, "read_result_into", zstds_ext_decompressor_read_result_into, 1);
+  rb_define_method(decompressor, "read_result_to", zstds_ext_decompressor_read_result_to, 1);
+  rb_define_method(decompressor, "stats", zstds_ext_decompressor_get_stats, 0);
   rb_define_method(decompressor, "close", zstds_ext_decompressor_close, 0);
 }
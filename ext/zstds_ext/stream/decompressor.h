@@ -9,21 +9,33 @@
 
 #include "ruby.h"
 #include "zstds_ext/common.h"
+#include "zstds_ext/gvl.h"
+#include "zstds_ext/memory.h"
+#include "zstds_ext/stream/stats.h"
 
 typedef struct
 {
-  ZSTD_DCtx*        ctx;
-  zstds_ext_byte_t* destination_buffer;
-  size_t            destination_buffer_length;
-  zstds_ext_byte_t* remaining_destination_buffer;
-  size_t            remaining_destination_buffer_length;
-  bool              gvl;
+  ZSTD_DCtx*               ctx;
+  void*                    workspace;
+  zstds_ext_byte_t*        destination_buffer;
+  size_t                   destination_buffer_length;
+  zstds_ext_byte_t*        remaining_destination_buffer;
+  size_t                   remaining_destination_buffer_length;
+  zstds_ext_gvl_t          gvl;
+  zstds_ext_stream_stats_t stats;
+  zstds_ext_memory_t       memory;
+  VALUE                    dictionary;
 } zstds_ext_decompressor_t;
 
 VALUE zstds_ext_allocate_decompressor(VALUE klass);
 VALUE zstds_ext_initialize_decompressor(VALUE self, VALUE options);
 VALUE zstds_ext_decompress(VALUE self, VALUE source);
+VALUE zstds_ext_decompress_part(VALUE self, VALUE source, VALUE offset, VALUE length);
+VALUE zstds_ext_decompressor_needs_more_destination(VALUE self);
 VALUE zstds_ext_decompressor_read_result(VALUE self);
+VALUE zstds_ext_decompressor_read_result_into(VALUE self, VALUE buffer);
+VALUE zstds_ext_decompressor_read_result_to(VALUE self, VALUE io);
+VALUE zstds_ext_decompressor_get_stats(VALUE self);
 VALUE zstds_ext_decompressor_close(VALUE self);
 
 void zstds_ext_decompressor_exports(VALUE root_module);
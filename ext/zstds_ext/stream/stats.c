@@ -0,0 +1,53 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#include "zstds_ext/stream/stats.h"
+
+#include <time.h>
+
+#define NANOSECONDS_PER_SECOND 1000000000
+
+void zstds_ext_init_stream_stats(zstds_ext_stream_stats_t* stats_ptr)
+{
+  stats_ptr->bytes_in          = 0;
+  stats_ptr->bytes_out         = 0;
+  stats_ptr->native_calls      = 0;
+  stats_ptr->zstd_time         = 0;
+  stats_ptr->gvl_released_time = 0;
+  stats_ptr->flushes           = 0;
+  stats_ptr->string_resizes    = 0;
+  stats_ptr->frames            = 0;
+}
+
+// Monotonic clock is cheap (vdso), so stats can be always enabled.
+
+uint64_t zstds_ext_get_stream_stats_time(void)
+{
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+
+  return (uint64_t) time.tv_sec * NANOSECONDS_PER_SECOND + (uint64_t) time.tv_nsec;
+}
+
+static inline VALUE get_seconds(uint64_t time)
+{
+  return DBL2NUM((double) time / NANOSECONDS_PER_SECOND);
+}
+
+#define SET_STATS_VALUE(hash, name, value) rb_hash_aset(hash, ID2SYM(rb_intern(name)), value);
+
+VALUE zstds_ext_get_stream_stats_hash(const zstds_ext_stream_stats_t* stats_ptr)
+{
+  VALUE hash = rb_hash_new();
+
+  SET_STATS_VALUE(hash, "bytes_in", SIZET2NUM(stats_ptr->bytes_in));
+  SET_STATS_VALUE(hash, "bytes_out", SIZET2NUM(stats_ptr->bytes_out));
+  SET_STATS_VALUE(hash, "native_calls", SIZET2NUM(stats_ptr->native_calls));
+  SET_STATS_VALUE(hash, "zstd_time", get_seconds(stats_ptr->zstd_time));
+  SET_STATS_VALUE(hash, "gvl_released_time", get_seconds(stats_ptr->gvl_released_time));
+  SET_STATS_VALUE(hash, "flushes", SIZET2NUM(stats_ptr->flushes));
+  SET_STATS_VALUE(hash, "string_resizes", SIZET2NUM(stats_ptr->string_resizes));
+  SET_STATS_VALUE(hash, "frames", SIZET2NUM(stats_ptr->frames));
+
+  return hash;
+}
@@ -0,0 +1,60 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#if !defined(ZSTDS_EXT_STREAM_STATS_H)
+#define ZSTDS_EXT_STREAM_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ruby.h"
+#include "zstds_ext/gvl.h"
+
+// Counters are monotonic, they are kept after stream close.
+// Times are stored in nanoseconds.
+
+typedef struct
+{
+  size_t   bytes_in;
+  size_t   bytes_out;
+  size_t   native_calls;
+  uint64_t zstd_time;
+  uint64_t gvl_released_time;
+  size_t   flushes;
+  size_t   string_resizes;
+  size_t   frames;
+} zstds_ext_stream_stats_t;
+
+void     zstds_ext_init_stream_stats(zstds_ext_stream_stats_t* stats_ptr);
+uint64_t zstds_ext_get_stream_stats_time(void);
+VALUE    zstds_ext_get_stream_stats_hash(const zstds_ext_stream_stats_t* stats_ptr);
+
+// Statement with zstd call is measured, it can be used without GVL.
+#define ZSTDS_EXT_STREAM_STATS_MEASURE_ZSTD(stats_ptr, statement)                  \
+  {                                                                                \
+    uint64_t zstd_start_time = zstds_ext_get_stream_stats_time();                  \
+    statement;                                                                     \
+    (stats_ptr)->zstd_time += zstds_ext_get_stream_stats_time() - zstd_start_time; \
+    (stats_ptr)->native_calls++;                                                   \
+  }
+
+#if defined(HAVE_RB_THREAD_CALL_WITHOUT_GVL)
+
+// Time with released GVL includes waiting for GVL reacquisition.
+#define ZSTDS_EXT_STREAM_STATS_GVL_WRAP(stats_ptr, gvl, function, data)                   \
+  if (gvl) {                                                                              \
+    function((void*) data);                                                               \
+  } else {                                                                                \
+    uint64_t gvl_start_time = zstds_ext_get_stream_stats_time();                          \
+    ZSTDS_EXT_CALL_WITHOUT_GVL(function, data);                                           \
+    (stats_ptr)->gvl_released_time += zstds_ext_get_stream_stats_time() - gvl_start_time; \
+  }
+
+#else
+
+#define ZSTDS_EXT_STREAM_STATS_GVL_WRAP(_stats_ptr, gvl, function, data) ZSTDS_EXT_GVL_WRAP(gvl, function, data)
+
+#endif // HAVE_RB_THREAD_CALL_WITHOUT_GVL
+
+#endif // ZSTDS_EXT_STREAM_STATS_H
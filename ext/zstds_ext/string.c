@@ -3,73 +3,197 @@
 
 #include "zstds_ext/string.h"
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <zstd.h>
 
+#include "zstds_ext/batch.h"
 #include "zstds_ext/buffer.h"
+#include "zstds_ext/context_pool.h"
 #include "zstds_ext/error.h"
+#include "zstds_ext/frame.h"
 #include "zstds_ext/gvl.h"
 #include "zstds_ext/macro.h"
 #include "zstds_ext/option.h"
 
 // -- buffer --
 
+// Destination buffer grows by fixed step (initial buffer length), by current destination length (geometric)
+//   or by remaining destination length predicted using ratio of processed source (ratio).
+// Growth can't be less than initial buffer length and more than max growth.
+
+#define DEFAULT_MAX_DESTINATION_BUFFER_GROWTH (1 << 26)
+
+typedef struct
+{
+  zstds_ext_buffer_growth_t growth;
+  size_t                    buffer_length;
+  size_t                    max_buffer_growth;
+  bool                      shrink_buffer;
+} destination_options_t;
+
+#define GET_DESTINATION_OPTIONS(options, destination_options, default_buffer_length)     \
+  ZSTDS_EXT_GET_SIZE_OPTION(options, destination_buffer_length);                         \
+  ZSTDS_EXT_GET_BUFFER_GROWTH_OPTION(options, destination_buffer_growth);                \
+  ZSTDS_EXT_GET_SIZE_OPTION(options, max_destination_buffer_growth);                     \
+  ZSTDS_EXT_GET_BOOL_OPTION(options, shrink_destination_buffer);                         \
+                                                                                         \
+  if (destination_buffer_length == 0) {                                                  \
+    destination_buffer_length = default_buffer_length;                                   \
+  }                                                                                      \
+  if (max_destination_buffer_growth == 0) {                                              \
+    max_destination_buffer_growth = DEFAULT_MAX_DESTINATION_BUFFER_GROWTH;               \
+  }                                                                                      \
+  if (max_destination_buffer_growth < destination_buffer_length) {                       \
+    max_destination_buffer_growth = destination_buffer_length;                           \
+  }                                                                                      \
+                                                                                         \
+  destination_options_t destination_options = {                                          \
+    .growth            = destination_buffer_growth,                                      \
+    .buffer_length     = destination_buffer_length,                                      \
+    .max_buffer_growth = max_destination_buffer_growth,                                  \
+    .shrink_buffer     = shrink_destination_buffer};
+
+static inline size_t get_destination_buffer_growth(
+  const destination_options_t* options_ptr,
+  size_t                       source_length,
+  size_t                       processed_source_length,
+  size_t                       destination_length)
+{
+  double growth;
+
+  switch (options_ptr->growth) {
+    case ZSTDS_EXT_BUFFER_GROWTH_FIXED:
+      return options_ptr->buffer_length;
+    case ZSTDS_EXT_BUFFER_GROWTH_RATIO:
+      if (processed_source_length != 0 && processed_source_length < source_length) {
+        growth = (double) (source_length - processed_source_length) * destination_length / processed_source_length;
+        break;
+      }
+
+      // Ratio is not known yet or source is processed already.
+      growth = destination_length;
+      break;
+    default:
+      growth = destination_length;
+  }
+
+  if (growth < options_ptr->buffer_length) {
+    return options_ptr->buffer_length;
+  }
+
+  if (growth > options_ptr->max_buffer_growth) {
+    return options_ptr->max_buffer_growth;
+  }
+
+  return (size_t) growth;
+}
+
 static inline zstds_ext_result_t increase_destination_buffer(
   VALUE   destination_value,
   size_t  destination_length,
   size_t* remaining_destination_buffer_length_ptr,
-  size_t  destination_buffer_length)
+  size_t* destination_buffer_length_ptr,
+  size_t  destination_buffer_growth)
 {
-  if (*remaining_destination_buffer_length_ptr == destination_buffer_length) {
+  if (*remaining_destination_buffer_length_ptr == *destination_buffer_length_ptr) {
     // We want to write more data at once, than buffer has.
     return ZSTDS_EXT_ERROR_NOT_ENOUGH_DESTINATION_BUFFER;
   }
 
   int exception;
 
-  ZSTDS_EXT_RESIZE_STRING_BUFFER(destination_value, destination_length + destination_buffer_length, exception);
+  ZSTDS_EXT_RESIZE_STRING_BUFFER(destination_value, destination_length + destination_buffer_growth, exception);
   if (exception != 0) {
     return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
   }
 
-  *remaining_destination_buffer_length_ptr = destination_buffer_length;
+  *remaining_destination_buffer_length_ptr = destination_buffer_growth;
+  *destination_buffer_length_ptr           = destination_buffer_growth;
+
+  return 0;
+}
+
+// Shrinking requires reallocation and copying in most cases.
+// Without shrinking string will keep unused capacity.
+
+static inline zstds_ext_result_t finish_destination_buffer(
+  VALUE                        destination_value,
+  size_t                       destination_length,
+  const destination_options_t* options_ptr)
+{
+  if (!options_ptr->shrink_buffer) {
+    rb_str_set_len(destination_value, destination_length);
+    return 0;
+  }
+
+  int exception;
+
+  ZSTDS_EXT_RESIZE_STRING_BUFFER(destination_value, destination_length, exception);
+  if (exception != 0) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
 
   return 0;
 }
 
 // -- compress --
 
+// Source can be provided by slices, interrupts will be checked between slices.
+// Protect state of raised exception will be stored, caller should release its resources and use "rb_jump_tag".
+
 typedef struct
 {
-  ZSTD_CCtx*      ctx;
-  ZSTD_inBuffer*  in_buffer_ptr;
-  ZSTD_outBuffer* out_buffer_ptr;
-  zstds_result_t  result;
+  size_t size;
+  bool   yield;
+  int    state;
+} slice_options_t;
+
+typedef struct
+{
+  ZSTD_CCtx*        ctx;
+  ZSTD_inBuffer*    in_buffer_ptr;
+  ZSTD_outBuffer*   out_buffer_ptr;
+  ZSTD_EndDirective end_directive;
+  zstds_result_t    result;
 } compress_args_t;
 
 static inline void* compress_wrapper(void* data)
 {
   compress_args_t* args = data;
 
-  args->result = ZSTD_compressStream2(args->ctx, args->out_buffer_ptr, args->in_buffer_ptr, ZSTD_e_end);
+  args->result = ZSTD_compressStream2(args->ctx, args->out_buffer_ptr, args->in_buffer_ptr, args->end_directive);
 
   return NULL;
 }
 
 static inline zstds_ext_result_t compress(
-  ZSTD_CCtx*  ctx,
-  const char* source,
-  size_t      source_length,
-  VALUE       destination_value,
-  size_t      destination_buffer_length,
-  bool        gvl)
+  ZSTD_CCtx*                   ctx,
+  const char*                  source,
+  size_t                       source_length,
+  VALUE                        destination_value,
+  const destination_options_t* destination_options_ptr,
+  slice_options_t*             slice_options_ptr,
+  bool                         gvl)
 {
   zstds_ext_result_t ext_result;
   size_t             destination_length                  = 0;
+  size_t             destination_buffer_length           = destination_options_ptr->buffer_length;
   size_t             remaining_destination_buffer_length = destination_buffer_length;
+  size_t             slice_size                          = slice_options_ptr->size;
   ZSTD_inBuffer      in_buffer                           = {.src = source, .size = source_length, .pos = 0};
   compress_args_t    args                                = {.ctx = ctx, .in_buffer_ptr = &in_buffer};
 
   while (true) {
+    if (slice_size != 0 && source_length - in_buffer.pos > slice_size) {
+      in_buffer.size     = in_buffer.pos + slice_size;
+      args.end_directive = ZSTD_e_continue;
+    } else {
+      in_buffer.size     = source_length;
+      args.end_directive = ZSTD_e_end;
+    }
+
     ZSTD_outBuffer out_buffer = {
       .dst  = (zstds_ext_byte_t*) RSTRING_PTR(destination_value) + destination_length,
       .size = remaining_destination_buffer_length,
@@ -85,9 +209,29 @@ static inline zstds_ext_result_t compress(
     destination_length += out_buffer.pos;
     remaining_destination_buffer_length -= out_buffer.pos;
 
-    if (args.result != 0) {
+    bool is_finished = args.end_directive == ZSTD_e_end && args.result == 0;
+
+    if (slice_size != 0 && !is_finished) {
+      slice_options_ptr->state = zstds_ext_check_interrupts(slice_options_ptr->yield && gvl);
+      if (slice_options_ptr->state != 0) {
+        return 0;
+      }
+    }
+
+    if (args.end_directive == ZSTD_e_continue && remaining_destination_buffer_length != 0) {
+      continue;
+    }
+
+    if (!is_finished) {
+      size_t destination_buffer_growth =
+        get_destination_buffer_growth(destination_options_ptr, source_length, in_buffer.pos, destination_length);
+
       ext_result = increase_destination_buffer(
-        destination_value, destination_length, &remaining_destination_buffer_length, destination_buffer_length);
+        destination_value,
+        destination_length,
+        &remaining_destination_buffer_length,
+        &destination_buffer_length,
+        destination_buffer_growth);
 
       if (ext_result != 0) {
         return ext_result;
@@ -99,53 +243,266 @@ static inline zstds_ext_result_t compress(
     break;
   }
 
+  return finish_destination_buffer(destination_value, destination_length, destination_options_ptr);
+}
+
+// -- compress small --
+
+// Small source can be compressed using single call into destination with max compressed length.
+
+typedef struct
+{
+  ZSTD_CCtx*     ctx;
+  const char*    source;
+  size_t         source_length;
+  char*          destination;
+  size_t         destination_length;
+  zstds_result_t result;
+} compress_small_args_t;
+
+static inline void* compress_small_wrapper(void* data)
+{
+  compress_small_args_t* args = data;
+
+  args->result =
+    ZSTD_compress2(args->ctx, args->destination, args->destination_length, args->source, args->source_length);
+
+  return NULL;
+}
+
+static inline zstds_ext_result_t compress_small(
+  ZSTD_CCtx*                   ctx,
+  const char*                  source,
+  size_t                       source_length,
+  VALUE                        destination_value,
+  size_t                       destination_length,
+  const destination_options_t* destination_options_ptr,
+  bool                         gvl)
+{
+  compress_small_args_t args = {
+    .ctx                = ctx,
+    .source             = source,
+    .source_length      = source_length,
+    .destination        = RSTRING_PTR(destination_value),
+    .destination_length = destination_length};
+
+  ZSTDS_EXT_GVL_WRAP(gvl, compress_small_wrapper, &args);
+  if (ZSTD_isError(args.result)) {
+    return zstds_ext_get_error(ZSTD_getErrorCode(args.result));
+  }
+
+  return finish_destination_buffer(destination_value, args.result, destination_options_ptr);
+}
+
+// -- compress parallel --
+
+// Parallel compressor splits source into independent frames with content size.
+// Each frame is compressed by separate worker into its part of destination with max compressed length.
+// Compressed frames are moved together later.
+
+static inline zstds_ext_result_t compress_parallel(
+  const char*                     source,
+  size_t                          source_length,
+  VALUE*                          destination_value_ptr,
+  size_t                          workers,
+  size_t                          frame_length,
+  zstds_ext_compressor_options_t* compressor_options_ptr,
+  const destination_options_t*    destination_options_ptr,
+  bool                            gvl)
+{
+  // Empty source will be compressed into single empty frame.
+  size_t items_length = source_length == 0 ? 1 : (source_length - 1) / frame_length + 1;
+
+  zstds_ext_batch_item_t* items = malloc(items_length * sizeof(zstds_ext_batch_item_t));
+  if (items == NULL) {
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
+  }
+
+  size_t destination_length = 0;
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item                    = &items[index];
+    size_t                  source_offset           = index * frame_length;
+    size_t                  remaining_source_length = source_length - source_offset;
+
+    item->source             = source + source_offset;
+    item->source_length      = remaining_source_length < frame_length ? remaining_source_length : frame_length;
+    item->destination_length = ZSTD_compressBound(item->source_length);
+    item->ext_result         = 0;
+
+    destination_length += item->destination_length;
+  }
+
+  size_t     workers_length = zstds_ext_get_batch_workers_length(workers, items_length);
+  ZSTD_CCtx* ctxs[ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH];
+
+  zstds_ext_result_t ext_result = zstds_ext_acquire_compressor_contexts(ctxs, workers_length, compressor_options_ptr);
+  if (ext_result != 0) {
+    free(items);
+    return ext_result;
+  }
+
   int exception;
 
-  ZSTDS_EXT_RESIZE_STRING_BUFFER(destination_value, destination_length, exception);
+  ZSTDS_EXT_CREATE_STRING_BUFFER(destination_value, destination_length, exception);
   if (exception != 0) {
+    zstds_ext_release_compressor_contexts(ctxs, workers_length);
+    free(items);
     return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
   }
 
-  return 0;
+  char* destination = RSTRING_PTR(destination_value);
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item = &items[index];
+
+    item->destination = destination;
+    destination += item->destination_length;
+  }
+
+  zstds_ext_batch_args_t args = {
+    .ctxs = (void**) ctxs, .workers_length = workers_length, .items = items, .items_length = items_length};
+
+  ZSTDS_EXT_GVL_WRAP(gvl, zstds_ext_compress_batch_wrapper, &args);
+
+  zstds_ext_release_compressor_contexts(ctxs, workers_length);
+
+  destination        = RSTRING_PTR(destination_value);
+  destination_length = 0;
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item = &items[index];
+    if (item->ext_result != 0) {
+      ext_result = item->ext_result;
+      free(items);
+      return ext_result;
+    }
+
+    memmove(destination + destination_length, item->destination, item->destination_length);
+    destination_length += item->destination_length;
+  }
+
+  free(items);
+
+  *destination_value_ptr = destination_value;
+
+  return finish_destination_buffer(destination_value, destination_length, destination_options_ptr);
 }
 
 VALUE zstds_ext_compress_string(VALUE ZSTDS_EXT_UNUSED(self), VALUE source_value, VALUE options)
 {
   Check_Type(source_value, T_STRING);
   Check_Type(options, T_HASH);
-  ZSTDS_EXT_GET_SIZE_OPTION(options, destination_buffer_length);
-  ZSTDS_EXT_GET_BOOL_OPTION(options, gvl);
+  GET_DESTINATION_OPTIONS(options, destination_options, ZSTD_CStreamOutSize());
+  ZSTDS_EXT_GET_GVL_OPTION(options);
+  ZSTDS_EXT_GET_GVL_THRESHOLD_OPTION(options);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, slice_size);
+  ZSTDS_EXT_GET_BOOL_OPTION(options, slice_yield);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, parallel);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, parallel_frame_size);
+  ZSTDS_EXT_GET_STRING_OPTION(options, reference);
   ZSTDS_EXT_GET_COMPRESSOR_OPTIONS(options);
 
-  ZSTD_CCtx* ctx = ZSTD_createCCtx();
+  // Reference is a prefix for single frame, parallel frames can't use it.
+  if (reference != Qnil && parallel != 0) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  // Source is split into frames with parallel frame size.
+  if (parallel != 0 && parallel_frame_size == 0) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  const char* source        = RSTRING_PTR(source_value);
+  size_t      source_length = RSTRING_LEN(source_value);
+
+  bool gvl = zstds_ext_keep_gvl_with_threshold(gvl_mode, source_length, gvl_threshold);
+
+  zstds_ext_result_t ext_result;
+
+  if (parallel != 0) {
+    VALUE destination_value;
+
+    ext_result = compress_parallel(
+      source,
+      source_length,
+      &destination_value,
+      parallel,
+      parallel_frame_size,
+      &compressor_options,
+      &destination_options,
+      gvl);
+
+    if (ext_result != 0) {
+      zstds_ext_raise_error(ext_result);
+    }
+
+    return destination_value;
+  }
+
+  ZSTD_CCtx* ctx = zstds_ext_acquire_compressor_context();
   if (ctx == NULL) {
     zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
   }
 
-  zstds_ext_result_t ext_result = zstds_ext_set_compressor_options(ctx, &compressor_options);
-  if (ext_result != 0) {
-    ZSTD_freeCCtx(ctx);
-    zstds_ext_raise_error(ext_result);
+  ext_result = zstds_ext_set_compressor_options(ctx, &compressor_options);
+
+  // Sliced compression doesn't provide whole source at once, frame won't receive content size without pledged size.
+  if (ext_result == 0 && !compressor_options.pledged_size.has_value) {
+    zstds_result_t result = ZSTD_CCtx_setPledgedSrcSize(ctx, source_length);
+    if (ZSTD_isError(result)) {
+      ext_result = zstds_ext_get_error(ZSTD_getErrorCode(result));
+    }
+  }
+
+  if (ext_result == 0 && reference != Qnil) {
+    ext_result =
+      zstds_ext_set_compressor_reference(ctx, &compressor_options, RSTRING_PTR(reference), RSTRING_LEN(reference));
   }
 
-  if (destination_buffer_length == 0) {
-    destination_buffer_length = ZSTD_CStreamOutSize();
+  if (ext_result != 0) {
+    zstds_ext_release_compressor_context(ctx);
+    zstds_ext_raise_error(ext_result);
   }
 
   int exception;
 
-  ZSTDS_EXT_CREATE_STRING_BUFFER(destination_value, destination_buffer_length, exception);
+  if (source_length <= ZSTD_CStreamInSize() && (slice_size == 0 || source_length <= slice_size)) {
+    size_t destination_length = ZSTD_compressBound(source_length);
+
+    ZSTDS_EXT_CREATE_STRING_BUFFER(destination_value, destination_length, exception);
+    if (exception != 0) {
+      zstds_ext_release_compressor_context(ctx);
+      zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    }
+
+    ext_result = compress_small(
+      ctx, source, source_length, destination_value, destination_length, &destination_options, gvl);
+
+    zstds_ext_release_compressor_context(ctx);
+
+    if (ext_result != 0) {
+      zstds_ext_raise_error(ext_result);
+    }
+
+    return destination_value;
+  }
+
+  ZSTDS_EXT_CREATE_STRING_BUFFER(destination_value, destination_options.buffer_length, exception);
   if (exception != 0) {
-    ZSTD_freeCCtx(ctx);
+    zstds_ext_release_compressor_context(ctx);
     zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
   }
 
-  const char* source        = RSTRING_PTR(source_value);
-  size_t      source_length = RSTRING_LEN(source_value);
+  slice_options_t slice_options = {.size = slice_size, .yield = slice_yield, .state = 0};
+
+  ext_result = compress(ctx, source, source_length, destination_value, &destination_options, &slice_options, gvl);
 
-  ext_result = compress(ctx, source, source_length, destination_value, destination_buffer_length, gvl);
+  zstds_ext_release_compressor_context(ctx);
 
-  ZSTD_freeCCtx(ctx);
+  if (slice_options.state != 0) {
+    rb_jump_tag(slice_options.state);
+  }
 
   if (ext_result != 0) {
     zstds_ext_raise_error(ext_result);
@@ -174,21 +531,23 @@ static inline void* decompress_wrapper(void* data)
 }
 
 static inline zstds_ext_result_t decompress(
-  ZSTD_DCtx*  ctx,
-  const char* source,
-  size_t      source_length,
-  VALUE       destination_value,
-  size_t      destination_buffer_length,
-  bool        gvl)
+  ZSTD_DCtx*                   ctx,
+  const char*                  source,
+  size_t                       source_length,
+  VALUE                        destination_value,
+  const destination_options_t* destination_options_ptr,
+  bool                         gvl)
 {
   zstds_ext_result_t ext_result;
   size_t             destination_length                  = 0;
+  size_t             destination_buffer_length           = destination_options_ptr->buffer_length;
   size_t             remaining_destination_buffer_length = destination_buffer_length;
   ZSTD_inBuffer      in_buffer                           = {.src = source, .size = source_length, .pos = 0};
   decompress_args_t  args                                = {.ctx = ctx, .in_buffer_ptr = &in_buffer};
 
   while (true) {
-    ZSTD_outBuffer out_buffer = {
+    size_t         in_buffer_pos = in_buffer.pos;
+    ZSTD_outBuffer out_buffer    = {
       .dst  = (zstds_ext_byte_t*) RSTRING_PTR(destination_value) + destination_length,
       .size = remaining_destination_buffer_length,
       .pos  = 0};
@@ -204,8 +563,15 @@ static inline zstds_ext_result_t decompress(
     remaining_destination_buffer_length -= out_buffer.pos;
 
     if (remaining_destination_buffer_length == 0) {
+      size_t destination_buffer_growth =
+        get_destination_buffer_growth(destination_options_ptr, source_length, in_buffer.pos, destination_length);
+
       ext_result = increase_destination_buffer(
-        destination_value, destination_length, &remaining_destination_buffer_length, destination_buffer_length);
+        destination_value,
+        destination_length,
+        &remaining_destination_buffer_length,
+        &destination_buffer_length,
+        destination_buffer_growth);
 
       if (ext_result != 0) {
         return ext_result;
@@ -214,14 +580,142 @@ static inline zstds_ext_result_t decompress(
       continue;
     }
 
+    // Decompressor stops after each frame, source may contain more frames.
+    if (in_buffer.pos != in_buffer.size && in_buffer.pos != in_buffer_pos) {
+      continue;
+    }
+
     break;
   }
 
-  int exception;
+  return finish_destination_buffer(destination_value, destination_length, destination_options_ptr);
+}
 
-  ZSTDS_EXT_RESIZE_STRING_BUFFER(destination_value, destination_length, exception);
-  if (exception != 0) {
-    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+// -- decompress exact --
+
+// Decompressed length from frame headers allows to allocate destination buffer once.
+
+static inline zstds_ext_result_t decompress_exact(
+  ZSTD_DCtx*  ctx,
+  const char* source,
+  size_t      source_length,
+  VALUE       destination_value,
+  size_t      destination_length,
+  bool        gvl)
+{
+  zstds_ext_decompress_frames_args_t args = {
+    .ctx                = ctx,
+    .source             = source,
+    .source_length      = source_length,
+    .destination        = RSTRING_PTR(destination_value),
+    .destination_length = destination_length};
+
+  ZSTDS_EXT_GVL_WRAP(gvl, zstds_ext_decompress_frames_wrapper, &args);
+
+  return args.ext_result;
+}
+
+// -- decompress parallel --
+
+// Parallel decompressor requires content size in each frame, so each frame can be decompressed
+//   by separate worker directly into its part of destination.
+// Returns NULL when any frame has unknown content size, regular decompression will be used.
+
+static inline zstds_ext_batch_item_t* create_frame_items(
+  const char* source, size_t source_length, size_t* items_length_ptr, size_t* destination_length_ptr)
+{
+  size_t items_length   = 0;
+  size_t items_capacity = 16;
+
+  zstds_ext_batch_item_t* items = malloc(items_capacity * sizeof(zstds_ext_batch_item_t));
+  if (items == NULL) {
+    return NULL;
+  }
+
+  size_t destination_length = 0;
+
+  while (source_length != 0) {
+    unsigned long long frame_length = ZSTD_getFrameContentSize(source, source_length);
+    if (
+      frame_length == ZSTD_CONTENTSIZE_UNKNOWN || frame_length == ZSTD_CONTENTSIZE_ERROR ||
+      frame_length > SIZE_MAX - destination_length) {
+      free(items);
+      return NULL;
+    }
+
+    size_t frame_source_length = ZSTD_findFrameCompressedSize(source, source_length);
+    if (ZSTD_isError(frame_source_length)) {
+      free(items);
+      return NULL;
+    }
+
+    if (items_length == items_capacity) {
+      items_capacity *= 2;
+
+      zstds_ext_batch_item_t* new_items = realloc(items, items_capacity * sizeof(zstds_ext_batch_item_t));
+      if (new_items == NULL) {
+        free(items);
+        return NULL;
+      }
+
+      items = new_items;
+    }
+
+    zstds_ext_batch_item_t* item = &items[items_length++];
+
+    item->source             = source;
+    item->source_length      = frame_source_length;
+    item->destination_length = (size_t) frame_length;
+    item->ext_result         = 0;
+
+    destination_length += (size_t) frame_length;
+    source += frame_source_length;
+    source_length -= frame_source_length;
+  }
+
+  *items_length_ptr       = items_length;
+  *destination_length_ptr = destination_length;
+
+  return items;
+}
+
+static inline zstds_ext_result_t decompress_parallel(
+  zstds_ext_batch_item_t*           items,
+  size_t                            items_length,
+  VALUE                             destination_value,
+  size_t                            workers,
+  zstds_ext_decompressor_options_t* decompressor_options_ptr,
+  bool                              gvl)
+{
+  char* destination = RSTRING_PTR(destination_value);
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item = &items[index];
+
+    item->destination = destination;
+    destination += item->destination_length;
+  }
+
+  size_t     workers_length = zstds_ext_get_batch_workers_length(workers, items_length);
+  ZSTD_DCtx* ctxs[ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH];
+
+  zstds_ext_result_t ext_result =
+    zstds_ext_acquire_decompressor_contexts(ctxs, workers_length, decompressor_options_ptr);
+  if (ext_result != 0) {
+    return ext_result;
+  }
+
+  zstds_ext_batch_args_t args = {
+    .ctxs = (void**) ctxs, .workers_length = workers_length, .items = items, .items_length = items_length};
+
+  ZSTDS_EXT_GVL_WRAP(gvl, zstds_ext_decompress_batch_wrapper, &args);
+
+  zstds_ext_release_decompressor_contexts(ctxs, workers_length);
+
+  for (size_t index = 0; index < items_length; index++) {
+    if (items[index].ext_result != 0) {
+      return items[index].ext_result;
+    }
   }
 
   return 0;
@@ -231,45 +725,365 @@ VALUE zstds_ext_decompress_string(VALUE ZSTDS_EXT_UNUSED(self), VALUE source_val
 {
   Check_Type(source_value, T_STRING);
   Check_Type(options, T_HASH);
-  ZSTDS_EXT_GET_SIZE_OPTION(options, destination_buffer_length);
-  ZSTDS_EXT_GET_BOOL_OPTION(options, gvl);
+  GET_DESTINATION_OPTIONS(options, destination_options, ZSTD_DStreamOutSize());
+  ZSTDS_EXT_GET_GVL_OPTION(options);
+  ZSTDS_EXT_GET_GVL_THRESHOLD_OPTION(options);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, parallel);
+  ZSTDS_EXT_GET_STRING_OPTION(options, reference);
   ZSTDS_EXT_GET_DECOMPRESSOR_OPTIONS(options);
 
-  ZSTD_DCtx* ctx = ZSTD_createDCtx();
+  if (reference != Qnil && parallel != 0) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_VALIDATE_FAILED);
+  }
+
+  const char* source        = RSTRING_PTR(source_value);
+  size_t      source_length = RSTRING_LEN(source_value);
+
+  bool gvl = zstds_ext_keep_gvl_with_threshold(gvl_mode, source_length, gvl_threshold);
+
+  size_t destination_length;
+  int    exception;
+
+  // Single pass decompression doesn't respect window log max, it uses destination as window.
+  if (parallel != 0 && !decompressor_options.window_log_max.has_value) {
+    size_t                  items_length;
+    zstds_ext_batch_item_t* items = create_frame_items(source, source_length, &items_length, &destination_length);
+
+    if (items != NULL) {
+      ZSTDS_EXT_CREATE_STRING_BUFFER(destination_value, destination_length, exception);
+      if (exception == 0) {
+        zstds_ext_result_t ext_result =
+          decompress_parallel(items, items_length, destination_value, parallel, &decompressor_options, gvl);
+
+        free(items);
+
+        if (ext_result != 0) {
+          zstds_ext_raise_error(ext_result);
+        }
+
+        return destination_value;
+      }
+
+      free(items);
+
+      // Corrupted frame header may provide huge length, regular decompression will detect it.
+      rb_set_errinfo(Qnil);
+    }
+  }
+
+  ZSTD_DCtx* ctx = zstds_ext_acquire_decompressor_context();
   if (ctx == NULL) {
     zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
   }
 
   zstds_ext_result_t ext_result = zstds_ext_set_decompressor_options(ctx, &decompressor_options);
+  if (ext_result == 0 && reference != Qnil) {
+    ext_result = zstds_ext_set_decompressor_reference(
+      ctx, &decompressor_options, RSTRING_PTR(reference), RSTRING_LEN(reference));
+  }
+
+  if (ext_result != 0) {
+    zstds_ext_release_decompressor_context(ctx);
+    zstds_ext_raise_error(ext_result);
+  }
+
+  // Single pass decompression doesn't respect window log max, it uses destination as window.
+  if (
+    !decompressor_options.window_log_max.has_value &&
+    zstds_ext_get_decompressed_length(source, source_length, &destination_length)) {
+    ZSTDS_EXT_CREATE_STRING_BUFFER(destination_value, destination_length, exception);
+    if (exception == 0) {
+      ext_result = decompress_exact(ctx, source, source_length, destination_value, destination_length, gvl);
+
+      zstds_ext_release_decompressor_context(ctx);
+
+      if (ext_result != 0) {
+        zstds_ext_raise_error(ext_result);
+      }
+
+      return destination_value;
+    }
+
+    // Corrupted frame header may provide huge length, regular decompression will detect it.
+    rb_set_errinfo(Qnil);
+  }
+
+  ZSTDS_EXT_CREATE_STRING_BUFFER(destination_value, destination_options.buffer_length, exception);
+  if (exception != 0) {
+    zstds_ext_release_decompressor_context(ctx);
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  }
+
+  ext_result = decompress(ctx, source, source_length, destination_value, &destination_options, gvl);
+
+  zstds_ext_release_decompressor_context(ctx);
+
   if (ext_result != 0) {
-    ZSTD_freeDCtx(ctx);
     zstds_ext_raise_error(ext_result);
   }
 
-  if (destination_buffer_length == 0) {
-    destination_buffer_length = ZSTD_DStreamOutSize();
+  return destination_value;
+}
+
+// -- batch --
+
+// Batch allocates all destinations before processing, so all sources can be processed without GVL at once.
+// Compressor uses max compressed length, decompressor uses length from frame headers.
+// Decompressor processes sources with unknown length later using regular decompression.
+
+static inline zstds_ext_batch_item_t* create_batch_items(
+  VALUE sources, size_t* items_length_ptr, size_t* sources_length_ptr)
+{
+  size_t items_length   = RARRAY_LEN(sources);
+  size_t sources_length = 0;
+
+  for (size_t index = 0; index < items_length; index++) {
+    VALUE source_value = rb_ary_entry(sources, index);
+    Check_Type(source_value, T_STRING);
+
+    sources_length += RSTRING_LEN(source_value);
   }
 
+  // Empty batch requires valid pointer too.
+  zstds_ext_batch_item_t* items = malloc(items_length * sizeof(zstds_ext_batch_item_t) + 1);
+  if (items == NULL) {
+    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+  }
+
+  for (size_t index = 0; index < items_length; index++) {
+    VALUE                   source_value = rb_ary_entry(sources, index);
+    zstds_ext_batch_item_t* item         = &items[index];
+
+    item->source             = RSTRING_PTR(source_value);
+    item->source_length      = RSTRING_LEN(source_value);
+    item->destination        = NULL;
+    item->destination_length = 0;
+    item->ext_result         = 0;
+  }
+
+  *items_length_ptr   = items_length;
+  *sources_length_ptr = sources_length;
+
+  return items;
+}
+
+static inline zstds_ext_result_t add_batch_destination(
+  VALUE results, zstds_ext_batch_item_t* item, size_t destination_length)
+{
   int exception;
 
-  ZSTDS_EXT_CREATE_STRING_BUFFER(destination_value, destination_buffer_length, exception);
+  ZSTDS_EXT_CREATE_STRING_BUFFER(destination_value, destination_length, exception);
   if (exception != 0) {
-    ZSTD_freeDCtx(ctx);
-    zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    return ZSTDS_EXT_ERROR_ALLOCATE_FAILED;
   }
 
-  const char* source        = RSTRING_PTR(source_value);
-  size_t      source_length = RSTRING_LEN(source_value);
+  rb_ary_push(results, destination_value);
+
+  item->destination        = RSTRING_PTR(destination_value);
+  item->destination_length = destination_length;
 
-  ext_result = decompress(ctx, source, source_length, destination_value, destination_buffer_length, gvl);
+  return 0;
+}
 
-  ZSTD_freeDCtx(ctx);
+// Errors will be stored by index when errors array is provided, failed result will be nil.
+// Otherwise first error will be raised.
 
+static inline zstds_ext_result_t finish_batch(
+  VALUE                        results,
+  VALUE                        errors,
+  zstds_ext_batch_item_t*      items,
+  size_t                       items_length,
+  const destination_options_t* destination_options_ptr)
+{
+  zstds_ext_result_t first_ext_result = 0;
+
+  if (errors != Qnil) {
+    rb_ary_clear(errors);
+  }
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item       = &items[index];
+    zstds_ext_result_t      ext_result = item->ext_result;
+
+    if (ext_result == 0) {
+      ext_result = finish_destination_buffer(
+        rb_ary_entry(results, index), item->destination_length, destination_options_ptr);
+    }
+
+    if (ext_result != 0) {
+      rb_ary_store(results, index, Qnil);
+
+      if (first_ext_result == 0) {
+        first_ext_result = ext_result;
+      }
+    }
+
+    if (errors != Qnil) {
+      rb_ary_store(errors, index, ext_result == 0 ? Qnil : zstds_ext_create_error(ext_result));
+    }
+  }
+
+  return errors == Qnil ? first_ext_result : 0;
+}
+
+VALUE zstds_ext_compress_strings(VALUE ZSTDS_EXT_UNUSED(self), VALUE sources, VALUE options, VALUE errors)
+{
+  Check_Type(sources, T_ARRAY);
+  Check_Type(options, T_HASH);
+  if (errors != Qnil) {
+    Check_Type(errors, T_ARRAY);
+  }
+
+  GET_DESTINATION_OPTIONS(options, destination_options, ZSTD_CStreamOutSize());
+  ZSTDS_EXT_GET_GVL_OPTION(options);
+  ZSTDS_EXT_GET_GVL_THRESHOLD_OPTION(options);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, batch_workers);
+  ZSTDS_EXT_GET_COMPRESSOR_OPTIONS(options);
+
+  size_t                  items_length, sources_length;
+  zstds_ext_batch_item_t* items          = create_batch_items(sources, &items_length, &sources_length);
+  size_t                  workers_length = zstds_ext_get_batch_workers_length(batch_workers, items_length);
+
+  bool gvl = zstds_ext_keep_gvl_with_threshold(gvl_mode, sources_length, gvl_threshold);
+
+  ZSTD_CCtx* ctxs[ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH];
+
+  zstds_ext_result_t ext_result = zstds_ext_acquire_compressor_contexts(ctxs, workers_length, &compressor_options);
   if (ext_result != 0) {
+    free(items);
     zstds_ext_raise_error(ext_result);
   }
 
-  return destination_value;
+  VALUE results = rb_ary_new_capa(items_length);
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item = &items[index];
+
+    ext_result = add_batch_destination(results, item, ZSTD_compressBound(item->source_length));
+    if (ext_result != 0) {
+      zstds_ext_release_compressor_contexts(ctxs, workers_length);
+      free(items);
+      zstds_ext_raise_error(ext_result);
+    }
+  }
+
+  zstds_ext_batch_args_t args = {
+    .ctxs = (void**) ctxs, .workers_length = workers_length, .items = items, .items_length = items_length};
+
+  ZSTDS_EXT_GVL_WRAP(gvl, zstds_ext_compress_batch_wrapper, &args);
+
+  zstds_ext_release_compressor_contexts(ctxs, workers_length);
+
+  ext_result = finish_batch(results, errors, items, items_length, &destination_options);
+
+  free(items);
+
+  if (ext_result != 0) {
+    zstds_ext_raise_error(ext_result);
+  }
+
+  RB_GC_GUARD(sources);
+
+  return results;
+}
+
+VALUE zstds_ext_decompress_strings(VALUE ZSTDS_EXT_UNUSED(self), VALUE sources, VALUE options, VALUE errors)
+{
+  Check_Type(sources, T_ARRAY);
+  Check_Type(options, T_HASH);
+  if (errors != Qnil) {
+    Check_Type(errors, T_ARRAY);
+  }
+
+  GET_DESTINATION_OPTIONS(options, destination_options, ZSTD_DStreamOutSize());
+  ZSTDS_EXT_GET_GVL_OPTION(options);
+  ZSTDS_EXT_GET_GVL_THRESHOLD_OPTION(options);
+  ZSTDS_EXT_GET_SIZE_OPTION(options, batch_workers);
+  ZSTDS_EXT_GET_DECOMPRESSOR_OPTIONS(options);
+
+  size_t                  items_length, sources_length;
+  zstds_ext_batch_item_t* items          = create_batch_items(sources, &items_length, &sources_length);
+  size_t                  workers_length = zstds_ext_get_batch_workers_length(batch_workers, items_length);
+
+  bool gvl = zstds_ext_keep_gvl_with_threshold(gvl_mode, sources_length, gvl_threshold);
+
+  ZSTD_DCtx* ctxs[ZSTDS_EXT_BATCH_MAX_WORKERS_LENGTH];
+
+  zstds_ext_result_t ext_result =
+    zstds_ext_acquire_decompressor_contexts(ctxs, workers_length, &decompressor_options);
+  if (ext_result != 0) {
+    free(items);
+    zstds_ext_raise_error(ext_result);
+  }
+
+  VALUE results = rb_ary_new_capa(items_length);
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item = &items[index];
+    size_t                  destination_length;
+
+    // Single pass decompression doesn't respect window log max.
+    if (
+      decompressor_options.window_log_max.has_value ||
+      !zstds_ext_get_decompressed_length(item->source, item->source_length, &destination_length)) {
+      rb_ary_push(results, Qnil);
+      continue;
+    }
+
+    ext_result = add_batch_destination(results, item, destination_length);
+    if (ext_result != 0) {
+      // Corrupted frame header may provide huge length, regular decompression will detect it.
+      rb_set_errinfo(Qnil);
+      rb_ary_push(results, Qnil);
+    }
+  }
+
+  zstds_ext_batch_args_t args = {
+    .ctxs = (void**) ctxs, .workers_length = workers_length, .items = items, .items_length = items_length};
+
+  ZSTDS_EXT_GVL_WRAP(gvl, zstds_ext_decompress_batch_wrapper, &args);
+
+  // Regular decompression uses single context.
+  ZSTD_DCtx* ctx = ctxs[0];
+
+  for (size_t index = 0; index < items_length; index++) {
+    zstds_ext_batch_item_t* item = &items[index];
+    if (item->destination != NULL) {
+      continue;
+    }
+
+    int exception;
+
+    ZSTDS_EXT_CREATE_STRING_BUFFER(destination_value, destination_options.buffer_length, exception);
+    if (exception != 0) {
+      zstds_ext_release_decompressor_contexts(ctxs, workers_length);
+      free(items);
+      zstds_ext_raise_error(ZSTDS_EXT_ERROR_ALLOCATE_FAILED);
+    }
+
+    rb_ary_store(results, index, destination_value);
+
+    ZSTD_DCtx_reset(ctx, ZSTD_reset_session_only);
+
+    // Regular decompression finishes destination buffer itself, it won't be changed later.
+    item->ext_result = decompress(
+      ctx, item->source, item->source_length, destination_value, &destination_options, gvl);
+    item->destination_length = RSTRING_LEN(destination_value);
+  }
+
+  zstds_ext_release_decompressor_contexts(ctxs, workers_length);
+
+  ext_result = finish_batch(results, errors, items, items_length, &destination_options);
+
+  free(items);
+
+  if (ext_result != 0) {
+    zstds_ext_raise_error(ext_result);
+  }
+
+  RB_GC_GUARD(sources);
+
+  return results;
 }
 
 // -- exports --
@@ -278,4 +1092,7 @@ void zstds_ext_string_exports(VALUE root_module)
 {
   rb_define_module_function(root_module, "_native_compress_string", RUBY_METHOD_FUNC(zstds_ext_compress_string), 2);
   rb_define_module_function(root_module, "_native_decompress_string", RUBY_METHOD_FUNC(zstds_ext_decompress_string), 2);
+  rb_define_module_function(root_module, "_native_compress_strings", RUBY_METHOD_FUNC(zstds_ext_compress_strings), 3);
+  rb_define_module_function(
+    root_module, "_native_decompress_strings", RUBY_METHOD_FUNC(zstds_ext_decompress_strings), 3);
 }
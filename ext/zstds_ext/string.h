@@ -9,6 +9,9 @@
 VALUE zstds_ext_compress_string(VALUE self, VALUE source, VALUE options);
 VALUE zstds_ext_decompress_string(VALUE self, VALUE source, VALUE options);
 
+VALUE zstds_ext_compress_strings(VALUE self, VALUE sources, VALUE options, VALUE errors);
+VALUE zstds_ext_decompress_strings(VALUE self, VALUE sources, VALUE options, VALUE errors);
+
 void zstds_ext_string_exports(VALUE root_module);
 
 #endif // ZSTDS_EXT_STRING_H
@@ -0,0 +1,265 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#include "zstds_ext/thread_pool.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "zstds_ext/macro.h"
+
+// -- job --
+
+typedef struct
+{
+  atomic_size_t index;
+  size_t        end;
+} range_t;
+
+typedef struct job_t
+{
+  zstds_ext_thread_pool_function_t function;
+  void*                            data;
+  range_t*                         ranges;
+  size_t                           workers_length;
+
+  // Fields below are protected by pool mutex.
+  size_t         next_worker_index;
+  size_t         active_workers_length;
+  pthread_cond_t finished;
+  struct job_t*  next;
+} job_t;
+
+static inline void process_range(job_t* job_ptr, size_t worker_index, range_t* range_ptr)
+{
+  while (true) {
+    size_t index = atomic_fetch_add_explicit(&range_ptr->index, 1, memory_order_relaxed);
+    if (index >= range_ptr->end) {
+      break;
+    }
+
+    job_ptr->function(job_ptr->data, worker_index, index);
+  }
+}
+
+static inline void run_worker(job_t* job_ptr, size_t worker_index)
+{
+  size_t workers_length = job_ptr->workers_length;
+
+  process_range(job_ptr, worker_index, &job_ptr->ranges[worker_index]);
+
+  // Stealing indexes from other workers.
+  for (size_t offset = 1; offset < workers_length; offset++) {
+    process_range(job_ptr, worker_index, &job_ptr->ranges[(worker_index + offset) % workers_length]);
+  }
+}
+
+// -- pool --
+
+typedef struct
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t  has_jobs;
+  job_t*          jobs;
+  size_t          threads_length;
+} pool_t;
+
+static pool_t pool = {.mutex = PTHREAD_MUTEX_INITIALIZER, .has_jobs = PTHREAD_COND_INITIALIZER};
+
+static inline void remove_job(job_t* job_ptr)
+{
+  job_t** next_ptr = &pool.jobs;
+
+  while (*next_ptr != NULL) {
+    if (*next_ptr == job_ptr) {
+      *next_ptr = job_ptr->next;
+      break;
+    }
+
+    next_ptr = &(*next_ptr)->next;
+  }
+}
+
+static void* run_thread(void* ZSTDS_EXT_UNUSED(data))
+{
+  pthread_mutex_lock(&pool.mutex);
+
+  while (true) {
+    job_t* job_ptr = pool.jobs;
+    if (job_ptr == NULL) {
+      pthread_cond_wait(&pool.has_jobs, &pool.mutex);
+      continue;
+    }
+
+    size_t worker_index = job_ptr->next_worker_index++;
+    job_ptr->active_workers_length++;
+
+    if (job_ptr->next_worker_index == job_ptr->workers_length) {
+      remove_job(job_ptr);
+    }
+
+    pthread_mutex_unlock(&pool.mutex);
+
+    run_worker(job_ptr, worker_index);
+
+    pthread_mutex_lock(&pool.mutex);
+
+    job_ptr->active_workers_length--;
+    if (job_ptr->active_workers_length == 0) {
+      pthread_cond_signal(&job_ptr->finished);
+    }
+  }
+
+  return NULL;
+}
+
+// Signals should be received by ruby threads only.
+
+static inline void create_threads(size_t threads_length)
+{
+  if (threads_length > ZSTDS_EXT_THREAD_POOL_MAX_LENGTH) {
+    threads_length = ZSTDS_EXT_THREAD_POOL_MAX_LENGTH;
+  }
+
+  if (pool.threads_length >= threads_length) {
+    return;
+  }
+
+  sigset_t signals, old_signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_SETMASK, &signals, &old_signals);
+
+  while (pool.threads_length < threads_length) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, run_thread, NULL) != 0) {
+      break;
+    }
+
+    pthread_detach(thread);
+    pool.threads_length++;
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+}
+
+static inline void run_sequentially(size_t length, zstds_ext_thread_pool_function_t function, void* data)
+{
+  for (size_t index = 0; index < length; index++) {
+    function(data, 0, index);
+  }
+}
+
+void zstds_ext_thread_pool_run(
+  size_t workers_length, size_t length, zstds_ext_thread_pool_function_t function, void* data)
+{
+  if (workers_length > length) {
+    workers_length = length;
+  }
+
+  if (workers_length > ZSTDS_EXT_THREAD_POOL_MAX_LENGTH + 1) {
+    workers_length = ZSTDS_EXT_THREAD_POOL_MAX_LENGTH + 1;
+  }
+
+  if (workers_length <= 1) {
+    run_sequentially(length, function, data);
+    return;
+  }
+
+  range_t* ranges = malloc(workers_length * sizeof(range_t));
+  if (ranges == NULL) {
+    run_sequentially(length, function, data);
+    return;
+  }
+
+  for (size_t worker_index = 0; worker_index < workers_length; worker_index++) {
+    atomic_init(&ranges[worker_index].index, length * worker_index / workers_length);
+    ranges[worker_index].end = length * (worker_index + 1) / workers_length;
+  }
+
+  job_t job = {
+    .function              = function,
+    .data                  = data,
+    .ranges                = ranges,
+    .workers_length        = workers_length,
+    .next_worker_index     = 1,
+    .active_workers_length = 0,
+    .next                  = NULL};
+
+  pthread_cond_init(&job.finished, NULL);
+
+  pthread_mutex_lock(&pool.mutex);
+
+  create_threads(workers_length - 1);
+
+  job.next  = pool.jobs;
+  pool.jobs = &job;
+
+  pthread_cond_broadcast(&pool.has_jobs);
+  pthread_mutex_unlock(&pool.mutex);
+
+  run_worker(&job, 0);
+
+  // Busy pool threads may not join this job, all indexes are processed already.
+  pthread_mutex_lock(&pool.mutex);
+
+  remove_job(&job);
+
+  while (job.active_workers_length != 0) {
+    pthread_cond_wait(&job.finished, &pool.mutex);
+  }
+
+  pthread_mutex_unlock(&pool.mutex);
+
+  pthread_cond_destroy(&job.finished);
+  free(ranges);
+}
+
+// -- fork --
+
+// Child process has single thread only, pool threads and their jobs don't exist in child process.
+
+static void prepare_fork(void)
+{
+  pthread_mutex_lock(&pool.mutex);
+}
+
+static void finish_fork_in_parent(void)
+{
+  pthread_mutex_unlock(&pool.mutex);
+}
+
+static void finish_fork_in_child(void)
+{
+  pthread_mutex_init(&pool.mutex, NULL);
+  pthread_cond_init(&pool.has_jobs, NULL);
+
+  pool.jobs           = NULL;
+  pool.threads_length = 0;
+}
+
+// -- exports --
+
+static VALUE get_threads_length(VALUE ZSTDS_EXT_UNUSED(self))
+{
+  pthread_mutex_lock(&pool.mutex);
+  size_t threads_length = pool.threads_length;
+  pthread_mutex_unlock(&pool.mutex);
+
+  return SIZET2NUM(threads_length);
+}
+
+void zstds_ext_thread_pool_exports(VALUE root_module)
+{
+  if (pthread_atfork(prepare_fork, finish_fork_in_parent, finish_fork_in_child) != 0) {
+    rb_raise(rb_eLoadError, "failed to initialize thread pool");
+  }
+
+  VALUE module = rb_define_module_under(root_module, "ThreadPool");
+
+  rb_define_const(module, "MAX_LENGTH", SIZET2NUM(ZSTDS_EXT_THREAD_POOL_MAX_LENGTH));
+
+  rb_define_module_function(module, "length", RUBY_METHOD_FUNC(get_threads_length), 0);
+}
@@ -0,0 +1,27 @@
+// Ruby bindings for zstd library.
+// Copyright (c) 2019 AUTHORS, MIT License.
+
+#if !defined(ZSTDS_EXT_THREAD_POOL_H)
+#define ZSTDS_EXT_THREAD_POOL_H
+
+#include <stddef.h>
+
+#include "ruby.h"
+
+// Threads are created on demand and never finished, they are shared between all jobs.
+#define ZSTDS_EXT_THREAD_POOL_MAX_LENGTH 256
+
+// Function receives worker index, so each worker can use its own resources.
+typedef void (*zstds_ext_thread_pool_function_t)(void* data, size_t worker_index, size_t index);
+
+// Runs function for each index from 0 to length using current thread and (workers_length - 1) pool threads.
+// Indexes are split into ranges per worker, worker steals indexes from other ranges when its range is finished.
+// Function may be called from current thread only when pool threads are not available.
+// Function can't use ruby api, this function should be used without GVL.
+
+void zstds_ext_thread_pool_run(
+  size_t workers_length, size_t length, zstds_ext_thread_pool_function_t function, void* data);
+
+void zstds_ext_thread_pool_exports(VALUE root_module);
+
+#endif // ZSTDS_EXT_THREAD_POOL_H
@@ -4,6 +4,8 @@
 require_relative "zstds/stream/reader"
 require_relative "zstds/stream/writer"
 require_relative "zstds/dictionary"
+require_relative "zstds/dictionary_registry"
 require_relative "zstds/file"
+require_relative "zstds/seekable"
 require_relative "zstds/string"
 require_relative "zstds/version"
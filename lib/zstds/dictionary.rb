@@ -11,11 +11,40 @@ module ZSTDS
   class Dictionary
     # Current train defaults.
     TRAIN_DEFAULTS = {
-      :gvl      => false,
-      :capacity => 0
+      :gvl         => false,
+      :capacity    => 0,
+      :algorithm   => nil,
+      :k           => 0,
+      :d           => 0,
+      :f           => 0,
+      :steps       => 0,
+      :split_point => 0,
+      :accel       => 0,
+      :nb_threads  => 1
     }
     .freeze
 
+    # Current train each defaults.
+    TRAIN_EACH_DEFAULTS = TRAIN_DEFAULTS.merge(
+      :max_samples_size => 1 << 24 # 16 MB
+    )
+    .freeze
+
+    # Current train algorithms.
+    TRAIN_ALGORITHMS = [nil, :cover, :fast_cover].freeze
+
+    # Current train cover params.
+    TRAIN_COVER_PARAMS = %i[k d f steps split_point accel nb_threads].freeze
+
+    # Current train cover params available for fast cover only.
+    TRAIN_FAST_COVER_PARAMS = %i[f accel].freeze
+
+    # Current max train accel.
+    MAX_TRAIN_ACCEL = 10
+
+    # Current max train f.
+    MAX_TRAIN_F = 31
+
     # Current finalize defaults.
     FINALIZE_DEFAULTS = {
       :gvl                => false,
@@ -35,40 +64,156 @@ module ZSTDS
     # Reads current +buffer+ binary data.
     attr_reader :buffer
 
+    # Reads params chosen by cover training, it is nil for dictionary created from buffer.
+    attr_reader :train_params
+
     # Initializes compressor.
     # Uses +buffer+ binary data.
-    def initialize(buffer)
+    # Uses +train_params+ params chosen by cover training.
+    def initialize(buffer, train_params = nil)
       Validation.validate_string buffer
       raise ValidateError, "dictionary buffer should not be empty" if buffer.empty?
 
-      @buffer = buffer
+      Validation.validate_hash train_params unless train_params.nil?
+
+      @buffer       = buffer
+      @train_params = train_params
     end
 
     # Trains dictionary.
     # Uses +samples+ list of binary datas.
     # Uses +options+ options hash.
-    # Option +gvl+ is global interpreter lock enabled.
+    # Option +gvl+ is global interpreter lock enabled, +:auto+ enables it for small samples only.
     # Option +capacity+ capacity of dictionary buffer.
-    # Returns dictionary based on new buffer.
+    # Option +algorithm+ +nil+ for default training, +:cover+ or +:fast_cover+ for cover params search.
+    # Option +k+ segment size, +0+ enables search.
+    # Option +d+ dmer size, +0+ enables search.
+    # Option +f+ log of frequency table size (fast cover only), +0+ means default.
+    # Option +steps+ number of search steps, +0+ means default.
+    # Option +split_point+ part of samples used for training, others are used for testing, +0+ means default.
+    # Option +accel+ acceleration level (fast cover only), +0+ means default.
+    # Option +nb_threads+ number of search threads.
+    # Interrupted training keeps running in background until it is finished, see +GVL.abandoned_jobs+.
+    # Returns dictionary based on new buffer, cover params chosen by search are available as +train_params+.
     def self.train(samples, options = {})
       validate_samples samples
 
+      options = get_train_options options
+
+      buffer, train_params = train_buffer samples, options
+      new buffer, train_params
+    end
+
+    # Trains dictionary without copying samples.
+    # Uses +samples_buffer+ binary data with all samples concatenated.
+    # Uses +sample_sizes+ list of sample sizes, their sum should be equal to buffer size.
+    # Uses +options+ same as +train+, training can't be abandoned on interrupt.
+    # Returns dictionary based on new buffer.
+    def self.train_concatenated(samples_buffer, sample_sizes, options = {})
+      Validation.validate_string samples_buffer
+      Validation.validate_array sample_sizes
+
+      sample_sizes.each { |sample_size| Validation.validate_positive_integer sample_size }
+      raise ValidateError, "sample sizes should match samples buffer size" unless
+        sample_sizes.sum == samples_buffer.bytesize
+
+      options = get_train_options options
+
+      buffer, train_params = train_concatenated_buffer samples_buffer, sample_sizes, options
+      new buffer, train_params
+    end
+
+    # Trains dictionary using files, each file is a sample.
+    # Uses +paths+ list of file paths, files will be mapped and read natively.
+    # Uses +options+ same as +train+.
+    # Returns dictionary based on new buffer.
+    def self.train_files(paths, options = {})
+      Validation.validate_array paths
+      raise ValidateError, "dictionary paths should not be empty" if paths.empty?
+
+      paths.each do |path|
+        Validation.validate_string path
+        raise ValidateError, "dictionary path should not be empty" if path.empty?
+      end
+
+      options = get_train_options options
+
+      buffer, train_params = train_files_buffer paths, options
+      new buffer, train_params
+    end
+
+    # Trains dictionary using samples received one by one.
+    # Uses +samples+ enumerable of binary datas, it is not required to keep all samples in memory.
+    # Uses +options+ same as +train+.
+    # Option +max_samples_size+ max size of samples kept in native reservoir, random subset is used after reaching it.
+    # Returns dictionary based on new buffer.
+    def self.train_each(samples, options = {})
+      raise ValidateError, "invalid samples" unless samples.respond_to? :each
+
+      Validation.validate_hash options
+
+      options = TRAIN_EACH_DEFAULTS.merge options
+
+      Validation.validate_positive_integer options[:max_samples_size]
+
+      options   = get_train_options options
+      reservoir = Reservoir.new options[:max_samples_size]
+
+      samples.each do |sample|
+        validate_sample sample
+        reservoir.add sample
+      end
+
+      buffer, train_params = train_reservoir_buffer reservoir, options
+      new buffer, train_params
+    end
+
+    # Returns processed train +options+.
+    def self.get_train_options(options)
       Validation.validate_hash options
 
       options = TRAIN_DEFAULTS.merge options
 
-      Validation.validate_bool                 options[:gvl]
+      Validation.validate_gvl                  options[:gvl]
       Validation.validate_not_negative_integer options[:capacity]
 
-      buffer = train_buffer samples, options
-      new buffer
+      validate_train_cover_options options
+
+      options
+    end
+
+    # Raises error when cover +options+ are invalid.
+    def self.validate_train_cover_options(options)
+      algorithm = options[:algorithm]
+      raise ValidateError, "invalid train algorithm" unless TRAIN_ALGORITHMS.include? algorithm
+
+      %i[k d f steps accel].each { |name| Validation.validate_not_negative_integer options[name] }
+      Validation.validate_positive_integer options[:nb_threads]
+
+      split_point = options[:split_point]
+      raise ValidateError, "invalid split point" unless
+        split_point.is_a?(::Numeric) && split_point >= 0 && split_point <= 1
+
+      k = options[:k]
+      d = options[:d]
+      raise ValidateError, "invalid d" if k != 0 && d > k
+
+      raise ValidateError, "invalid f" if options[:f] > MAX_TRAIN_F
+      raise ValidateError, "invalid accel" if options[:accel] > MAX_TRAIN_ACCEL
+
+      changed_params = TRAIN_COVER_PARAMS.reject { |name| options[name] == TRAIN_DEFAULTS[name] }
+
+      raise ValidateError, "cover params require cover algorithm" if algorithm.nil? && !changed_params.empty?
+
+      raise ValidateError, "fast cover params require fast cover algorithm" if
+        algorithm == :cover && !(changed_params & TRAIN_FAST_COVER_PARAMS).empty?
     end
 
     # Finalizes dictionary.
     # Uses +content+ binary data.
     # Uses +samples+ list of binary datas.
     # Uses +options+ options hash.
-    # Option +gvl+ is global interpreter lock enabled.
+    # Option +gvl+ is global interpreter lock enabled, +:auto+ enables it for small samples only.
     # Option +max_size+ max size of dictionary buffer.
     # Option +dictionary_options+ standard dictionary options hash.
     # Returns dictionary based on new buffer.
@@ -82,7 +227,7 @@ module ZSTDS
 
       options = FINALIZE_DEFAULTS.merge options
 
-      Validation.validate_bool                 options[:gvl]
+      Validation.validate_gvl                  options[:gvl]
       Validation.validate_not_negative_integer options[:max_size]
       Validation.validate_hash                 options[:dictionary_options]
 
@@ -104,10 +249,13 @@ module ZSTDS
     def self.validate_samples(samples)
       Validation.validate_array samples
 
-      samples.each do |sample|
-        Validation.validate_string sample
-        raise ValidateError, "dictionary sample should not be empty" if sample.empty?
-      end
+      samples.each { |sample| validate_sample sample }
+    end
+
+    # Raises error when +sample+ is not a not empty string.
+    def self.validate_sample(sample)
+      Validation.validate_string sample
+      raise ValidateError, "dictionary sample should not be empty" if sample.empty?
     end
 
     # Returns current dictionary id.
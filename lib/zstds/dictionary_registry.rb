@@ -0,0 +1,230 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require_relative "dictionary"
+require_relative "error"
+require_relative "file"
+require_relative "string"
+require_relative "validation"
+
+module ZSTDS
+  # ZSTDS::DictionaryRegistry class.
+  # Registry keeps dictionaries by id and selects dictionary for decompression using frame header.
+  # Least recently used dictionaries are evicted when memory size exceeds max size.
+  class DictionaryRegistry
+    # Current registry defaults.
+    DEFAULTS = {
+      # Max memory size of dictionary buffers and digested dictionaries, 0 disables eviction.
+      :max_size => 1 << 26 # 64 MB
+    }
+    .freeze
+
+    # Max frame header size.
+    FRAME_HEADER_SIZE = 18
+
+    # Reads current max memory size.
+    attr_reader :max_size
+
+    # Reads current memory size of dictionary buffers and digested dictionaries.
+    attr_reader :memory_size
+
+    # Initializes registry using +options+.
+    # Option: +:max_size+ max memory size of dictionary buffers and digested dictionaries, 0 disables eviction.
+    # Uses optional +loader+ block, it receives id of missing dictionary and returns dictionary or nil.
+    def initialize(options = {}, &loader)
+      Validation.validate_hash options
+
+      options = DEFAULTS.merge options
+      Validation.validate_not_negative_integer options[:max_size]
+
+      @max_size    = options[:max_size]
+      @loader      = loader
+      @memory_size = 0
+
+      # Hash keeps insertion order, least recently used dictionary is the first one.
+      @dictionaries = {}
+      @sizes        = {}
+      @mutex        = ::Mutex.new
+    end
+
+    # Adds +dictionary+ using its id, dictionary with same id will be replaced.
+    def add(dictionary)
+      validate_dictionary dictionary
+
+      id = dictionary.id
+
+      @mutex.synchronize do
+        remove_dictionary id
+        store_dictionary id, dictionary
+        evict_dictionaries
+      end
+
+      self
+    end
+
+    alias << add
+
+    # Removes dictionary by +id+.
+    # Returns removed dictionary or nil.
+    def delete(id)
+      Validation.validate_not_negative_integer id
+
+      @mutex.synchronize { remove_dictionary id }
+    end
+
+    # Returns dictionary by +id+, loader will be used for missing dictionary.
+    # Returns nil when dictionary is not found.
+    def [](id)
+      Validation.validate_not_negative_integer id
+
+      dictionary = @mutex.synchronize { touch_dictionary id }
+      return dictionary unless dictionary.nil? && !@loader.nil?
+
+      # Loader may be slow, other dictionaries can be used meanwhile.
+      dictionary = @loader.call id
+      return nil if dictionary.nil?
+
+      validate_dictionary dictionary
+      raise ValidateError, "invalid dictionary id" unless dictionary.id == id
+
+      @mutex.synchronize do
+        store_dictionary id, dictionary unless @dictionaries.key? id
+        evict_dictionaries
+      end
+
+      dictionary
+    end
+
+    # Returns true when dictionary with +id+ is resident.
+    def include?(id)
+      @mutex.synchronize { @dictionaries.key? id }
+    end
+
+    # Returns ids of resident dictionaries from least to most recently used.
+    def ids
+      @mutex.synchronize { @dictionaries.keys }
+    end
+
+    # Returns number of resident dictionaries.
+    def length
+      @mutex.synchronize { @dictionaries.length }
+    end
+
+    # Returns dictionary required by first frame of +source+ string.
+    # Returns nil when frame doesn't require dictionary.
+    def frame_dictionary(source)
+      Validation.validate_string source
+
+      id = Dictionary.get_frame_id source
+      return nil if id.zero?
+
+      dictionary = self[id]
+      raise CorruptedDictionaryError, "dictionary #{id} is not found" if dictionary.nil?
+
+      dictionary
+    end
+
+    # Compresses +source+ string using dictionary with +id+ and +options+.
+    # Returns compressed string.
+    def compress(source, id, options = {})
+      Validation.validate_hash options
+
+      dictionary = self[id]
+      raise CorruptedDictionaryError, "dictionary #{id} is not found" if dictionary.nil?
+
+      result = String.compress source, options.merge(:dictionary => dictionary)
+      update_dictionary dictionary
+
+      result
+    end
+
+    # Decompresses +source+ string using dictionary required by first frame and +options+.
+    # Returns decompressed string.
+    def decompress(source, options = {})
+      Validation.validate_hash options
+
+      dictionary = frame_dictionary source
+      return String.decompress source, options if dictionary.nil?
+
+      result = String.decompress source, options.merge(:dictionary => dictionary)
+      update_dictionary dictionary
+
+      result
+    end
+
+    # Decompresses data from +source+ file path to +destination+ file path.
+    # Uses dictionary required by first frame and +options+.
+    def decompress_file(source, destination, options = {})
+      Validation.validate_string source
+      Validation.validate_hash options
+
+      header     = ::File.binread(source, FRAME_HEADER_SIZE) || ""
+      dictionary = frame_dictionary header
+      return File.decompress source, destination, options if dictionary.nil?
+
+      File.decompress source, destination, options.merge(:dictionary => dictionary)
+      update_dictionary dictionary
+
+      nil
+    end
+
+    # Updates memory size of +dictionary+, it grows when digested dictionaries are created.
+    # Least recently used dictionaries will be evicted when max size is exceeded.
+    def update_dictionary(dictionary)
+      validate_dictionary dictionary
+
+      id = dictionary.id
+
+      @mutex.synchronize do
+        next unless @dictionaries[id].equal? dictionary
+
+        @memory_size -= @sizes[id]
+        @sizes[id] = get_dictionary_size dictionary
+        @memory_size += @sizes[id]
+
+        evict_dictionaries
+      end
+
+      nil
+    end
+
+    protected def validate_dictionary(dictionary)
+      raise ValidateError, "invalid dictionary" unless dictionary.is_a? Dictionary
+    end
+
+    protected def get_dictionary_size(dictionary)
+      dictionary.buffer.bytesize + dictionary.digested_size
+    end
+
+    # Methods below should be called inside mutex.
+
+    protected def touch_dictionary(id)
+      dictionary = @dictionaries.delete id
+      @dictionaries[id] = dictionary unless dictionary.nil?
+
+      dictionary
+    end
+
+    protected def store_dictionary(id, dictionary)
+      size = get_dictionary_size dictionary
+
+      @dictionaries[id] = dictionary
+      @sizes[id]        = size
+      @memory_size     += size
+    end
+
+    protected def remove_dictionary(id)
+      dictionary = @dictionaries.delete id
+      @memory_size -= @sizes.delete id unless dictionary.nil?
+
+      dictionary
+    end
+
+    # Most recently used dictionary is kept even when it exceeds max size.
+    protected def evict_dictionaries
+      return if @max_size.zero?
+
+      remove_dictionary @dictionaries.first[0] while @memory_size > @max_size && @dictionaries.length > 1
+    end
+  end
+end
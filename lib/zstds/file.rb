@@ -17,16 +17,98 @@ module ZSTDS
     # Option: +:source_buffer_length+ source buffer length.
     # Option: +:destination_buffer_length+ destination buffer length.
     # Option: +:pledged_size+ source bytesize.
+    # Option: +:mmap+ enables mapping of regular files into memory.
+    # Option: +:pipeline+ enables reading and writing of files in separate threads.
+    # Option: +:parallel+ number of threads compressing independent frames in parallel (including current thread).
+    # Option: +:parallel_frame_size+ decompressed size of each independent frame.
+    # Option: +:reference_path+ previous version of source file, destination will contain only difference.
     def self.compress(source, destination, options = {})
       Validation.validate_string source
 
+      options = Option.get_file_options options
+      options = Option.get_parallel_options options
       options = Option.get_compressor_options options, BUFFER_LENGTH_NAMES
+      options = Option.get_reference_options options, :reference_path
 
       options[:pledged_size] = ::File.size source
 
       super source, destination, options
     end
 
+    # Decompresses data from +source+ file path to +destination+ file path.
+    # Option: +:source_buffer_length+ source buffer length.
+    # Option: +:destination_buffer_length+ destination buffer length.
+    # Option: +:mmap+ enables mapping of regular files into memory.
+    # Option: +:pipeline+ enables reading and writing of files in separate threads.
+    # Option: +:parallel+ number of threads decompressing frames with content size in parallel.
+    # Option: +:reference_path+ same reference file that was used for compression.
+    def self.decompress(source, destination, options = {})
+      options = Option.get_file_options options
+      options = Option.get_parallel_options options
+      options = Option.get_reference_options options, :reference_path
+      return super source, destination, options unless options[:mmap]
+
+      Validation.validate_string source
+      Validation.validate_string destination
+
+      options = Option.get_decompressor_options options, BUFFER_LENGTH_NAMES
+
+      # Destination can be mapped only when it is opened for both reading and writing.
+      ::File.open source, "rb" do |source_io|
+        ::File.open destination, "w+b" do |destination_io|
+          native_decompress_io source_io, destination_io, options
+        end
+      end
+
+      nil
+    end
+
+    # Compresses data from +source+ IO to +destination+ IO.
+    # Any IO with file descriptor can be used: file, pipe, socket.
+    # Option: +:source_buffer_length+ source buffer length.
+    # Option: +:destination_buffer_length+ destination buffer length.
+    # Option: +:mmap+ enables mapping of regular files into memory.
+    # Option: +:pipeline+ enables reading and writing of files in separate threads.
+    # Option: +:parallel+ number of threads compressing independent frames in parallel (including current thread).
+    # Option: +:parallel_frame_size+ decompressed size of each independent frame.
+    # Option: +:reference_path+ previous version of source file, destination will contain only difference.
+    def self.compress_io(source, destination, options = {})
+      validate_io source
+      validate_io destination
+
+      options = Option.get_file_options options
+      options = Option.get_parallel_options options
+      options = Option.get_compressor_options options, BUFFER_LENGTH_NAMES
+      options = Option.get_reference_options options, :reference_path
+
+      native_compress_io source, destination, options
+    end
+
+    # Decompresses data from +source+ IO to +destination+ IO.
+    # Any IO with file descriptor can be used: file, pipe, socket.
+    # Option: +:source_buffer_length+ source buffer length.
+    # Option: +:destination_buffer_length+ destination buffer length.
+    # Option: +:mmap+ enables mapping of regular files into memory.
+    # Option: +:pipeline+ enables reading and writing of files in separate threads.
+    # Option: +:parallel+ number of threads decompressing frames with content size in parallel.
+    # Option: +:reference_path+ same reference file that was used for compression.
+    def self.decompress_io(source, destination, options = {})
+      validate_io source
+      validate_io destination
+
+      options = Option.get_file_options options
+      options = Option.get_parallel_options options
+      options = Option.get_decompressor_options options, BUFFER_LENGTH_NAMES
+      options = Option.get_reference_options options, :reference_path
+
+      native_decompress_io source, destination, options
+    end
+
+    # Raises error when +io+ has no file descriptor.
+    private_class_method def self.validate_io(io)
+      raise ValidateError, "invalid io" unless io.respond_to?(:fileno) && !io.fileno.nil?
+    end
+
     # Bypass native compress.
     def self.native_compress_io(*args)
       ZSTDS._native_compress_io(*args)
@@ -17,6 +17,8 @@ module ZSTDS
     COMPRESSOR_DEFAULTS = {
       # Enables global VM lock where possible.
       :gvl                           => false,
+      # Places stream context and destination buffer into single preallocated workspace.
+      :static_workspace              => false,
       # Compression level.
       :compression_level             => nil,
       # Maximum back-reference distance (power of 2).
@@ -64,18 +66,75 @@ module ZSTDS
     # Current decompressor defaults.
     DECOMPRESSOR_DEFAULTS = {
       # Enables global VM lock where possible.
-      :gvl            => false,
+      :gvl              => false,
+      # Places stream context and destination buffer into single preallocated workspace.
+      :static_workspace => false,
       # Size limit (power of 2).
-      :window_log_max => nil,
+      :window_log_max   => nil,
       # Chose dictionary.
-      :dictionary     => nil
+      :dictionary       => nil
     }
     .freeze
 
+    # Current string defaults.
+    STRING_DEFAULTS = {
+      # Growth policy for destination buffer.
+      :destination_buffer_growth     => :geometric,
+      # Maximum growth of destination buffer.
+      :max_destination_buffer_growth => 0,
+      # Enables shrinking of destination buffer to result length.
+      :shrink_destination_buffer     => true,
+      # Source length below which global VM lock won't be released in +:auto+ gvl mode, nil means +GVL.threshold+.
+      :gvl_threshold                 => nil,
+      # Source length compressed between interrupt checks, 0 disables slicing.
+      :slice_size                    => 1 << 20,
+      # Enables switching to other threads between slices when global VM lock is enabled.
+      :slice_yield                   => false
+    }
+    .freeze
+
+    # Current batch defaults.
+    BATCH_DEFAULTS = {
+      # Number of threads processing sources in parallel (including current thread).
+      :batch_workers => 0
+    }
+    .freeze
+
+    # Current parallel defaults.
+    PARALLEL_DEFAULTS = {
+      # Number of threads processing independent frames in parallel (including current thread), 0 disables it.
+      :parallel            => 0,
+      # Decompressed size of each independent frame.
+      :parallel_frame_size => 1 << 22
+    }
+    .freeze
+
+    # Current file defaults.
+    FILE_DEFAULTS = {
+      # Enables mapping of regular files into memory.
+      :mmap     => false,
+      # Enables reading and writing of files in separate threads.
+      :pipeline => false
+    }
+    .freeze
+
+    # Current reference defaults.
+    REFERENCE_DEFAULTS = {
+      # Reference string used as prefix for compressed frame.
+      :reference      => nil,
+      # Reference file path used as prefix for compressed frame.
+      :reference_path => nil
+    }
+    .freeze
+
+    # Current destination buffer growth policies.
+    DESTINATION_BUFFER_GROWTHS = %i[fixed geometric ratio].freeze
+
     # Processes compressor +options+ and +buffer_length_names+.
     # Option: +:source_buffer_length+ source buffer length.
     # Option: +:destination_buffer_length+ destination buffer length.
-    # Option: +:gvl+ enables global VM lock where possible.
+    # Option: +:gvl+ enables global VM lock where possible, +:auto+ enables it for small sources only.
+    # Option: +:static_workspace+ places stream context and destination buffer into single preallocated workspace.
     # Option: +:compression_level+ compression level.
     # Option: +:window_log+ maximum back-reference distance (power of 2).
     # Option: +:hash_log+ size of the initial probe table (power of 2).
@@ -108,7 +167,8 @@ module ZSTDS
 
       buffer_length_names.each { |name| Validation.validate_not_negative_integer options[name] }
 
-      Validation.validate_bool options[:gvl]
+      Validation.validate_gvl options[:gvl]
+      Validation.validate_bool options[:static_workspace]
 
       compression_level = options[:compression_level]
       unless compression_level.nil?
@@ -166,7 +226,13 @@ module ZSTDS
       end
 
       enable_long_distance_matching = options[:enable_long_distance_matching]
-      Validation.validate_bool enable_long_distance_matching unless enable_long_distance_matching.nil?
+      unless enable_long_distance_matching.nil?
+        Validation.validate_bool enable_long_distance_matching
+
+        # Static workspace size can't be estimated for long distance matching.
+        raise ValidateError, "invalid long distance matching for static workspace" if
+          options[:static_workspace] && enable_long_distance_matching
+      end
 
       ldm_hash_log = options[:ldm_hash_log]
       unless ldm_hash_log.nil?
@@ -210,6 +276,10 @@ module ZSTDS
         Validation.validate_not_negative_integer nb_workers
         raise ValidateError, "invalid nb workers" if
           nb_workers < MIN_NB_WORKERS || nb_workers > MAX_NB_WORKERS
+
+        # Static workspace can't be used by workers.
+        raise ValidateError, "invalid nb workers for static workspace" if
+          options[:static_workspace] && nb_workers.positive?
       end
 
       job_size = options[:job_size]
@@ -236,7 +306,8 @@ module ZSTDS
     # Processes decompressor +options+ and +buffer_length_names+.
     # Option: +:source_buffer_length+ source buffer length.
     # Option: +:destination_buffer_length+ destination buffer length.
-    # Option: +:gvl+ enables global VM lock where possible.
+    # Option: +:gvl+ enables global VM lock where possible, +:auto+ enables it for small sources only.
+    # Option: +:static_workspace+ places stream context and destination buffer into single preallocated workspace.
     # Option: +:window_log_max+ size limit (power of 2).
     # Returns processed decompressor options.
     def self.get_decompressor_options(options, buffer_length_names)
@@ -250,7 +321,8 @@ module ZSTDS
 
       buffer_length_names.each { |name| Validation.validate_not_negative_integer options[name] }
 
-      Validation.validate_bool options[:gvl]
+      Validation.validate_gvl options[:gvl]
+      Validation.validate_bool options[:static_workspace]
 
       window_log_max = options[:window_log_max]
       unless window_log_max.nil?
@@ -261,5 +333,96 @@ module ZSTDS
 
       options
     end
+
+    # Processes string +options+.
+    # Option: +:destination_buffer_growth+ growth policy for destination buffer.
+    # Option: +:max_destination_buffer_growth+ maximum growth of destination buffer.
+    # Option: +:shrink_destination_buffer+ enables shrinking of destination buffer to result length.
+    # Option: +:gvl_threshold+ source length below which global VM lock won't be released in +:auto+ gvl mode.
+    # Option: +:slice_size+ source length compressed between interrupt checks, 0 disables slicing.
+    # Option: +:slice_yield+ enables switching to other threads between slices when global VM lock is enabled.
+    # Returns processed string options.
+    def self.get_string_options(options)
+      options = STRING_DEFAULTS.merge options
+
+      destination_buffer_growth = options[:destination_buffer_growth]
+      Validation.validate_symbol destination_buffer_growth
+      raise ValidateError, "invalid destination buffer growth" unless
+        DESTINATION_BUFFER_GROWTHS.include? destination_buffer_growth
+
+      Validation.validate_not_negative_integer options[:max_destination_buffer_growth]
+      Validation.validate_bool options[:shrink_destination_buffer]
+
+      gvl_threshold = options[:gvl_threshold]
+      unless gvl_threshold.nil?
+        Validation.validate_not_negative_integer gvl_threshold
+        raise ValidateError, "gvl threshold requires auto gvl mode" unless options[:gvl] == :auto
+      end
+
+      Validation.validate_not_negative_integer options[:slice_size]
+      Validation.validate_bool options[:slice_yield]
+
+      options
+    end
+
+    # Processes batch +options+.
+    # Option: +:batch_workers+ number of threads processing sources in parallel (including current thread).
+    # Returns processed batch options.
+    def self.get_batch_options(options)
+      options = BATCH_DEFAULTS.merge options
+
+      batch_workers = options[:batch_workers]
+      Validation.validate_not_negative_integer batch_workers
+      raise ValidateError, "invalid batch workers" if batch_workers > MAX_BATCH_WORKERS
+
+      options
+    end
+
+    # Processes parallel +options+.
+    # Option: +:parallel+ number of threads processing independent frames in parallel (including current thread).
+    # Option: +:parallel_frame_size+ decompressed size of each independent frame.
+    # Returns processed parallel options.
+    def self.get_parallel_options(options)
+      options = PARALLEL_DEFAULTS.merge options
+
+      parallel = options[:parallel]
+      Validation.validate_not_negative_integer parallel
+      raise ValidateError, "invalid parallel" if parallel > MAX_BATCH_WORKERS
+
+      Validation.validate_positive_integer options[:parallel_frame_size]
+
+      options
+    end
+
+    # Processes file +options+.
+    # Option: +:mmap+ enables mapping of regular files into memory.
+    # Option: +:pipeline+ enables reading and writing of files in separate threads.
+    # Returns processed file options.
+    def self.get_file_options(options)
+      options = FILE_DEFAULTS.merge options
+
+      Validation.validate_bool options[:mmap]
+      Validation.validate_bool options[:pipeline]
+
+      options
+    end
+
+    # Processes reference +options+ with reference option +name+, parallel options should be processed before.
+    # Option: +:reference+ reference string used as prefix for compressed frame.
+    # Option: +:reference_path+ reference file path used as prefix for compressed frame.
+    # Reference can't be used with parallel frames or dictionary.
+    # Returns processed reference options.
+    def self.get_reference_options(options, name)
+      options = { name => REFERENCE_DEFAULTS[name] }.merge options
+
+      reference = options[name]
+      return options if reference.nil?
+
+      Validation.validate_string reference
+      raise ValidateError, "invalid reference with parallel" unless options[:parallel].zero?
+      raise ValidateError, "invalid reference with dictionary" unless options[:dictionary].nil?
+
+      options
+    end
   end
 end
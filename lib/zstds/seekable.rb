@@ -0,0 +1,5 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require_relative "seekable/reader"
+require_relative "seekable/writer"
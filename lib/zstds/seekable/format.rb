@@ -0,0 +1,35 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+module ZSTDS
+  # Seekable format is compatible with "contrib/seekable_format" from zstd repository.
+  # Data is splitted into independent frames, seek table is appended as skippable frame.
+  # Regular decompressor ignores seek table, so result can be decompressed as usual.
+  module Seekable
+    # Magic number of skippable frame with seek table.
+    SKIPPABLE_MAGIC_NUMBER = 0x184D2A5E
+
+    # Magic number at the end of seek table.
+    SEEKABLE_MAGIC_NUMBER = 0x8F92EAB1
+
+    # Skippable frame header: magic number and frame size.
+    SKIPPABLE_HEADER_SIZE = 8
+
+    # Seek table footer: number of frames, descriptor and magic number.
+    FOOTER_SIZE = 9
+
+    # Seek table entry: compressed size, decompressed size and optional checksum.
+    ENTRY_SIZE          = 8
+    CHECKSUM_ENTRY_SIZE = 12
+
+    # Descriptor flags.
+    CHECKSUM_FLAG  = 0x80
+    RESERVED_FLAGS = 0x7C
+
+    # Maximum decompressed size of frame.
+    MAX_FRAME_SIZE = 1 << 30
+
+    # Maximum number of frames.
+    MAX_FRAMES_LENGTH = 1 << 27
+  end
+end
@@ -0,0 +1,192 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require_relative "../error"
+require_relative "../string"
+require_relative "../validation"
+require_relative "format"
+
+module ZSTDS
+  module Seekable
+    # ZSTDS::Seekable::Reader class.
+    # Reader decompresses only frames required for requested range.
+    class Reader
+      # Current decompressed position.
+      attr_reader :pos
+
+      # Total decompressed size.
+      attr_reader :size
+
+      # Initializes reader.
+      # Uses +io+ source with "seek" and "read" methods, "pread" will be used when available.
+      # Uses +options+ decompressor options for each frame.
+      def initialize(io, options = {})
+        raise ValidateError, "invalid io" unless io.respond_to?(:seek) && io.respond_to?(:read)
+
+        Validation.validate_hash options
+
+        @io      = io
+        @options = options
+        @pos     = 0
+
+        read_seek_table
+      end
+
+      # Returns number of frames.
+      def frames_length
+        @decompressed_offsets.length - 1
+      end
+
+      # Reads +length+ bytes from decompressed +offset+, current position won't be changed.
+      # Returns binary string, it will be shorter than +length+ at the end of data.
+      def pread(offset, length)
+        Validation.validate_not_negative_integer offset
+        Validation.validate_not_negative_integer length
+
+        result     = ::String.new :encoding => ::Encoding::BINARY
+        end_offset = [offset + length, @size].min
+
+        while offset < end_offset
+          frame_index = find_frame_index offset
+          frame       = read_frame frame_index
+          data        = frame.byteslice offset - @decompressed_offsets[frame_index], end_offset - offset
+
+          result << data
+          offset += data.bytesize
+        end
+
+        result
+      end
+
+      # Reads +length+ bytes (all remaining bytes by default) from current position.
+      # Returns nil at the end of data when +length+ is provided (same as IO).
+      def read(length = nil)
+        if length.nil?
+          length = @size > @pos ? @size - @pos : 0
+        else
+          Validation.validate_not_negative_integer length
+          return nil if length.positive? && @pos >= @size
+        end
+
+        result = pread @pos, length
+        @pos += result.bytesize
+
+        result
+      end
+
+      # Changes current position using +offset+ and +whence+ (same as IO).
+      def seek(offset, whence = ::IO::SEEK_SET)
+        Validation.validate_integer offset
+
+        case whence
+        when ::IO::SEEK_SET, :SET
+          position = offset
+        when ::IO::SEEK_CUR, :CUR
+          position = @pos + offset
+        when ::IO::SEEK_END, :END
+          position = @size + offset
+        else
+          raise ValidateError, "invalid whence"
+        end
+
+        raise ValidateError, "invalid offset" if position.negative?
+
+        @pos = position
+
+        0
+      end
+
+      # Sets current position to the start of data.
+      def rewind
+        @pos = 0
+      end
+
+      # Returns whether current position is at the end of data.
+      def eof?
+        @pos >= @size
+      end
+
+      protected def read_seek_table
+        @io.seek 0, ::IO::SEEK_END
+        io_size = @io.pos
+
+        raise_corrupted_seek_table if io_size < SKIPPABLE_HEADER_SIZE + FOOTER_SIZE
+
+        frames_length, descriptor, magic_number = read_io(io_size - FOOTER_SIZE, FOOTER_SIZE).unpack "VCV"
+        raise_corrupted_seek_table if magic_number != SEEKABLE_MAGIC_NUMBER || descriptor & RESERVED_FLAGS != 0
+
+        entry_size   = descriptor & CHECKSUM_FLAG == 0 ? ENTRY_SIZE : CHECKSUM_ENTRY_SIZE
+        entries_size = frames_length * entry_size
+        table_size   = entries_size + FOOTER_SIZE
+        table_offset = io_size - table_size - SKIPPABLE_HEADER_SIZE
+        raise_corrupted_seek_table if table_offset.negative?
+
+        header = read_io(table_offset, SKIPPABLE_HEADER_SIZE).unpack "VV"
+        raise_corrupted_seek_table if header != [SKIPPABLE_MAGIC_NUMBER, table_size]
+
+        entries = read_io table_offset + SKIPPABLE_HEADER_SIZE, entries_size
+
+        # Offsets have additional item with total size.
+        @compressed_offsets   = [0]
+        @decompressed_offsets = [0]
+
+        frames_length.times do |index|
+          compressed_size, decompressed_size = entries.byteslice(index * entry_size, ENTRY_SIZE).unpack "VV"
+
+          @compressed_offsets << (@compressed_offsets.last + compressed_size)
+          @decompressed_offsets << (@decompressed_offsets.last + decompressed_size)
+        end
+
+        raise_corrupted_seek_table if @compressed_offsets.last != table_offset
+
+        @size        = @decompressed_offsets.last
+        @frame_index = nil
+        @frame       = nil
+      end
+
+      # Frame with zero size can't contain any offset.
+      protected def find_frame_index(offset)
+        (0...frames_length).bsearch { |index| @decompressed_offsets[index + 1] > offset }
+      end
+
+      # Last frame is cached for sequential reading.
+      protected def read_frame(index)
+        return @frame if @frame_index == index
+
+        compressed_offset = @compressed_offsets[index]
+        compressed_frame  = read_io compressed_offset, @compressed_offsets[index + 1] - compressed_offset
+
+        frame = String.decompress compressed_frame, @options
+        if frame.bytesize != @decompressed_offsets[index + 1] - @decompressed_offsets[index]
+          raise DecompressorCorruptedSourceError, "invalid frame size"
+        end
+
+        @frame_index = index
+        @frame       = frame
+      end
+
+      protected def read_io(offset, length)
+        return ::String.new(:encoding => ::Encoding::BINARY) if length.zero?
+
+        if @io.respond_to? :pread
+          begin
+            data = @io.pread length, offset
+          rescue ::EOFError
+            data = nil
+          end
+        else
+          @io.seek offset
+          data = @io.read length
+        end
+
+        raise DecompressorCorruptedSourceError, "unexpected end of source" if data.nil? || data.bytesize != length
+
+        data
+      end
+
+      protected def raise_corrupted_seek_table
+        raise DecompressorCorruptedSourceError, "invalid seek table"
+      end
+    end
+  end
+end
@@ -0,0 +1,149 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require "zstds_ext"
+
+require_relative "../error"
+require_relative "../option"
+require_relative "../validation"
+require_relative "format"
+
+module ZSTDS
+  module Seekable
+    # ZSTDS::Seekable::Writer class.
+    class Writer
+      # Current native compressor class.
+      NativeCompressor = Stream::NativeCompressor
+
+      # Current writer defaults.
+      WRITER_DEFAULTS = {
+        # Maximum decompressed size of each frame.
+        :frame_size => 1 << 20
+      }
+      .freeze
+
+      # Initializes writer.
+      # Uses +io+ destination with "write" method.
+      # Option: +:frame_size+ maximum decompressed size of each frame.
+      # Option: +:destination_buffer_length+ destination buffer length.
+      # Other compressor options are supported except +:pledged_size+.
+      def initialize(io, options = {})
+        raise ValidateError, "invalid io" unless io.respond_to? :write
+
+        Validation.validate_hash options
+
+        options = WRITER_DEFAULTS.merge options
+
+        frame_size = options[:frame_size]
+        Validation.validate_positive_integer frame_size
+        raise ValidateError, "invalid frame size" if frame_size > MAX_FRAME_SIZE
+
+        options = Option.get_compressor_options options, %i[destination_buffer_length]
+        raise ValidateError, "pledged size is not supported" unless options[:pledged_size].nil?
+
+        @native_compressor = NativeCompressor.new options
+        @io                = io
+        @frame_size        = frame_size
+        @frames            = []
+
+        # Result buffer is reused for each result.
+        @result = ::String.new :encoding => ::Encoding::BINARY
+
+        reset_frame
+      end
+
+      # Writes +source+ string, frame is finished when it reaches frame size.
+      # Returns source bytesize.
+      def write(source)
+        do_not_use_after_close
+
+        Validation.validate_string source
+
+        source_offset = 0
+
+        while source_offset < source.bytesize
+          length = [@frame_size - @frame_decompressed_size, source.bytesize - source_offset].min
+          compress source, source_offset, length
+
+          source_offset            += length
+          @frame_decompressed_size += length
+
+          finish_frame if @frame_decompressed_size == @frame_size
+        end
+
+        source.bytesize
+      end
+
+      # Finishes last frame and writes seek table.
+      # Destination io won't be closed.
+      def close
+        return nil if closed?
+
+        finish_frame unless @frame_decompressed_size.zero?
+        write_seek_table
+
+        @native_compressor.close
+        @native_compressor = nil
+
+        nil
+      end
+
+      # Returns whether writer is closed.
+      def closed?
+        @native_compressor.nil?
+      end
+
+      protected def do_not_use_after_close
+        raise UsedAfterCloseError, "used after close" if closed?
+      end
+
+      protected def reset_frame
+        @frame_compressed_size   = 0
+        @frame_decompressed_size = 0
+      end
+
+      # Source part is compressed without slicing.
+      protected def compress(source, offset, length)
+        until length.zero?
+          bytes_written = @native_compressor.write_part source, offset, length
+          offset += bytes_written
+          length -= bytes_written
+
+          write_result if @native_compressor.needs_more_destination?
+        end
+      end
+
+      protected def finish_frame
+        raise ValidateError, "too many frames" if @frames.length == MAX_FRAMES_LENGTH
+
+        loop do
+          needs_more_destination = @native_compressor.finish
+          write_result
+
+          break unless needs_more_destination
+        end
+
+        # Next write will start new independent frame.
+        @frames << [@frame_compressed_size, @frame_decompressed_size]
+
+        reset_frame
+      end
+
+      protected def write_result
+        @native_compressor.read_result_into @result
+        return if @result.empty?
+
+        @io.write @result
+        @frame_compressed_size += @result.bytesize
+      end
+
+      protected def write_seek_table
+        entries = @frames.map { |sizes| sizes.pack "VV" }.join
+        footer  = [@frames.length, 0, SEEKABLE_MAGIC_NUMBER].pack "VCV"
+        table   = entries + footer
+
+        @io.write [SKIPPABLE_MAGIC_NUMBER, table.bytesize].pack("VV") + table
+      end
+    end
+  end
+end
@@ -29,6 +29,11 @@ module ZSTDS
 
           super options
         end
+
+        # Returns runtime stats hash of native compressor, it is available after close.
+        def stats
+          @native_stream.stats
+        end
       end
     end
   end
@@ -16,6 +16,11 @@ module ZSTDS
 
         # Current option class.
         Option = ZSTDS::Option
+
+        # Returns runtime stats hash of native decompressor, it is available after close.
+        def stats
+          @native_stream.stats
+        end
       end
     end
   end
@@ -11,6 +11,11 @@ module ZSTDS
     class Reader < ADSP::Stream::Reader
       # Current raw stream class.
       RawDecompressor = Raw::Decompressor
+
+      # Returns runtime stats hash of raw decompressor.
+      def stats
+        @raw_stream.stats
+      end
     end
   end
 end
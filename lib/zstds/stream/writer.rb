@@ -11,6 +11,11 @@ module ZSTDS
     class Writer < ADSP::Stream::Writer
       # Current raw stream class.
       RawCompressor = Raw::Compressor
+
+      # Returns runtime stats hash of raw compressor.
+      def stats
+        @raw_stream.stats
+      end
     end
   end
 end
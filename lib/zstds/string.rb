@@ -15,18 +15,92 @@ module ZSTDS
 
     # Compresses +source+ string using +options+.
     # Option: +:destination_buffer_length+ destination buffer length.
+    # Option: +:destination_buffer_growth+ growth policy for destination buffer.
+    # Option: +:max_destination_buffer_growth+ maximum growth of destination buffer.
+    # Option: +:shrink_destination_buffer+ enables shrinking of destination buffer to result length.
     # Option: +:pledged_size+ source bytesize.
+    # Option: +:slice_size+ source length compressed between interrupt checks, 0 disables slicing.
+    # Option: +:slice_yield+ enables switching to other threads between slices when global VM lock is enabled.
+    # Option: +:parallel+ number of threads compressing independent frames in parallel (including current thread).
+    # Option: +:parallel_frame_size+ decompressed size of each independent frame.
+    # Option: +:reference+ previous version of source, compressed string will contain only difference.
     # Returns compressed string.
     def self.compress(source, options = {})
       Validation.validate_string source
 
       options = Option.get_compressor_options options, BUFFER_LENGTH_NAMES
+      options = Option.get_string_options options
+      options = Option.get_parallel_options options
+      options = Option.get_reference_options options, :reference
 
       options[:pledged_size] = source.bytesize
 
       super source, options
     end
 
+    # Decompresses +source+ string using +options+.
+    # Option: +:destination_buffer_length+ destination buffer length.
+    # Option: +:destination_buffer_growth+ growth policy for destination buffer.
+    # Option: +:max_destination_buffer_growth+ maximum growth of destination buffer.
+    # Option: +:shrink_destination_buffer+ enables shrinking of destination buffer to result length.
+    # Option: +:parallel+ number of threads decompressing frames with content size in parallel.
+    # Option: +:reference+ same reference that was used for compression.
+    # Returns decompressed string.
+    def self.decompress(source, options = {})
+      Validation.validate_string source
+
+      options = Option.get_decompressor_options options, BUFFER_LENGTH_NAMES
+      options = Option.get_string_options options
+      options = Option.get_parallel_options options
+      options = Option.get_reference_options options, :reference
+
+      super source, options
+    end
+
+    # Compresses +sources+ array of strings using +options+.
+    # Options will be processed once for all sources.
+    # Option: +:shrink_destination_buffer+ enables shrinking of destination buffers to result length.
+    # Option: +:gvl_threshold+ total sources length below which global VM lock won't be released in +:auto+ gvl mode.
+    # Option: +:batch_workers+ number of threads processing sources in parallel (including current thread).
+    # Failed result will be nil when +errors+ array is provided, it will receive errors by index.
+    # Returns array of compressed strings.
+    def self.compress_batch(sources, options = {}, errors = nil)
+      validate_batch sources, errors
+
+      options = Option.get_compressor_options options, BUFFER_LENGTH_NAMES
+      options = Option.get_string_options options
+      options = Option.get_batch_options options
+
+      ZSTDS._native_compress_strings sources, options, errors
+    end
+
+    # Decompresses +sources+ array of strings using +options+.
+    # Options will be processed once for all sources.
+    # Option: +:destination_buffer_length+ destination buffer length for sources without content size.
+    # Option: +:shrink_destination_buffer+ enables shrinking of destination buffers to result length.
+    # Option: +:gvl_threshold+ total sources length below which global VM lock won't be released in +:auto+ gvl mode.
+    # Option: +:batch_workers+ number of threads processing sources in parallel (including current thread).
+    # Failed result will be nil when +errors+ array is provided, it will receive errors by index.
+    # Returns array of decompressed strings.
+    def self.decompress_batch(sources, options = {}, errors = nil)
+      validate_batch sources, errors
+
+      options = Option.get_decompressor_options options, BUFFER_LENGTH_NAMES
+      options = Option.get_string_options options
+      options = Option.get_batch_options options
+
+      ZSTDS._native_decompress_strings sources, options, errors
+    end
+
+    # Raises error when +sources+ is not an array of strings or +errors+ is not an array.
+    private_class_method def self.validate_batch(sources, errors)
+      raise ValidateError, "invalid sources" unless sources.is_a? ::Array
+
+      sources.each { |source| Validation.validate_string source }
+
+      raise ValidateError, "invalid errors" unless errors.nil? || errors.is_a?(::Array)
+    end
+
     # Bypasses native compress.
     def self.native_compress_string(*args)
       ZSTDS._native_compress_string(*args)
@@ -11,6 +11,11 @@ module ZSTDS
       raise ValidateError, "invalid bool" unless value.is_a?(::TrueClass) || value.is_a?(::FalseClass)
     end
 
+    # Raises error when +value+ is not boolean or +:auto+.
+    def self.validate_gvl(value)
+      raise ValidateError, "invalid gvl" unless value.is_a?(::TrueClass) || value.is_a?(::FalseClass) || value == :auto
+    end
+
     # Raises error when +value+ is not integer.
     def self.validate_integer(value)
       raise ValidateError, "invalid integer" unless value.is_a? ::Integer
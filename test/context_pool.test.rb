@@ -0,0 +1,71 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require "zstds/string"
+
+require_relative "common"
+require_relative "minitest"
+
+module ZSTDS
+  module Test
+    class ContextPool < Minitest::Test
+      Target = ZSTDS::ContextPool
+      String = ZSTDS::String
+
+      TEXTS = Common::TEXTS
+
+      STAT_NAMES = %i[
+        compressor_hits
+        compressor_misses
+        decompressor_hits
+        decompressor_misses
+      ]
+      .freeze
+
+      def test_stats
+        stats = Target.stats
+        assert_equal STAT_NAMES, stats.keys.sort
+
+        stats.each_value do |value|
+          assert_kind_of ::Integer, value
+          refute_predicate value, :negative?
+        end
+      end
+
+      def test_reuse
+        text = TEXTS.sample
+
+        # Warming up current thread.
+        String.decompress String.compress(text)
+
+        stats = Target.stats
+
+        decompressed_text = String.decompress String.compress(text)
+        decompressed_text.force_encoding text.encoding
+
+        assert_equal text, decompressed_text
+
+        new_stats = Target.stats
+        assert_operator new_stats[:compressor_hits], :>, stats[:compressor_hits]
+        assert_operator new_stats[:decompressor_hits], :>, stats[:decompressor_hits]
+      end
+
+      def test_clear
+        Target.clear
+
+        text = TEXTS.sample
+
+        Common.parallel [text] * Common::THREADS_COUNT do |item|
+          decompressed_text = String.decompress String.compress(item)
+          decompressed_text.force_encoding item.encoding
+
+          assert_equal item, decompressed_text
+        end
+
+        Target.clear
+      end
+    end
+
+    Minitest << ContextPool
+  end
+end
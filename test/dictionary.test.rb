@@ -1,7 +1,9 @@
 # Ruby bindings for zstd library.
 # Copyright (c) 2019 AUTHORS, MIT License.
 
+require "objspace"
 require "ocg"
+require "timeout"
 require "zstds/dictionary"
 require "zstds/string"
 
@@ -24,9 +26,10 @@ module ZSTDS
       )
       .freeze
 
-      TEXTS    = Common::TEXTS
-      CONTENTS = Common::DICTIONARY_CONTENTS
-      SAMPLES  = Common::DICTIONARY_SAMPLES
+      SOURCE_PATH = Common::SOURCE_PATH
+      TEXTS       = Common::TEXTS
+      CONTENTS    = Common::DICTIONARY_CONTENTS
+      SAMPLES     = Common::DICTIONARY_SAMPLES
 
       CAPACITIES = MAX_SIZES = [
         0,
@@ -66,6 +69,106 @@ module ZSTDS
             Target.train ["123"], :capacity => invalid_capacity
           end
         end
+
+        (Validation::TYPES + %i[legacy]).each do |invalid_algorithm|
+          next if invalid_algorithm.nil?
+
+          assert_raises ValidateError do
+            Target.train ["123"], :algorithm => invalid_algorithm
+          end
+        end
+
+        Validation::INVALID_NOT_NEGATIVE_INTEGERS.each do |invalid_integer|
+          %i[k d f steps accel].each do |name|
+            assert_raises ValidateError do
+              Target.train ["123"], :algorithm => :fast_cover, name => invalid_integer
+            end
+          end
+        end
+
+        (Validation::INVALID_NOT_NEGATIVE_INTEGERS + [0]).each do |invalid_nb_threads|
+          assert_raises ValidateError do
+            Target.train ["123"], :algorithm => :cover, :nb_threads => invalid_nb_threads
+          end
+        end
+
+        [nil, "0.5", -0.1, 1.1].each do |invalid_split_point|
+          assert_raises ValidateError do
+            Target.train ["123"], :algorithm => :cover, :split_point => invalid_split_point
+          end
+        end
+
+        [
+          { :algorithm => :cover, :k => 8, :d => 16 },
+          { :algorithm => :fast_cover, :f => Target::MAX_TRAIN_F + 1 },
+          { :algorithm => :fast_cover, :accel => Target::MAX_TRAIN_ACCEL + 1 },
+          { :k => 16 },
+          { :algorithm => :cover, :accel => 2 }
+        ]
+        .each do |invalid_options|
+          assert_raises ValidateError do
+            Target.train ["123"], invalid_options
+          end
+        end
+      end
+
+      def test_invalid_train_sources
+        Validation::INVALID_STRINGS.each do |invalid_string|
+          assert_raises ValidateError do
+            Target.train_concatenated invalid_string, [1]
+          end
+        end
+
+        Validation::INVALID_ARRAYS.each do |invalid_array|
+          assert_raises ValidateError do
+            Target.train_concatenated "123", invalid_array
+          end
+
+          assert_raises ValidateError do
+            Target.train_files invalid_array
+          end
+        end
+
+        [[0, 3], [1, 1], [4]].each do |invalid_sample_sizes|
+          assert_raises ValidateError do
+            Target.train_concatenated "123", invalid_sample_sizes
+          end
+        end
+
+        ([[]] + (Validation::INVALID_STRINGS + [""]).map { |invalid_path| [invalid_path] }).each do |invalid_paths|
+          assert_raises ValidateError do
+            Target.train_files invalid_paths
+          end
+        end
+
+        Validation::INVALID_NOT_NEGATIVE_INTEGERS.each do |invalid_capacity|
+          assert_raises ValidateError do
+            Target.train_files [SOURCE_PATH], :capacity => invalid_capacity
+          end
+        end
+
+        [nil, 1, "123"].each do |invalid_samples|
+          assert_raises ValidateError do
+            Target.train_each invalid_samples
+          end
+        end
+
+        (Validation::INVALID_STRINGS + [""]).each do |invalid_sample|
+          assert_raises ValidateError do
+            Target.train_each [invalid_sample]
+          end
+        end
+
+        (Validation::INVALID_NOT_NEGATIVE_INTEGERS + [0]).each do |invalid_max_samples_size|
+          assert_raises ValidateError do
+            Target.train_each ["123"], :max_samples_size => invalid_max_samples_size
+          end
+        end
+
+        # Reservoir without samples.
+        assert_raises ValidateError do
+          Target.train_each []
+        end
       end
 
       def test_invalid_finalize
@@ -166,6 +269,103 @@ module ZSTDS
         end
       end
 
+      def test_abandoned_training
+        samples = SAMPLES * 4
+
+        # Interrupted trainings keep running in background, their number is limited.
+        4.times do
+          Timeout.timeout(0.01) { Target.train samples, :algorithm => :cover }
+        rescue Timeout::Error
+          assert_operator GVL.abandoned_jobs, :<=, 2
+        end
+
+        dictionary = Target.train SAMPLES
+        process_dictionary dictionary
+      end
+
+      def test_train_concatenated
+        samples_buffer = SAMPLES.map(&:b).join
+        sample_sizes   = SAMPLES.map(&:bytesize)
+
+        dictionary = Target.train_concatenated samples_buffer, sample_sizes
+        process_dictionary dictionary
+
+        # Samples buffer is unlocked after training.
+        samples_buffer << "123"
+      end
+
+      def test_train_files
+        paths = SAMPLES.each_with_index.map do |sample, index|
+          path = Common.get_path SOURCE_PATH, "sample_#{index}"
+          ::File.write path, sample, :mode => "wb"
+          path
+        end
+
+        Common.parallel CAPACITIES do |capacity|
+          dictionary = Target.train_files paths, :capacity => capacity
+          process_dictionary dictionary
+        end
+
+        assert_raises AccessIOError do
+          Target.train_files paths + [Common.get_path(SOURCE_PATH, "missing")]
+        end
+      end
+
+      def test_train_each
+        dictionary = Target.train_each SAMPLES.each
+        process_dictionary dictionary
+
+        # Reservoir keeps random subset of samples.
+        samples          = SAMPLES.cycle.take SAMPLES.length * 4
+        max_samples_size = SAMPLES.map(&:bytesize).sum
+
+        dictionary = Target.train_each samples, :max_samples_size => max_samples_size
+        process_dictionary dictionary
+      end
+
+      def test_reservoir
+        max_samples_size = SAMPLES.map(&:bytesize).sum / 2
+        reservoir        = Target::Reservoir.new max_samples_size
+
+        SAMPLES.each { |sample| reservoir.add sample }
+
+        assert_equal SAMPLES.length, reservoir.received_samples_length
+        assert_predicate reservoir.samples_length, :positive?
+        assert reservoir.samples_length < SAMPLES.length
+        assert reservoir.samples_size <= max_samples_size
+
+        # Sample larger than max size is ignored.
+        refute reservoir.add("a" * (max_samples_size + 1))
+      end
+
+      def test_train_cover
+        options_generator = OCG.new(
+          :algorithm  => %i[cover fast_cover],
+          :d          => [0, 8],
+          :nb_threads => [1, 2]
+        )
+
+        Common.parallel_options options_generator do |options|
+          dictionary = Target.train SAMPLES, options.merge(:steps => 4)
+          process_dictionary dictionary
+
+          train_params = dictionary.train_params
+          assert_predicate train_params[:k], :positive?
+          assert_predicate train_params[:d], :positive?
+          assert_predicate train_params[:split_point], :positive?
+
+          assert_equal options[:d], train_params[:d] unless options[:d].zero?
+
+          if options[:algorithm] == :fast_cover
+            assert_predicate train_params[:f], :positive?
+            assert_predicate train_params[:accel], :positive?
+          end
+        end
+
+      rescue NotImplementedError
+        # Cover training may not be implemented.
+      end
+
       def test_finalize
         options_generator = OCG.new(
           :content  => CONTENTS,
@@ -195,6 +395,38 @@ module ZSTDS
       rescue NotImplementedError
         # Finalize may not be implemented.
       end
+
+      def test_digested
+        dictionary = Target.train SAMPLES
+
+        options_generator = OCG.new(
+          :compression_level => [nil, 1, ZSTDS::Option::MAX_COMPRESSION_LEVEL]
+        )
+        .or(
+          :hash_log => [ZSTDS::Option::MIN_HASH_LOG]
+        )
+
+        Common.parallel_options options_generator do |options|
+          text            = TEXTS.sample
+          compressed_text = String.compress text, options.merge(:dictionary => dictionary)
+
+          decompressed_text = String.decompress compressed_text, :dictionary => dictionary
+          decompressed_text.force_encoding text.encoding
+
+          assert_equal text, decompressed_text
+        end
+      end
+
+      def test_memsize
+        dictionary = Target.train SAMPLES
+        memsize    = ::ObjectSpace.memsize_of dictionary
+
+        String.compress TEXTS.sample, :dictionary => dictionary
+        String.decompress String.compress(TEXTS.sample, :dictionary => dictionary), :dictionary => dictionary
+
+        # Digested dictionaries are included.
+        assert ::ObjectSpace.memsize_of(dictionary) > memsize
+      end
     end
 
     Minitest << Dictionary
@@ -0,0 +1,148 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require "tmpdir"
+require "zstds/dictionary"
+require "zstds/dictionary_registry"
+require "zstds/string"
+
+require_relative "common"
+require_relative "minitest"
+require_relative "validation"
+
+module ZSTDS
+  module Test
+    class DictionaryRegistry < Minitest::Test
+      Target = ZSTDS::DictionaryRegistry
+      String = ZSTDS::String
+
+      TEXTS   = Common::TEXTS
+      SAMPLES = Common::DICTIONARY_SAMPLES
+
+      # Dictionaries with different samples will receive different ids.
+      DICTIONARIES = [1 << 12, 1 << 13, 1 << 14]
+        .map.with_index do |capacity, index|
+          samples = SAMPLES.map { |sample| "#{index}#{sample}" }
+          ZSTDS::Dictionary.train samples, :capacity => capacity
+        end
+        .freeze
+
+      def test_invalid_initialize
+        Validation::INVALID_HASHES.each do |invalid_options|
+          assert_raises ValidateError do
+            Target.new invalid_options
+          end
+        end
+
+        Validation::INVALID_NOT_NEGATIVE_INTEGERS.each do |invalid_integer|
+          assert_raises ValidateError do
+            Target.new :max_size => invalid_integer
+          end
+        end
+
+        registry = Target.new
+
+        assert_raises ValidateError do
+          registry.add "dictionary"
+        end
+
+        assert_raises ValidateError do
+          registry[-1]
+        end
+      end
+
+      def test_select
+        registry = Target.new
+        DICTIONARIES.each { |dictionary| registry << dictionary }
+
+        DICTIONARIES.each do |dictionary|
+          text            = TEXTS.sample
+          compressed_text = String.compress text, :dictionary => dictionary
+
+          assert_same dictionary, registry.frame_dictionary(compressed_text)
+
+          decompressed_text = registry.decompress compressed_text
+          decompressed_text.force_encoding text.encoding
+
+          assert_equal text, decompressed_text
+        end
+
+        # Frame without dictionary.
+        text = TEXTS.sample
+
+        decompressed_text = registry.decompress String.compress(text)
+        decompressed_text.force_encoding text.encoding
+
+        assert_equal text, decompressed_text
+
+        registry.delete DICTIONARIES.first.id
+
+        assert_raises CorruptedDictionaryError do
+          registry.decompress String.compress(text, :dictionary => DICTIONARIES.first)
+        end
+      end
+
+      def test_file
+        registry = Target.new
+        registry << DICTIONARIES.first
+
+        ::Dir.mktmpdir do |directory|
+          archive_path     = ::File.join directory, "archive"
+          destination_path = ::File.join directory, "destination"
+
+          text = TEXTS.sample
+          ::File.binwrite archive_path, registry.compress(text, DICTIONARIES.first.id)
+
+          registry.decompress_file archive_path, destination_path
+          assert_equal text.b, ::File.binread(destination_path)
+        end
+      end
+
+      def test_eviction
+        sizes    = DICTIONARIES.map { |dictionary| dictionary.buffer.bytesize + dictionary.digested_size }
+        registry = Target.new :max_size => sizes[1] + sizes[2]
+
+        DICTIONARIES.each { |dictionary| registry << dictionary }
+        assert_equal DICTIONARIES[1..].map(&:id), registry.ids
+
+        # Used dictionary becomes most recently used one.
+        registry[DICTIONARIES[1].id]
+        registry << DICTIONARIES[0]
+
+        assert_equal [DICTIONARIES[1].id, DICTIONARIES[0].id], registry.ids
+        assert_operator registry.memory_size, :<=, registry.max_size
+
+        # Digested dictionaries increase memory size, most recently used dictionary is kept.
+        registry.compress TEXTS.sample, DICTIONARIES[0].id
+
+        assert_operator DICTIONARIES[0].digested_size, :>, 0
+        assert_equal DICTIONARIES[0].id, registry.ids.last
+        assert registry.memory_size <= registry.max_size || registry.length == 1
+      end
+
+      def test_loader
+        loaded_ids = []
+
+        registry = Target.new do |id|
+          loaded_ids << id
+          DICTIONARIES.find { |dictionary| dictionary.id == id }
+        end
+
+        text            = TEXTS.sample
+        compressed_text = String.compress text, :dictionary => DICTIONARIES.last
+
+        2.times do
+          decompressed_text = registry.decompress compressed_text
+          decompressed_text.force_encoding text.encoding
+
+          assert_equal text, decompressed_text
+        end
+
+        assert_equal [DICTIONARIES.last.id], loaded_ids
+        assert_nil registry[1]
+      end
+    end
+
+    Minitest << DictionaryRegistry
+  end
+end
@@ -2,16 +2,341 @@
 # Copyright (c) 2019 AUTHORS, MIT License.
 
 require "adsp/test/file"
+require "io/nonblock"
+require "stringio"
+require "timeout"
+require "tmpdir"
 require "zstds/file"
 
 require_relative "minitest"
 require_relative "option"
+require_relative "scheduler"
 
 module ZSTDS
   module Test
     class File < ADSP::Test::File
       Target = ZSTDS::File
       Option = ZSTDS::Test::Option
+
+      TEXT = ("1111" * (1 << 16)).freeze
+
+      def test_pipes
+        source_reader, source_writer           = ::IO.pipe
+        destination_reader, destination_writer = ::IO.pipe
+
+        source_writer_thread = ::Thread.new do
+          source_writer.write TEXT
+          source_writer.close
+        end
+
+        destination_reader_thread = ::Thread.new { destination_reader.read }
+
+        Target.compress_io source_reader, destination_writer
+        destination_writer.close
+
+        source_writer_thread.join
+        compressed_text = destination_reader_thread.value
+
+        assert_equal TEXT, ZSTDS::String.decompress(compressed_text)
+
+        source_reader, source_writer           = ::IO.pipe
+        destination_reader, destination_writer = ::IO.pipe
+
+        source_writer_thread = ::Thread.new do
+          source_writer.write compressed_text
+          source_writer.close
+        end
+
+        destination_reader_thread = ::Thread.new { destination_reader.read }
+
+        Target.decompress_io source_reader, destination_writer
+        destination_writer.close
+
+        source_writer_thread.join
+        assert_equal TEXT, destination_reader_thread.value.force_encoding(TEXT.encoding)
+
+        assert_raises ValidateError do
+          Target.compress_io ::StringIO.new, destination_writer
+        end
+      end
+
+      def test_interrupt
+        # Blocked reading and writing should be interrupted for both blocking and non blocking pipes.
+        Option::BOOLS.each do |nonblock|
+          source_reader, source_writer = ::IO.pipe
+          source_reader.nonblock       = nonblock
+
+          ::File.open ::File::NULL, "wb" do |destination_io|
+            assert_raises ::Timeout::Error do
+              ::Timeout.timeout(0.1) { Target.compress_io source_reader, destination_io }
+            end
+          end
+
+          source_reader.close
+          source_writer.close
+
+          destination_reader, destination_writer = ::IO.pipe
+          destination_writer.nonblock            = nonblock
+
+          # Endless source will fill destination pipe, nobody reads it.
+          ::File.open "/dev/zero", "rb" do |source_io|
+            assert_raises ::Timeout::Error do
+              ::Timeout.timeout(0.1) { Target.compress_io source_io, destination_writer }
+            end
+          end
+
+          destination_reader.close
+          destination_writer.close
+        end
+      end
+
+      def test_pending_source
+        ::Dir.mktmpdir do |directory|
+          source_path  = ::File.join directory, "source"
+          archive_path = ::File.join directory, "archive"
+
+          ::File.write source_path, "#{TEXT}\n#{TEXT}"
+
+          ::File.open source_path, "rb" do |source_io|
+            # Data buffered by ruby IO can't be read from descriptor.
+            source_io.gets
+
+            assert_raises ValidateError do
+              ::File.open archive_path, "wb" do |archive_io|
+                Target.compress_io source_io, archive_io
+              end
+            end
+          end
+        end
+      end
+
+      def test_fiber_scheduler
+        skip "fiber scheduler is not available" unless ::Fiber.respond_to? :set_scheduler
+
+        source_reader, source_writer = ::IO.pipe
+        source_reader.nonblock       = true
+
+        chunk_length = 1 << 14
+        chunks       = TEXT.bytes.each_slice(chunk_length).map { |bytes| bytes.pack "C*" }
+
+        Dir.mktmpdir do |dir|
+          path          = ::File.join dir, "compressed"
+          written_order = []
+
+          thread = ::Thread.new do
+            ::Fiber.set_scheduler Scheduler.new
+
+            ::Fiber.schedule do
+              # Pipeline threads can't use scheduler, regular processing will be used.
+              ::File.open(path, "wb") { |file| Target.compress_io source_reader, file, :pipeline => true }
+              written_order << :compressed
+            end
+
+            # Compressor waits for source using scheduler, so this fiber can write source by chunks.
+            ::Fiber.schedule do
+              chunks.each do |chunk|
+                source_writer.write chunk
+                written_order << :chunk
+
+                sleep 0.001
+              end
+
+              source_writer.close
+            end
+          end
+
+          thread.join
+
+          assert_equal [:chunk] * chunks.length + [:compressed], written_order
+          assert_equal TEXT, ZSTDS::String.decompress(::File.binread(path))
+        end
+      end
+
+      def test_mmap
+        ::Dir.mktmpdir do |directory|
+          source_path      = ::File.join directory, "source"
+          archive_path     = ::File.join directory, "archive"
+          destination_path = ::File.join directory, "destination"
+
+          ::File.write source_path, TEXT
+
+          [true, false].each do |content_size_flag|
+            Target.compress source_path, archive_path, :mmap => true, :content_size_flag => content_size_flag
+            assert_equal TEXT, ZSTDS::String.decompress(::File.read(archive_path))
+
+            Target.decompress archive_path, destination_path, :mmap => true
+            assert_equal TEXT, ::File.read(destination_path)
+          end
+
+          # Pipe can't be mapped.
+          source_reader, source_writer = ::IO.pipe
+          source_writer.write ::File.binread(archive_path)
+          source_writer.close
+
+          ::File.open destination_path, "w+b" do |destination_io|
+            Target.decompress_io source_reader, destination_io, :mmap => true
+          end
+
+          assert_equal TEXT, ::File.read(destination_path)
+
+          assert_raises ValidateError do
+            Target.compress source_path, archive_path, :mmap => 1
+          end
+        end
+      end
+
+      def test_pipeline
+        ::Dir.mktmpdir do |directory|
+          source_path      = ::File.join directory, "source"
+          archive_path     = ::File.join directory, "archive"
+          destination_path = ::File.join directory, "destination"
+
+          ::File.write source_path, TEXT
+
+          [{}, { :source_buffer_length => 512, :destination_buffer_length => 512 }].each do |buffer_options|
+            options = buffer_options.merge :pipeline => true
+
+            Target.compress source_path, archive_path, options
+            assert_equal TEXT, ZSTDS::String.decompress(::File.read(archive_path))
+
+            Target.decompress archive_path, destination_path, options
+            assert_equal TEXT, ::File.read(destination_path)
+          end
+
+          # Writer thread should provide error.
+          destination_reader, destination_writer = ::IO.pipe
+          destination_reader.close
+
+          assert_raises WriteIOError do
+            ::File.open source_path, "rb" do |source_io|
+              Target.compress_io source_io, destination_writer, :pipeline => true
+            end
+          end
+
+          assert_raises ValidateError do
+            Target.compress source_path, archive_path, :pipeline => 1
+          end
+        end
+      end
+
+      def test_pipeline_interrupt
+        # Interrupt should cancel pipeline waiting for empty source or full destination.
+        source_reader, source_writer = ::IO.pipe
+
+        ::File.open ::File::NULL, "wb" do |destination_io|
+          assert_raises ::Timeout::Error do
+            ::Timeout.timeout(0.1) { Target.compress_io source_reader, destination_io, :pipeline => true }
+          end
+        end
+
+        source_reader.close
+        source_writer.close
+
+        destination_reader, destination_writer = ::IO.pipe
+
+        ::File.open "/dev/zero", "rb" do |source_io|
+          assert_raises ::Timeout::Error do
+            ::Timeout.timeout(0.1) { Target.compress_io source_io, destination_writer, :pipeline => true }
+          end
+        end
+
+        destination_reader.close
+        destination_writer.close
+      end
+
+      def test_parallel
+        ::Dir.mktmpdir do |directory|
+          source_path      = ::File.join directory, "source"
+          archive_path     = ::File.join directory, "archive"
+          destination_path = ::File.join directory, "destination"
+
+          ::File.write source_path, TEXT
+
+          [1, 4].each do |parallel|
+            options = { :parallel => parallel, :parallel_frame_size => 1 << 16 }
+
+            Target.compress source_path, archive_path, options
+            assert_equal ZSTDS::String.compress(TEXT, options), ::File.binread(archive_path)
+
+            [{}, { :source_buffer_length => 512, :destination_buffer_length => 512 }].each do |buffer_options|
+              Target.decompress archive_path, destination_path, options.merge(buffer_options)
+              assert_equal TEXT, ::File.read(destination_path)
+            end
+
+            # Frames without content size will be decompressed using streaming.
+            ::File.write archive_path, ZSTDS::String.compress(TEXT, :content_size_flag => false), :mode => "ab"
+
+            Target.decompress archive_path, destination_path, options
+            assert_equal TEXT * 2, ::File.read(destination_path)
+          end
+
+          # Large frame is decompressed using streaming, destination buffer keeps limited length.
+          large_text = "\0" * ((1 << 24) + 1)
+          ::File.binwrite archive_path, ZSTDS::String.compress(TEXT) + ZSTDS::String.compress(large_text)
+
+          Target.decompress archive_path, destination_path, :parallel => 4
+          assert_equal TEXT + large_text, ::File.binread(destination_path)
+
+          assert_raises ValidateError do
+            Target.compress source_path, archive_path, :parallel => -1
+          end
+        end
+      end
+
+      def test_reference
+        ::Dir.mktmpdir do |directory|
+          reference_path   = ::File.join directory, "reference"
+          source_path      = ::File.join directory, "source"
+          archive_path     = ::File.join directory, "archive"
+          destination_path = ::File.join directory, "destination"
+
+          reference = ::Array.new(10_000) { |index| "line #{index}\n" }.join
+          text      = reference.sub("line 5000\n", "changed line\n") + "last line\n"
+
+          ::File.write reference_path, reference
+          ::File.write source_path, text
+
+          [{}, { :mmap => true }, { :pipeline => true }].each do |options|
+            options = options.merge :reference_path => reference_path
+
+            Target.compress source_path, archive_path, options
+            assert_equal text, ZSTDS::String.decompress(::File.binread(archive_path), :reference => reference)
+
+            Target.decompress archive_path, destination_path, options
+            assert_equal text, ::File.read(destination_path)
+          end
+
+          # Decompressor window is limited unless window log max is provided.
+          # Source length is not known for pipe, so compressor writes required window into frame header.
+          source_reader, source_writer = ::IO.pipe
+          writer_thread = ::Thread.new do
+            source_writer.write text
+            source_writer.close
+          end
+
+          ::File.open archive_path, "wb" do |archive_io|
+            Target.compress_io source_reader, archive_io, :reference_path => reference_path, :window_log => 28
+          end
+
+          writer_thread.join
+          source_reader.close
+
+          assert_raises DecompressorCorruptedSourceError do
+            Target.decompress archive_path, destination_path, :reference_path => reference_path
+          end
+
+          Target.decompress archive_path, destination_path, :reference_path => reference_path, :window_log_max => 28
+          assert_equal text, ::File.read(destination_path)
+
+          assert_raises AccessIOError do
+            Target.compress source_path, archive_path, :reference_path => ::File.join(directory, "unknown")
+          end
+
+          assert_raises ValidateError do
+            Target.compress source_path, archive_path, :reference_path => reference_path, :parallel => 2
+          end
+        end
+      end
     end
 
     Minitest << File
@@ -167,6 +167,7 @@ module ZSTDS
 
         Validation::INVALID_BOOLS.each do |invalid_bool|
           yield({ :gvl => invalid_bool })
+          yield({ :static_workspace => invalid_bool })
         end
       end
 
@@ -243,6 +244,9 @@ module ZSTDS
         (Validation::INVALID_DICTIONARIES - [nil]).each do |invalid_dictionary|
           yield({ :dictionary => invalid_dictionary })
         end
+
+        yield({ :static_workspace => true, :nb_workers => 1 })
+        yield({ :static_workspace => true, :enable_long_distance_matching => true })
       end
 
       def self.get_invalid_decompressor_options(buffer_length_names, &block)
@@ -272,6 +276,12 @@ module ZSTDS
       ]
       .freeze
 
+      GVLS = [
+        *BOOLS,
+        :auto
+      ]
+      .freeze
+
       private_class_method def self.get_option_values(values, min, max)
         values.map { |value| value.clamp min, max }
       end
@@ -455,7 +465,7 @@ module ZSTDS
         end
 
         thread_generator = thread_generator.mix(
-          :gvl => BOOLS
+          :gvl => GVLS
         )
 
         # other
@@ -0,0 +1,77 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+module ZSTDS
+  module Test
+    # Minimal fiber scheduler based on IO.select.
+    class Scheduler
+      def initialize
+        @readable = {}
+        @writable = {}
+        @sleeping = {}
+        @ready    = []
+      end
+
+      def run
+        until @readable.empty? && @writable.empty? && @sleeping.empty? && @ready.empty?
+          readable, writable = ::IO.select @readable.keys, @writable.keys, [], timeout
+          readable&.each { |io| @readable.delete(io).resume }
+          writable&.each { |io| @writable.delete(io).resume }
+
+          time = current_time
+          @sleeping.select { |_fiber, wake_time| wake_time <= time }.each_key do |fiber|
+            @sleeping.delete fiber
+            fiber.resume
+          end
+
+          ready  = @ready
+          @ready = []
+          ready.each { |fiber| fiber.resume if fiber.alive? }
+        end
+      end
+
+      protected def timeout
+        return 0 unless @ready.empty?
+        return nil if @sleeping.empty?
+
+        [@sleeping.values.min - current_time, 0].max
+      end
+
+      protected def current_time
+        ::Process.clock_gettime ::Process::CLOCK_MONOTONIC
+      end
+
+      def io_wait(io, events, _timeout)
+        @readable[io] = ::Fiber.current if events.anybits? ::IO::READABLE
+        @writable[io] = ::Fiber.current if events.anybits? ::IO::WRITABLE
+        ::Fiber.yield
+
+        events
+      end
+
+      def kernel_sleep(duration = nil)
+        @sleeping[::Fiber.current] = current_time + (duration || 0)
+        ::Fiber.yield
+      end
+
+      def block(_blocker, timeout = nil)
+        kernel_sleep timeout || 0.01
+      end
+
+      def unblock(_blocker, fiber)
+        @ready << fiber
+      end
+
+      def fiber(&block)
+        fiber = ::Fiber.new :blocking => false, &block
+        fiber.resume
+
+        fiber
+      end
+
+      def close
+        run
+      end
+    end
+  end
+end
@@ -0,0 +1,93 @@
+# Ruby bindings for zstd library.
+# Copyright (c) 2019 AUTHORS, MIT License.
+
+require "stringio"
+require "zstds/file"
+require "zstds/seekable"
+require "zstds/string"
+
+require_relative "common"
+require_relative "minitest"
+
+module ZSTDS
+  module Test
+    class Seekable < Minitest::Test
+      Writer = ZSTDS::Seekable::Writer
+      Reader = ZSTDS::Seekable::Reader
+
+      ARCHIVE_PATH = Common::ARCHIVE_PATH
+      SOURCE_PATH  = Common::SOURCE_PATH
+
+      TEXT       = (0...10_000).map { |index| "line #{index}\n" }.join.freeze
+      FRAME_SIZE = 1000
+
+      def test_invalid_arguments
+        assert_raises ValidateError do
+          Writer.new nil
+        end
+
+        assert_raises ValidateError do
+          Writer.new ::StringIO.new, :frame_size => 0
+        end
+
+        assert_raises ValidateError do
+          Writer.new ::StringIO.new, :frame_size => ZSTDS::Seekable::MAX_FRAME_SIZE + 1
+        end
+
+        assert_raises ValidateError do
+          Reader.new nil
+        end
+
+        assert_raises DecompressorCorruptedSourceError do
+          Reader.new ::StringIO.new(TEXT)
+        end
+      end
+
+      def test_texts
+        ::File.open ARCHIVE_PATH, "wb" do |file|
+          writer = Writer.new file, :frame_size => FRAME_SIZE
+          TEXT.each_line { |line| writer.write line }
+          writer.close
+        end
+
+        # Seek table is skippable frame.
+        compressed_text = ::File.binread ARCHIVE_PATH
+        assert_equal TEXT, ZSTDS::String.decompress(compressed_text)
+
+        ZSTDS::File.decompress ARCHIVE_PATH, SOURCE_PATH
+        assert_equal TEXT, ::File.read(SOURCE_PATH)
+
+        ::File.open ARCHIVE_PATH, "rb" do |file|
+          [file, ::StringIO.new(compressed_text)].each do |io|
+            reader = Reader.new io
+            assert_equal TEXT.bytesize, reader.size
+            assert_equal TEXT.bytesize.fdiv(FRAME_SIZE).ceil, reader.frames_length
+
+            [[0, 10], [999, 2], [12_345, 5000], [TEXT.bytesize - 3, 10], [TEXT.bytesize, 1]].each do |offset, length|
+              assert_equal TEXT.byteslice(offset, length).to_s, reader.pread(offset, length)
+            end
+
+            reader.seek(-5, ::IO::SEEK_END)
+            assert_equal TEXT.byteslice(-5, 5), reader.read
+            assert_nil reader.read(1)
+            assert_predicate reader, :eof?
+
+            reader.rewind
+            assert_equal TEXT, reader.read
+          end
+        end
+      end
+
+      def test_empty
+        io = ::StringIO.new
+        Writer.new(io).close
+
+        reader = Reader.new ::StringIO.new(io.string)
+        assert_equal 0, reader.frames_length
+        assert_equal "", reader.read
+      end
+    end
+
+    Minitest << Seekable
+  end
+end
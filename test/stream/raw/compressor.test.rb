@@ -2,6 +2,9 @@
 # Copyright (c) 2019 AUTHORS, MIT License.
 
 require "adsp/test/stream/raw/compressor"
+require "objspace"
+require "stringio"
+require "tempfile"
 require "zstds/stream/raw/compressor"
 require "zstds/string"
 
@@ -16,6 +19,182 @@ module ZSTDS
           Target = ZSTDS::Stream::Raw::Compressor
           Option = Test::Option
           String = ZSTDS::String
+
+          NativeCompressor = ZSTDS::Stream::NativeCompressor
+
+          def test_read_result_into
+            text    = "1111" * 10_000
+            options = get_native_options :destination_buffer_length => 512
+
+            native_compressor = NativeCompressor.new options
+            result_buffer     = "previous result".dup
+            compressed_text   = ::String.new :encoding => ::Encoding::BINARY
+
+            loop do
+              bytes_written, needs_more_destination = native_compressor.write text
+              text = text.byteslice bytes_written, text.bytesize - bytes_written
+              compressed_text << native_compressor.read_result_into(result_buffer)
+
+              break unless needs_more_destination
+            end
+
+            loop do
+              needs_more_destination = native_compressor.finish
+              assert_same result_buffer, native_compressor.read_result_into(result_buffer)
+              compressed_text << result_buffer
+
+              break unless needs_more_destination
+            end
+
+            assert_equal ::Encoding::BINARY, result_buffer.encoding
+            assert_equal "1111" * 10_000, String.decompress(compressed_text)
+
+            native_compressor.close
+
+            assert_raises UsedAfterCloseError do
+              native_compressor.read_result_into result_buffer
+            end
+          end
+
+          def test_read_result_to
+            text              = "1111" * 10_000
+            options           = get_native_options
+            native_compressor = NativeCompressor.new options
+
+            ::Tempfile.create do |file|
+              file.binmode
+
+              native_compressor.write text
+              native_compressor.finish
+              bytes_written = native_compressor.read_result_to file
+
+              # Result is drained.
+              assert_equal 0, native_compressor.read_result_to(file)
+
+              file.rewind
+              compressed_text = file.read
+
+              assert_equal compressed_text.bytesize, bytes_written
+              assert_equal text, String.decompress(compressed_text)
+            end
+
+            assert_raises AccessIOError do
+              native_compressor.read_result_to ::StringIO.new
+            end
+          ensure
+            native_compressor.close
+          end
+
+          def test_write_part
+            text              = "1111" * 10_000
+            native_compressor = NativeCompressor.new get_native_options(:destination_buffer_length => 512)
+            compressed_text   = ::String.new :encoding => ::Encoding::BINARY
+            offset            = 0
+
+            while offset < text.bytesize
+              offset += native_compressor.write_part text, offset, text.bytesize - offset
+              compressed_text << native_compressor.read_result if native_compressor.needs_more_destination?
+            end
+
+            loop do
+              needs_more_destination = native_compressor.finish
+              compressed_text << native_compressor.read_result
+
+              break unless needs_more_destination
+            end
+
+            assert_equal text, String.decompress(compressed_text)
+
+            [[-1, 1], [0, text.bytesize + 1], [text.bytesize, 1]].each do |invalid_offset, invalid_length|
+              assert_raises ValidateError do
+                native_compressor.write_part text, invalid_offset, invalid_length
+              end
+            end
+
+            assert_equal 0, native_compressor.write_part(text, text.bytesize, 0)
+          ensure
+            native_compressor.close
+          end
+
+          def test_stats
+            text              = "1111" * 10_000
+            native_compressor = NativeCompressor.new get_native_options(:destination_buffer_length => 512)
+            compressed_text   = ::String.new :encoding => ::Encoding::BINARY
+            result_buffer     = ::String.new
+            offset            = 0
+
+            while offset < text.bytesize
+              offset += native_compressor.write_part text, offset, text.bytesize - offset
+              compressed_text << native_compressor.read_result_into(result_buffer)
+            end
+
+            loop do
+              needs_more_destination = native_compressor.finish
+              compressed_text << native_compressor.read_result_into(result_buffer)
+
+              break unless needs_more_destination
+            end
+
+            native_compressor.close
+
+            # Stats are available after close.
+            stats = native_compressor.stats
+
+            assert_equal text.bytesize, stats[:bytes_in]
+            assert_equal compressed_text.bytesize, stats[:bytes_out]
+            assert_equal 1, stats[:frames]
+            assert stats[:native_calls] >= 2
+            assert stats[:flushes] >= 1
+            assert stats[:string_resizes] >= 1
+            assert stats[:zstd_time] >= 0
+            assert stats[:gvl_released_time] >= 0
+          end
+
+          def test_memsize
+            native_compressor = NativeCompressor.new get_native_options(:compression_level => 19)
+            memsize           = ::ObjectSpace.memsize_of native_compressor
+
+            # Context allocates its workspace during first write.
+            native_compressor.write ::Random.new.bytes(1 << 20)
+            assert ::ObjectSpace.memsize_of(native_compressor) > memsize
+
+            native_compressor.close
+            assert ::ObjectSpace.memsize_of(native_compressor) < memsize
+          end
+
+          def test_static_workspace
+            text    = ::Random.new.bytes(1 << 16) * 4
+            options = get_native_options :static_workspace => true, :destination_buffer_length => 512
+
+            native_compressor = NativeCompressor.new options
+            memsize           = ::ObjectSpace.memsize_of native_compressor
+            compressed_text   = ::String.new :encoding => ::Encoding::BINARY
+            offset            = 0
+
+            while offset < text.bytesize
+              offset += native_compressor.write_part text, offset, text.bytesize - offset
+              compressed_text << native_compressor.read_result
+            end
+
+            loop do
+              needs_more_destination = native_compressor.finish
+              compressed_text << native_compressor.read_result
+
+              break unless needs_more_destination
+            end
+
+            # Workspace is allocated during initialization only.
+            assert_equal memsize, ::ObjectSpace.memsize_of(native_compressor)
+            assert_equal text, String.decompress(compressed_text)
+          rescue NotImplementedError
+            # Static workspace may not be implemented.
+          ensure
+            native_compressor&.close
+          end
+
+          protected def get_native_options(options = {})
+            ZSTDS::Option.get_compressor_options options, Target::BUFFER_LENGTH_NAMES
+          end
         end
 
         Minitest << Compressor
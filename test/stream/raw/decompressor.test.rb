@@ -2,6 +2,9 @@
 # Copyright (c) 2019 AUTHORS, MIT License.
 
 require "adsp/test/stream/raw/decompressor"
+require "objspace"
+require "stringio"
+require "tempfile"
 require "zstds/stream/raw/decompressor"
 require "zstds/string"
 
@@ -17,6 +20,8 @@ module ZSTDS
           Option = Test::Option
           String = ZSTDS::String
 
+          NativeDecompressor = ZSTDS::Stream::NativeDecompressor
+
           def test_invalid_read
             super
 
@@ -28,6 +33,124 @@ module ZSTDS
               decompressor.read corrupted_compressed_text, &NOOP_PROC
             end
           end
+
+          def test_read_result_into
+            text            = "1111" * 10_000
+            compressed_text = String.compress text
+            options         = get_native_options :destination_buffer_length => 512
+
+            native_decompressor = NativeDecompressor.new options
+            result_buffer       = ::String.new
+            decompressed_text   = ::String.new :encoding => ::Encoding::BINARY
+
+            until compressed_text.empty?
+              bytes_read, = native_decompressor.read compressed_text
+              compressed_text = compressed_text.byteslice bytes_read, compressed_text.bytesize - bytes_read
+              decompressed_text << native_decompressor.read_result_into(result_buffer)
+            end
+
+            decompressed_text << native_decompressor.read_result_into(result_buffer)
+            assert_equal text, decompressed_text
+
+            native_decompressor.close
+          end
+
+          def test_read_result_to
+            text                = "1111" * 100
+            options             = get_native_options
+            native_decompressor = NativeDecompressor.new options
+
+            ::Tempfile.create do |file|
+              native_decompressor.read String.compress(text)
+              assert_equal text.bytesize, native_decompressor.read_result_to(file)
+
+              file.rewind
+              assert_equal text, file.read
+            end
+
+            assert_raises AccessIOError do
+              native_decompressor.read_result_to ::StringIO.new
+            end
+          ensure
+            native_decompressor.close
+          end
+
+          def test_read_part
+            text                = "1111" * 10_000
+            compressed_text     = String.compress text
+            native_decompressor = NativeDecompressor.new get_native_options(:destination_buffer_length => 512)
+            decompressed_text   = ::String.new :encoding => ::Encoding::BINARY
+            offset              = 0
+
+            while offset < compressed_text.bytesize
+              offset += native_decompressor.read_part compressed_text, offset, compressed_text.bytesize - offset
+              decompressed_text << native_decompressor.read_result if native_decompressor.needs_more_destination?
+            end
+
+            decompressed_text << native_decompressor.read_result
+            assert_equal text, decompressed_text
+
+            assert_raises ValidateError do
+              native_decompressor.read_part compressed_text, 1, compressed_text.bytesize
+            end
+          ensure
+            native_decompressor.close
+          end
+
+          def test_stats
+            text                = "1111" * 10_000
+            compressed_text     = String.compress(text) * 2
+            native_decompressor = NativeDecompressor.new get_native_options(:destination_buffer_length => 512)
+            decompressed_text   = ::String.new :encoding => ::Encoding::BINARY
+            offset              = 0
+
+            loop do
+              offset += native_decompressor.read_part compressed_text, offset, compressed_text.bytesize - offset
+              decompressed_text << native_decompressor.read_result
+
+              break if offset == compressed_text.bytesize && !native_decompressor.needs_more_destination?
+            end
+
+            native_decompressor.close
+
+            stats = native_decompressor.stats
+
+            assert_equal text * 2, decompressed_text
+            assert_equal compressed_text.bytesize, stats[:bytes_in]
+            assert_equal decompressed_text.bytesize, stats[:bytes_out]
+            assert_equal 2, stats[:frames]
+            assert stats[:flushes] >= 1
+            assert_equal 0, stats[:string_resizes]
+          end
+
+          def test_static_workspace
+            text            = ::Random.new.bytes(1 << 16) * 4
+            compressed_text = String.compress text, :window_log => 20
+            options         = get_native_options :static_workspace => true, :window_log_max => 20
+
+            native_decompressor = NativeDecompressor.new options
+            memsize             = ::ObjectSpace.memsize_of native_decompressor
+            decompressed_text   = ::String.new :encoding => ::Encoding::BINARY
+            offset              = 0
+
+            loop do
+              offset += native_decompressor.read_part compressed_text, offset, compressed_text.bytesize - offset
+              decompressed_text << native_decompressor.read_result
+
+              break if offset == compressed_text.bytesize && !native_decompressor.needs_more_destination?
+            end
+
+            assert_equal memsize, ::ObjectSpace.memsize_of(native_decompressor)
+            assert_equal text, decompressed_text
+          rescue NotImplementedError
+            # Static workspace may not be implemented.
+          ensure
+            native_decompressor&.close
+          end
+
+          protected def get_native_options(options = {})
+            ZSTDS::Option.get_decompressor_options options, Target::BUFFER_LENGTH_NAMES
+          end
         end
 
         Minitest << Decompressor
@@ -17,6 +17,22 @@ module ZSTDS
         Option = Test::Option
         String = ZSTDS::String
 
+        def test_stats
+          text            = "1111" * 10_000
+          compressed_text = String.compress text
+          instance        = target.new ::StringIO.new(compressed_text)
+
+          assert_equal text, instance.read
+
+          stats = instance.stats
+
+          assert_equal compressed_text.bytesize, stats[:bytes_in]
+          assert_equal text.bytesize, stats[:bytes_out]
+          assert_equal 1, stats[:frames]
+        ensure
+          instance.close
+        end
+
         def test_invalid_read
           super
 
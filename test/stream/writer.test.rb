@@ -2,6 +2,7 @@
 # Copyright (c) 2019 AUTHORS, MIT License.
 
 require "adsp/test/stream/writer"
+require "stringio"
 require "zstds/stream/writer"
 require "zstds/string"
 
@@ -15,6 +16,21 @@ module ZSTDS
         Target = ZSTDS::Stream::Writer
         Option = Test::Option
         String = ZSTDS::String
+
+        def test_stats
+          text     = "1111" * 10_000
+          io       = ::StringIO.new
+          instance = target.new io
+
+          instance.write text
+          instance.close
+
+          stats = instance.stats
+
+          assert_equal text.bytesize, stats[:bytes_in]
+          assert_equal io.string.bytesize, stats[:bytes_out]
+          assert_equal 1, stats[:frames]
+        end
       end
 
       Minitest << Writer
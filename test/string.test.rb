@@ -2,6 +2,7 @@
 # Copyright (c) 2019 AUTHORS, MIT License.
 
 require "adsp/test/string"
+require "securerandom"
 require "zstds/string"
 
 require_relative "minitest"
@@ -20,6 +21,279 @@ module ZSTDS
           Target.decompress corrupted_compressed_text
         end
       end
+
+      def test_destination_buffer_growth
+        text = "1111" * 100_000
+
+        ZSTDS::Option::DESTINATION_BUFFER_GROWTHS.each do |destination_buffer_growth|
+          [true, false].each do |shrink_destination_buffer|
+            options = {
+              :destination_buffer_length     => 512,
+              :destination_buffer_growth     => destination_buffer_growth,
+              :max_destination_buffer_growth => 1 << 16,
+              :shrink_destination_buffer     => shrink_destination_buffer
+            }
+
+            compressed_text = Target.compress text, options
+            decompressed_text = Target.decompress compressed_text, options.merge(:window_log_max => 31)
+            assert_equal text, decompressed_text
+          end
+        end
+
+        [
+          [:destination_buffer_growth, :invalid_growth],
+          [:max_destination_buffer_growth, -1],
+          [:shrink_destination_buffer, nil]
+        ]
+        .each do |name, value|
+          assert_raises ValidateError do
+            Target.compress text, name => value
+          end
+
+          assert_raises ValidateError do
+            Target.decompress "", name => value
+          end
+        end
+      end
+
+      def test_gvl_threshold
+        text = "1111" * 1000
+
+        [0, text.bytesize + 1].each do |gvl_threshold|
+          compressed_text = Target.compress text, :gvl => :auto, :gvl_threshold => gvl_threshold
+          decompressed_text = Target.decompress compressed_text, :gvl => :auto, :gvl_threshold => gvl_threshold
+          assert_equal text, decompressed_text
+        end
+
+        assert_raises ValidateError do
+          Target.compress text, :gvl => :auto, :gvl_threshold => -1
+        end
+
+        # Global threshold should be between calibration bounds.
+        threshold = GVL.threshold
+
+        [GVL::MIN_THRESHOLD, GVL::MAX_THRESHOLD].each do |gvl_threshold|
+          GVL.threshold = gvl_threshold
+          assert_equal gvl_threshold, GVL.threshold
+        end
+
+        [-1, GVL::MIN_THRESHOLD - 1, GVL::MAX_THRESHOLD + 1].each do |gvl_threshold|
+          assert_raises ValidateError do
+            GVL.threshold = gvl_threshold
+          end
+        end
+
+        GVL.threshold = threshold
+        assert_equal threshold, GVL.threshold
+
+        # Threshold is used by auto mode only.
+        [false, true].each do |gvl|
+          assert_raises ValidateError do
+            Target.compress text, :gvl => gvl, :gvl_threshold => 0
+          end
+
+          assert_raises ValidateError do
+            Target.decompress "", :gvl => gvl, :gvl_threshold => 0
+          end
+        end
+      end
+
+      def test_gvl_auto
+        threshold = GVL.threshold
+        assert threshold.between?(GVL::MIN_THRESHOLD, GVL::MAX_THRESHOLD)
+
+        small_text = "1111"
+        large_text = small_text * threshold
+
+        [small_text, large_text].each do |text|
+          compressed_text = Target.compress text, :gvl => :auto
+          decompressed_text = Target.decompress compressed_text, :gvl => :auto
+          assert_equal text, decompressed_text
+        end
+
+        assert_raises ValidateError do
+          Target.compress small_text, :gvl => :manual
+        end
+      end
+
+      def test_slice
+        text = "1111" * 10_000
+
+        [0, 1, 1000].each do |slice_size|
+          Option::BOOLS.each do |slice_yield|
+            compressed_text = Target.compress(
+              text,
+              :slice_size                => slice_size,
+              :slice_yield               => slice_yield,
+              :gvl                       => slice_yield,
+              :destination_buffer_length => 100
+            )
+
+            assert_equal text, Target.decompress(compressed_text)
+          end
+        end
+
+        assert_raises ValidateError do
+          Target.compress text, :slice_size => -1
+        end
+
+        assert_raises ValidateError do
+          Target.compress text, :slice_yield => 1
+        end
+      end
+
+      def test_slice_interrupt
+        text   = "1111" * 100_000
+        thread = Thread.new { Target.compress text, :slice_size => 1, :gvl => true }
+
+        Thread.pass until thread.status == "run"
+        thread.raise Interrupt
+
+        assert_raises Interrupt do
+          thread.join
+        end
+      end
+
+      def test_batch
+        texts = Array.new(10) { |index| "1111" * (index * 100) }
+
+        compressed_texts = Target.compress_batch texts
+        assert_equal(texts, compressed_texts.map { |compressed_text| Target.decompress compressed_text })
+        assert_equal texts, Target.decompress_batch(compressed_texts)
+
+        corrupted_compressed_texts = compressed_texts.dup
+        corrupted_compressed_texts[1] = compressed_texts[1].reverse
+
+        assert_raises DecompressorCorruptedSourceError do
+          Target.decompress_batch corrupted_compressed_texts
+        end
+
+        errors             = []
+        decompressed_texts = Target.decompress_batch corrupted_compressed_texts, {}, errors
+
+        assert_nil decompressed_texts[1]
+        assert_kind_of DecompressorCorruptedSourceError, errors[1]
+        assert_equal texts.size, errors.size
+        assert_equal 1, errors.compact.size
+
+        assert_raises ValidateError do
+          Target.compress_batch [nil]
+        end
+      end
+
+      def test_batch_workers
+        texts = Array.new(100) { |index| "1111" * (index % 10 * 1000) }
+
+        [1, 4].each do |batch_workers|
+          compressed_texts = Target.compress_batch texts, :batch_workers => batch_workers
+          assert_equal texts, Target.decompress_batch(compressed_texts, :batch_workers => batch_workers)
+        end
+
+        assert_operator ZSTDS::ThreadPool.length, :>=, 3
+
+        assert_raises ValidateError do
+          Target.compress_batch texts, :batch_workers => ZSTDS::Option::MAX_BATCH_WORKERS + 1
+        end
+      end
+
+      def test_content_size
+        text = "1111" * 100_000
+
+        [true, false].each do |content_size_flag|
+          compressed_text = Target.compress text, :content_size_flag => content_size_flag
+          assert_equal text, Target.decompress(compressed_text)
+        end
+
+        compressed_text = Target.compress text
+
+        assert_raises DecompressorCorruptedSourceError do
+          Target.decompress compressed_text, :window_log_max => 10
+        end
+      end
+
+      def test_sliced_content_size
+        # Source is larger than default slice size.
+        text = ::SecureRandom.random_bytes 1 << 21
+
+        options = ZSTDS::Option.get_compressor_options({}, Target::BUFFER_LENGTH_NAMES)
+        options = ZSTDS::Option.get_string_options options
+        options = ZSTDS::Option.get_parallel_options options
+        options = ZSTDS::Option.get_reference_options options, :reference
+
+        # Native compressor should use source length when pledged size is not provided.
+        [Target.compress(text), ZSTDS._native_compress_string(text, options)].each do |compressed_text|
+          # Frame header descriptor contains content size flag and single segment flag.
+          frame_header_descriptor = compressed_text.getbyte 4
+          refute_equal 0, frame_header_descriptor >> 6
+          refute_equal 0, frame_header_descriptor & 0x20
+
+          assert_equal text, Target.decompress(compressed_text)
+        end
+      end
+
+      def test_parallel
+        text = "1111" * 100_000
+
+        [1, 4].each do |parallel|
+          options         = { :parallel => parallel, :parallel_frame_size => 1 << 16 }
+          compressed_text = Target.compress text, options
+
+          # Each frame is independent.
+          frames_text = (0...text.bytesize).step(1 << 16).map do |offset|
+            Target.compress text.byteslice(offset, 1 << 16)
+          end
+
+          assert_equal frames_text.join, compressed_text
+
+          assert_equal text, Target.decompress(compressed_text)
+          assert_equal text, Target.decompress(compressed_text, options)
+
+          # Frames without content size will be decompressed without parallel mode.
+          compressed_text = Target.compress(text, :content_size_flag => false) + compressed_text
+          assert_equal text * 2, Target.decompress(compressed_text, options)
+        end
+
+        assert_raises ValidateError do
+          Target.compress text, :parallel => ZSTDS::Option::MAX_BATCH_WORKERS + 1
+        end
+
+        assert_raises ValidateError do
+          Target.compress text, :parallel => 1, :parallel_frame_size => 0
+        end
+
+        # Native compressor validates frame size too.
+        options = ZSTDS::Option.get_compressor_options({}, Target::BUFFER_LENGTH_NAMES)
+        options = ZSTDS::Option.get_string_options options
+        options = ZSTDS::Option.get_parallel_options options
+        options = ZSTDS::Option.get_reference_options options, :reference
+
+        assert_raises ValidateError do
+          ZSTDS._native_compress_string text, options.merge(:parallel => 2, :parallel_frame_size => 0)
+        end
+      end
+
+      def test_reference
+        reference = ::Array.new(10_000) { |index| "line #{index}\n" }.join
+        text      = reference.sub("line 5000\n", "changed line\n") + "last line\n"
+
+        compressed_text = Target.compress text, :reference => reference
+        assert_operator compressed_text.bytesize, :<, Target.compress(text).bytesize / 10
+
+        assert_equal text, Target.decompress(compressed_text, :reference => reference)
+        assert_equal text, Target.decompress(compressed_text, :reference => reference, :window_log_max => 20)
+
+        assert_raises DecompressorCorruptedSourceError do
+          Target.decompress compressed_text
+        end
+
+        assert_raises ValidateError do
+          Target.compress text, :reference => 1
+        end
+
+        assert_raises ValidateError do
+          Target.compress text, :reference => reference, :parallel => 2
+        end
+      end
     end
 
     Minitest << String